@@ -0,0 +1,191 @@
+#pragma once
+
+#include "types.h"
+#include "index.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // Adaptive Radix Tree node kinds - inner nodes grow through these sizes
+    enum class ArtNodeType : uint8_t
+    {
+        NODE4,   // Up to 4 children, sorted key bytes
+        NODE16,  // Up to 16 children, sorted key bytes (SIMD searched)
+        NODE48,  // Up to 48 children, 256-entry byte -> slot map
+        NODE256, // One child pointer per possible byte
+        LEAF     // Full key plus the rows stored under it
+    };
+
+    // Base node - every inner node carries a compressed path (prefix)
+    struct ArtNode
+    {
+        ArtNodeType type;      // Which concrete node this is
+        uint16_t child_count;  // Children currently stored (inner nodes)
+        string prefix;         // Key bytes shared by everything below (path compression)
+
+        ArtNode(ArtNodeType type) : type(type), child_count(0) {}
+        virtual ~ArtNode() = default;
+    };
+
+    // Leaf node - stores the complete key so lookups can verify a match
+    struct ArtLeaf : public ArtNode
+    {
+        string key;                // Full encoded key
+        vector<TupleId> tuple_ids; // Rows with this key (duplicates allowed)
+
+        ArtLeaf(const string &key) : ArtNode(ArtNodeType::LEAF), key(key) {}
+    };
+
+    // Inner node shared fields - a key may also end exactly at an inner node
+    struct ArtInnerNode : public ArtNode
+    {
+        unique_ptr<ArtLeaf> terminal; // Leaf for a key that ends at this node (if any)
+
+        ArtInnerNode(ArtNodeType type) : ArtNode(type) {}
+    };
+
+    // Node4 - smallest inner node, linear search over sorted bytes
+    struct ArtNode4 : public ArtInnerNode
+    {
+        uint8_t keys[4];
+        unique_ptr<ArtNode> children[4];
+
+        ArtNode4() : ArtInnerNode(ArtNodeType::NODE4) {}
+    };
+
+    // Node16 - sorted bytes compared 16 at a time
+    struct ArtNode16 : public ArtInnerNode
+    {
+        uint8_t keys[16];
+        unique_ptr<ArtNode> children[16];
+
+        ArtNode16() : ArtInnerNode(ArtNodeType::NODE16) { fill(keys, keys + 16, 0); }
+    };
+
+    // Node48 - indirection table maps a byte to one of 48 child slots
+    struct ArtNode48 : public ArtInnerNode
+    {
+        uint8_t child_index[256]; // 0 = empty, otherwise slot + 1
+        unique_ptr<ArtNode> children[48];
+
+        ArtNode48() : ArtInnerNode(ArtNodeType::NODE48) { fill(child_index, child_index + 256, 0); }
+    };
+
+    // Node256 - direct array, one slot per byte value
+    struct ArtNode256 : public ArtInnerNode
+    {
+        unique_ptr<ArtNode> children[256];
+
+        ArtNode256() : ArtInnerNode(ArtNodeType::NODE256) {}
+    };
+
+    // AdaptiveRadixTree class - in-memory radix tree over binary-comparable keys
+    // Lookups walk one byte per level (skipping compressed prefixes), so the
+    // cost depends on key length rather than the number of keys, and nodes
+    // stay small because each level only allocates the fan-out it needs.
+    class AdaptiveRadixTree
+    {
+    private:
+        unique_ptr<ArtNode> root; // Root node (null while empty)
+        size_t entry_count;       // (key, tuple ID) pairs stored
+
+        // Find the child slot for a byte (nullptr if none)
+        static unique_ptr<ArtNode> *findChild(ArtInnerNode *node, uint8_t byte);
+
+        // Add a child, growing the node into the next size class when full
+        static void addChild(unique_ptr<ArtNode> &node_ref, uint8_t byte, unique_ptr<ArtNode> child);
+
+        // Remove the child stored under a byte (one findChild found), shrinking the node
+        // into the next smaller size class once it is sparse enough (node_ref may be replaced)
+        static void removeChild(unique_ptr<ArtNode> &node_ref, uint8_t byte);
+
+        // Replace an inner node left with one child and no terminal leaf by that child,
+        // folding the node's prefix and the child's byte into the child's prefix
+        static void collapseNode(unique_ptr<ArtNode> &node_ref);
+
+        // Hang a leaf below a new inner node (terminal if its key ends at depth)
+        static void attachLeaf(unique_ptr<ArtNode> &inner_ref, unique_ptr<ArtLeaf> leaf, size_t depth);
+
+        // Recursive insert below node_ref at key position depth
+        void insertRecursive(unique_ptr<ArtNode> &node_ref, const string &key, size_t depth, TupleId tuple_id);
+
+        // Recursive remove; empty leaves and childless inner nodes are unlinked, and
+        // single-child inner nodes are merged into their child
+        bool removeRecursive(unique_ptr<ArtNode> &node_ref, const string &key, size_t depth, TupleId tuple_id);
+
+        // Ordered traversal; path holds every key byte consumed to reach node
+        bool scanRecursive(ArtNode *node, string &path, const KeyRange &range, const IndexVisitor &visitor);
+
+        // Visit a leaf's rows if its key is inside the range
+        static bool visitLeaf(ArtLeaf *leaf, const KeyRange &range, const IndexVisitor &visitor);
+
+    public:
+        AdaptiveRadixTree() : entry_count(0) {}
+
+        // Add a key -> tuple ID mapping
+        void insert(const string &key, TupleId tuple_id);
+
+        // Remove one key -> tuple ID mapping (false if it isn't stored)
+        bool remove(const string &key, TupleId tuple_id);
+
+        // Rows stored under an exact key (nullptr if the key is absent)
+        const vector<TupleId> *search(const string &key) const;
+
+        // Visit keys inside the range in ascending order
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor);
+
+        // Largest key stored (nullptr while empty) - follows the last child down, so
+        // it costs one node per level
+        const string *maxKey() const;
+
+        size_t size() const { return entry_count; }
+    };
+
+    // ART index - exposes the radix tree through the Index interface
+    // Meant for tables that stay fully in memory and need very fast point lookups
+    class ArtIndex : public Index
+    {
+    private:
+        AdaptiveRadixTree tree;
+
+    public:
+        IndexType getType() const override { return IndexType::ART; }
+
+        void insert(const string &key, TupleId tuple_id) override { tree.insert(key, tuple_id); }
+
+        vector<TupleId> lookup(const string &key) override
+        {
+            auto tuple_ids = tree.search(key);
+            return tuple_ids ? *tuple_ids : vector<TupleId>{};
+        }
+
+        bool remove(const string &key, TupleId tuple_id) override { return tree.remove(key, tuple_id); }
+
+        bool isOrdered() const override { return true; }
+
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override
+        {
+            tree.scanRange(range, visitor);
+        }
+
+        bool lastKey(string &key) override
+        {
+            const string *last = tree.maxKey();
+            if (!last)
+            {
+                return false;
+            }
+            key = *last;
+            return true;
+        }
+
+        size_t size() const override { return tree.size(); }
+    };
+
+} // namespace db
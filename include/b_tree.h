@@ -4,6 +4,12 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <new>
+#include <map>
+#include <mutex>
+#include <condition_variable>
 #include <iostream>
 
 using namespace std;
@@ -11,165 +17,729 @@ using namespace std;
 namespace db
 {
 
+    // Slab allocator - hands out fixed-size objects carved from large slabs
+    // Building a tree costs one malloc per SLAB_OBJECTS nodes instead of several per
+    // node, and nodes sit next to each other in memory. Freed objects go on a free
+    // list and are reused before any new slab space.
+    template <typename T>
+    class SlabAllocator
+    {
+    private:
+        static constexpr size_t SLAB_OBJECTS = 256; // Objects per slab
+
+        // One object's storage - holds the free-list link while unused
+        union Slot
+        {
+            Slot *next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        vector<unique_ptr<Slot[]>> slabs; // Every slab allocated so far
+        size_t used_in_last_slab;         // Slots handed out from the newest slab
+        Slot *free_list;                  // Slots returned by destroy()
+
+    public:
+        SlabAllocator() : used_in_last_slab(SLAB_OBJECTS), free_list(nullptr) {}
+        SlabAllocator(const SlabAllocator &) = delete;
+        SlabAllocator &operator=(const SlabAllocator &) = delete;
+
+        // Construct an object in a free slot
+        template <typename... Args>
+        T *create(Args &&...args)
+        {
+            Slot *slot;
+            if (free_list)
+            {
+                slot = free_list; // Reuse a freed slot
+                free_list = free_list->next;
+            }
+            else
+            {
+                if (used_in_last_slab == SLAB_OBJECTS)
+                {
+                    slabs.emplace_back(new Slot[SLAB_OBJECTS]); // Newest slab is full
+                    used_in_last_slab = 0;
+                }
+                slot = &slabs.back()[used_in_last_slab++];
+            }
+            return new (slot->storage) T(forward<Args>(args)...);
+        }
+
+        // Destroy an object and keep its slot for the next create()
+        void destroy(T *object)
+        {
+            object->~T();
+            Slot *slot = reinterpret_cast<Slot *>(object);
+            slot->next = free_list;
+            free_list = slot;
+        }
+
+        // Bytes reserved by all slabs
+        size_t bytesReserved() const { return slabs.size() * SLAB_OBJECTS * sizeof(Slot); }
+    };
+
+    // Tree key whose bytes live in a KeyArena
+    // The first 8 bytes are copied into the key itself (big-endian), so most
+    // comparisons are settled inside the node without touching the arena.
+    struct ArenaKey
+    {
+        uint64_t prefix = 0;     // First 8 key bytes, zero padded
+        const char *data = nullptr; // All key bytes
+        uint32_t length = 0;     // Number of key bytes
+
+        // Key that refers to bytes owned by someone else (for searches)
+        static ArenaKey view(const char *bytes, size_t size)
+        {
+            ArenaKey key;
+            key.data = bytes;
+            key.length = static_cast<uint32_t>(size);
+            for (size_t i = 0; i < 8; i++)
+            {
+                key.prefix = (key.prefix << 8) | (i < size ? static_cast<uint8_t>(bytes[i]) : 0);
+            }
+            return key;
+        }
+
+        static ArenaKey view(const string &bytes) { return view(bytes.data(), bytes.size()); }
+
+        // Byte-wise comparison (same order as comparing the bytes as strings)
+        int compare(const ArenaKey &other) const
+        {
+            if (prefix != other.prefix)
+            {
+                return prefix < other.prefix ? -1 : 1;
+            }
+            int cmp = memcmp(data, other.data, min(length, other.length));
+            if (cmp != 0)
+            {
+                return cmp;
+            }
+            return length < other.length ? -1 : (length > other.length ? 1 : 0);
+        }
+
+        bool operator<(const ArenaKey &other) const { return compare(other) < 0; }
+        bool operator>(const ArenaKey &other) const { return compare(other) > 0; }
+        bool operator==(const ArenaKey &other) const { return compare(other) == 0; }
+    };
+
+    inline ostream &operator<<(ostream &out, const ArenaKey &key)
+    {
+        return out << string(key.data, key.length);
+    }
+
+    // Key arena - bump allocator for the bytes of ArenaKeys
+    // Keys are packed back to back in large blocks instead of one heap string each.
+    // Released bytes are only counted; once they outweigh the live bytes, the owner
+    // copies its keys into a fresh arena (see needsCompaction).
+    class KeyArena
+    {
+    private:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024; // Bytes per arena block
+
+        vector<unique_ptr<char[]>> blocks; // Every block allocated so far
+        size_t block_used;                 // Bytes used in the newest block
+        size_t live_bytes;                 // Bytes of keys still in use
+        size_t dead_bytes;                 // Bytes of released keys
+
+    public:
+        KeyArena() : block_used(BLOCK_SIZE), live_bytes(0), dead_bytes(0) {}
+        KeyArena(KeyArena &&) = default;
+        KeyArena &operator=(KeyArena &&) = default;
+
+        // Copy key bytes into the arena
+        ArenaKey store(const char *bytes, size_t size)
+        {
+            char *target;
+            if (size > BLOCK_SIZE / 4)
+            {
+                // Large key - give it its own block, keep filling the current one
+                blocks.emplace_back(new char[size]);
+                target = blocks.back().get();
+                if (blocks.size() > 1)
+                {
+                    swap(blocks[blocks.size() - 1], blocks[blocks.size() - 2]);
+                }
+            }
+            else
+            {
+                if (block_used + size > BLOCK_SIZE)
+                {
+                    blocks.emplace_back(new char[BLOCK_SIZE]);
+                    block_used = 0;
+                }
+                target = blocks.back().get() + block_used;
+                block_used += size;
+            }
+            memcpy(target, bytes, size);
+            live_bytes += size;
+            return ArenaKey::view(target, size);
+        }
+
+        ArenaKey store(const string &bytes) { return store(bytes.data(), bytes.size()); }
+
+        // Mark a stored key's bytes as no longer used
+        void release(const ArenaKey &key)
+        {
+            live_bytes -= key.length;
+            dead_bytes += key.length;
+        }
+
+        // Is most of the arena taken up by released keys?
+        bool needsCompaction() const { return dead_bytes > BLOCK_SIZE && dead_bytes > live_bytes; }
+
+        size_t liveBytes() const { return live_bytes; }
+    };
+
     // B-Tree Node class - represents one node in our balanced tree index
     // Template allows us to use different key types (int, string, etc.)
+    // Keys, values and child pointers are stored inline in fixed arrays, so a node
+    // is one allocation (from the tree's slab allocator) and its keys are contiguous.
     template <typename KeyType, typename ValueType>
     class BTreeNode
     {
     public:
         // B-Tree properties - these control the tree structure
-        static constexpr size_t MAX_KEYS = 4;            // Maximum 4 keys per node (Order 5 B-tree)
-        static constexpr size_t MIN_KEYS = MAX_KEYS / 2; // Minimum 2 keys per node (keeps balanced)
+        static constexpr size_t MIN_DEGREE = 16;               // t: nodes hold t-1 to 2t-1 keys (root may hold fewer)
+        static constexpr size_t MAX_KEYS = 2 * MIN_DEGREE - 1; // 31 keys per node
+        static constexpr size_t MIN_KEYS = MIN_DEGREE - 1;     // 15 keys per node (keeps balanced)
 
         // Data stored in each node
-        vector<KeyType> keys;                   // The sorted search keys (like indexes in a book)
-        vector<ValueType> values;               // Values associated with each key
-        vector<unique_ptr<BTreeNode>> children; // Pointers to child nodes (for internal nodes)
-        bool is_leaf;                           // Is this a leaf node (bottom level)?
+        KeyType keys[MAX_KEYS];               // The sorted search keys (like indexes in a book)
+        ValueType values[MAX_KEYS];           // Values associated with each key
+        BTreeNode *children[MAX_KEYS + 1];    // Child nodes (internal nodes only, owned by the tree)
+        uint64_t version;                     // Tree version that created this node (see BTree::snapshot)
+        uint16_t key_count;                   // Keys currently stored
+        bool is_leaf;                         // Is this a leaf node (bottom level)?
 
         // Constructor - creates a new B-tree node
-        BTreeNode(bool leaf = true) : is_leaf(leaf)
+        BTreeNode(bool leaf, uint64_t version) : version(version), key_count(0), is_leaf(leaf) {}
+
+        // Helper methods to check node state
+        bool isFull() const { return key_count >= MAX_KEYS; }     // Is node at capacity?
+        bool isMinimal() const { return key_count <= MIN_KEYS; } // Does node have minimum keys?
+
+        // Number of children of an internal node
+        size_t childCount() const { return is_leaf ? 0 : key_count + 1; }
+
+        // Insert a key/value pair at position pos, shifting later ones right
+        void insertEntry(size_t pos, KeyType key, ValueType value)
         {
-            keys.reserve(MAX_KEYS);         // Pre-allocate space for efficiency
-            values.reserve(MAX_KEYS);       // Avoid memory reallocations
-            children.reserve(MAX_KEYS + 1); // One more child than keys
+            move_backward(keys + pos, keys + key_count, keys + key_count + 1);
+            move_backward(values + pos, values + key_count, values + key_count + 1);
+            keys[pos] = move(key);
+            values[pos] = move(value);
+            key_count++;
         }
 
-        // Helper methods to check node state
-        bool isFull() const { return keys.size() >= MAX_KEYS; }    // Is node at capacity?
-        bool isMinimal() const { return keys.size() <= MIN_KEYS; } // Does node have minimum keys?
+        // Remove the key/value pair at position pos, shifting later ones left
+        void eraseEntry(size_t pos)
+        {
+            move(keys + pos + 1, keys + key_count, keys + pos);
+            move(values + pos + 1, values + key_count, values + pos);
+            key_count--;
+        }
+
+        // Insert a child pointer at position pos (call before key_count changes)
+        void insertChild(size_t pos, BTreeNode *child, size_t count)
+        {
+            move_backward(children + pos, children + count, children + count + 1);
+            children[pos] = child;
+        }
+
+        // Remove the child pointer at position pos from count children
+        void eraseChild(size_t pos, size_t count)
+        {
+            move(children + pos + 1, children + count, children + pos);
+        }
     };
 
     // B-Tree class - the main balanced tree data structure for indexing
+    // Snapshots: snapshot() freezes every current node and returns a refcounted
+    // handle to the current root. Writers never change a frozen node - they copy it
+    // (and so the path from the root down to it) the first time they touch it, and
+    // edit the copy in place from then on. A snapshot therefore keeps seeing the
+    // tree exactly as it was and can be read from other threads without locks.
+    // Nodes replaced while snapshots are open are retired with the current version
+    // (epoch) and freed once every snapshot older than that epoch is released.
+    // With no snapshot taken, writes cost one extra version comparison per node.
     template <typename KeyType, typename ValueType>
     class BTree
     {
     private:
-        unique_ptr<BTreeNode<KeyType, ValueType>> root; // Root node of the tree
+        using Node = BTreeNode<KeyType, ValueType>;
+
+        // Root shared by every handle to one snapshot (released with the last handle)
+        struct SnapshotRoot
+        {
+            BTree *tree;    // Tree the nodes belong to
+            Node *root;     // Root as of the snapshot
+            uint64_t epoch; // Version frozen by the snapshot
+
+            SnapshotRoot(BTree *tree, Node *root, uint64_t epoch) : tree(tree), root(root), epoch(epoch) {}
+            SnapshotRoot(const SnapshotRoot &) = delete;
+            ~SnapshotRoot() { tree->releaseSnapshot(epoch); }
+        };
+
+        // Node replaced while snapshots may still read it
+        struct RetiredNode
+        {
+            Node *node;     // Node to free
+            uint64_t epoch; // Version when it was replaced
+        };
+
+        SlabAllocator<Node> node_pool; // Storage for every node of this tree
+        Node *root;                    // Root node of the tree
+        uint64_t version;              // Version given to nodes created now
+        uint64_t frozen_version;       // Nodes with version <= this are frozen (0 = none)
+        vector<RetiredNode> retired;   // Replaced nodes waiting for snapshots to close
+        weak_ptr<SnapshotRoot> latest; // Most recent snapshot (reused until the next write)
+        bool modified;                 // Written since the latest snapshot?
+
+        // Open snapshot epochs -> handle count (released from reader threads)
+        mutex snapshot_mutex;
+        condition_variable snapshots_closed;
+        map<uint64_t, size_t> open_snapshots;
 
         // Helper method to create new nodes
-        unique_ptr<BTreeNode<KeyType, ValueType>> createNode(bool leaf = true)
+        Node *createNode(bool leaf = true)
         {
-            return make_unique<BTreeNode<KeyType, ValueType>>(leaf);
+            return node_pool.create(leaf, version);
         }
 
-        // Split a full child node - this maintains the balanced tree property
-        void splitChild(BTreeNode<KeyType, ValueType> *parent, size_t child_index)
+        // Node that writers may change in place (created after the last snapshot)?
+        bool isWritable(const Node *node) const { return node->version > frozen_version; }
+
+        // Return a node that is no longer part of the tree
+        void disposeNode(Node *node)
         {
-            auto child = move(parent->children[child_index]); // Get the full child
-            auto new_node = createNode(child->is_leaf);       // Create new node for split
+            if (isWritable(node))
+            {
+                node_pool.destroy(node); // No snapshot can see it
+            }
+            else
+            {
+                retired.push_back({node, version}); // Snapshots may still read it
+            }
+        }
 
-            // Find the middle key to promote up to parent
-            size_t mid = child->keys.size() / 2;         // Middle position
-            KeyType middle_key = child->keys[mid];       // Key to move up
-            ValueType middle_value = child->values[mid]; // Value to move up
+        // Make the node in slot safe to change - copies a frozen node and points the
+        // slot at the copy (the slot itself must belong to a writable node or be root)
+        Node *makeWritable(Node *&slot)
+        {
+            if (isWritable(slot))
+            {
+                return slot;
+            }
+            Node *copy = node_pool.create(*slot);
+            copy->version = version;
+            disposeNode(slot);
+            slot = copy;
+            return copy;
+        }
 
-            // Move keys and values after middle to the new node (right half)
-            for (size_t i = mid + 1; i < child->keys.size(); i++)
+        // Free retired nodes no open snapshot can reach, and unfreeze the tree once
+        // every snapshot is closed (called by writers before they change anything)
+        void reclaim()
+        {
+            if (retired.empty() && frozen_version == 0)
             {
-                new_node->keys.push_back(move(child->keys[i]));
-                new_node->values.push_back(move(child->values[i]));
+                return; // No snapshot since the last reclaim
             }
 
-            // If this is an internal node, also move the children
-            if (!child->is_leaf)
+            uint64_t oldest;
             {
-                for (size_t i = mid + 1; i < child->children.size(); i++)
+                lock_guard<mutex> lock(snapshot_mutex);
+                if (open_snapshots.empty())
+                {
+                    frozen_version = 0; // Only the live tree is left - edit it in place again
+                    oldest = UINT64_MAX;
+                }
+                else
                 {
-                    new_node->children.push_back(move(child->children[i]));
+                    oldest = open_snapshots.begin()->first;
                 }
             }
 
-            // Remove the moved keys/values from original child (keep left half)
-            child->keys.resize(mid); // Keep only left half
-            child->values.resize(mid);
+            // A node retired at epoch E is only reachable from snapshots older than E
+            size_t kept = 0;
+            for (const auto &entry : retired)
+            {
+                if (entry.epoch <= oldest)
+                {
+                    node_pool.destroy(entry.node);
+                }
+                else
+                {
+                    retired[kept++] = entry;
+                }
+            }
+            retired.resize(kept);
+        }
+
+        // Last handle to a snapshot dropped (any thread)
+        void releaseSnapshot(uint64_t epoch)
+        {
+            lock_guard<mutex> lock(snapshot_mutex);
+            auto it = open_snapshots.find(epoch);
+            if (--it->second == 0)
+            {
+                open_snapshots.erase(it);
+                snapshots_closed.notify_all();
+            }
+        }
+
+        // Called at the start of every write
+        void beginWrite()
+        {
+            reclaim();
+            modified = true;
+        }
+
+        // Return a subtree's nodes to the pool
+        void destroyRecursive(Node *node)
+        {
+            for (size_t i = 0; i < node->childCount(); i++)
+            {
+                destroyRecursive(node->children[i]);
+            }
+            node_pool.destroy(node);
+        }
+
+        // Position of the first key >= key in a node (binary search)
+        static size_t lowerBound(const Node *node, const KeyType &key)
+        {
+            return lower_bound(node->keys, node->keys + node->key_count, key) - node->keys;
+        }
+
+        // Position of the first key > key in a node
+        static size_t upperBound(const Node *node, const KeyType &key)
+        {
+            return upper_bound(node->keys, node->keys + node->key_count, key) - node->keys;
+        }
+
+        // Split a full child node - this maintains the balanced tree property
+        // (parent must be writable)
+        void splitChild(Node *parent, size_t child_index)
+        {
+            Node *child = makeWritable(parent->children[child_index]); // Get the full child
+            Node *new_node = createNode(child->is_leaf);                // Create new node for split
+
+            // Middle key moves up; keys (and children) after it move to the new node
+            size_t mid = Node::MIN_DEGREE - 1;
+            size_t right_count = child->key_count - mid - 1;
+            move(child->keys + mid + 1, child->keys + child->key_count, new_node->keys);
+            move(child->values + mid + 1, child->values + child->key_count, new_node->values);
             if (!child->is_leaf)
             {
-                child->children.resize(mid + 1); // Keep left children
+                copy(child->children + mid + 1, child->children + child->key_count + 1, new_node->children);
             }
+            new_node->key_count = static_cast<uint16_t>(right_count);
+            child->key_count = static_cast<uint16_t>(mid); // Keep only left half
 
             // Insert the middle key into parent at correct position
-            parent->keys.insert(parent->keys.begin() + child_index, move(middle_key));
-            parent->values.insert(parent->values.begin() + child_index, move(middle_value));
-            parent->children.insert(parent->children.begin() + child_index + 1, move(new_node));
+            parent->insertChild(child_index + 1, new_node, parent->key_count + 1);
+            parent->insertEntry(child_index, move(child->keys[mid]), move(child->values[mid]));
         }
 
-        // Insert key-value pair into a node that is not full
-        void insertNonFull(BTreeNode<KeyType, ValueType> *node, const KeyType &key, const ValueType &value)
+        // Insert key-value pair into a writable node that is not full
+        void insertNonFull(Node *node, const KeyType &key, const ValueType &value)
         {
-            int i = static_cast<int>(node->keys.size()) - 1; // Start from rightmost position
+            // Equal keys go after existing ones
+            size_t i = upperBound(node, key);
 
             if (node->is_leaf)
             {
-                // This is a leaf node - find correct position and insert directly
+                node->insertEntry(i, key, value); // Leaf node - insert directly
+                return;
+            }
 
-                // Shift elements right until we find correct insertion point
-                while (i >= 0 && key < node->keys[i])
+            // Internal node - if target child is full, split it first
+            if (node->children[i]->isFull())
+            {
+                splitChild(node, i); // Split the full child
+                if (node->keys[i] < key)
                 {
-                    i--; // Move left to find position
+                    i++; // Key goes to the right half
                 }
-                i++; // Move to insertion position
-
-                // Insert key and value at correct position
-                node->keys.insert(node->keys.begin() + i, key);
-                node->values.insert(node->values.begin() + i, value);
             }
-            else
+
+            // Recursively insert into the appropriate child
+            insertNonFull(makeWritable(node->children[i]), key, value);
+        }
+
+        // Search for a key in the subtree under node
+        static ValueType *searchRecursive(Node *node, const KeyType &key)
+        {
+            while (node)
             {
-                // This is an internal node - find correct child to insert into
-                // Find correct child to descend into
-                while (i >= 0 && key < node->keys[i])
+                size_t i = lowerBound(node, key);
+
+                // Check if we found exact match
+                if (i < node->key_count && !(key < node->keys[i]))
                 {
-                    i--; // Move left to find child
+                    return &node->values[i]; // Found it! Return pointer to value
                 }
-                i++; // Move to correct child index
 
-                // If target child is full, split it first
-                if (node->children[i]->isFull())
+                // If this is a leaf and we didn't find it, key doesn't exist
+                if (node->is_leaf)
                 {
-                    splitChild(node, i); // Split the full child
-                    if (key > node->keys[i])
-                    {        // Check if key goes to right split
-                        i++; // Move to right child after split
+                    return nullptr; // Not found
+                }
+
+                node = node->children[i]; // Continue search in appropriate child
+            }
+            return nullptr;
+        }
+
+        // Largest key in the subtree under node - follow the rightmost children down to
+        // a leaf (nullptr if the tree is empty)
+        static const KeyType *lastKeyIn(const Node *node)
+        {
+            while (!node->is_leaf)
+            {
+                node = node->children[node->key_count];
+            }
+            return node->key_count > 0 ? &node->keys[node->key_count - 1] : nullptr;
+        }
+
+        // In-order traversal limited to keys between low and high (nullptr = unbounded)
+        // Returns false once the scan should stop (past high or visitor asked to stop)
+        template <typename Visitor>
+        static bool scanRecursive(const Node *node,
+                                  const KeyType *low, bool low_inclusive,
+                                  const KeyType *high, bool high_inclusive, Visitor &visitor)
+        {
+            // Keys before start are below the range, and so is everything in their
+            // children - child i only holds keys <= keys[i]
+            size_t start = !low ? 0 : (low_inclusive ? lowerBound(node, *low) : upperBound(node, *low));
+
+            for (size_t i = start; i < node->key_count; i++)
+            {
+                if (!node->is_leaf)
+                {
+                    if (!scanRecursive(node->children[i], low, low_inclusive, high, high_inclusive, visitor))
+                    {
+                        return false;
                     }
                 }
 
-                // Recursively insert into the appropriate child
-                insertNonFull(node->children[i].get(), key, value);
+                // Everything after a key above the range is also above it
+                const KeyType &key = node->keys[i];
+                if (high && (high_inclusive ? *high < key : !(key < *high)))
+                {
+                    return false;
+                }
+
+                if (!visitor(key, node->values[i]))
+                {
+                    return false; // Visitor has seen enough
+                }
+            }
+
+            // Rightmost child holds the largest keys
+            if (!node->is_leaf)
+            {
+                return scanRecursive(node->children[node->key_count], low, low_inclusive, high, high_inclusive, visitor);
             }
+            return true;
         }
 
-        // Search for a key in the B-tree recursively
-        ValueType *searchRecursive(BTreeNode<KeyType, ValueType> *node, const KeyType &key)
+        // Make sure child i has more than MIN_KEYS keys before the delete descends into
+        // it, by borrowing from a sibling or merging with one (node must be writable)
+        // Returns the index of the child to descend into (a merge can shift it left)
+        size_t fillChild(Node *node, size_t i)
         {
-            if (!node)
-                return nullptr; // Key not found
+            if (node->children[i]->key_count > Node::MIN_KEYS)
+            {
+                return i; // Enough keys already
+            }
 
-            size_t i = 0;
-            // Find first key greater than or equal to search key
-            while (i < node->keys.size() && key > node->keys[i])
+            // Borrow from the left sibling - separator moves down, sibling's last key moves up
+            if (i > 0 && node->children[i - 1]->key_count > Node::MIN_KEYS)
             {
-                i++; // Move right through keys
+                Node *child = makeWritable(node->children[i]);
+                Node *left = makeWritable(node->children[i - 1]);
+                if (!child->is_leaf)
+                {
+                    child->insertChild(0, left->children[left->key_count], child->key_count + 1);
+                }
+                child->insertEntry(0, move(node->keys[i - 1]), move(node->values[i - 1]));
+                node->keys[i - 1] = move(left->keys[left->key_count - 1]);
+                node->values[i - 1] = move(left->values[left->key_count - 1]);
+                left->key_count--;
+                return i;
             }
 
-            // Check if we found exact match
-            if (i < node->keys.size() && key == node->keys[i])
+            // Borrow from the right sibling - the mirror image
+            if (i < node->key_count && node->children[i + 1]->key_count > Node::MIN_KEYS)
             {
-                return &node->values[i]; // Found it! Return pointer to value
+                Node *child = makeWritable(node->children[i]);
+                Node *right = makeWritable(node->children[i + 1]);
+                if (!child->is_leaf)
+                {
+                    child->children[child->key_count + 1] = right->children[0];
+                    right->eraseChild(0, right->key_count + 1);
+                }
+                child->insertEntry(child->key_count, move(node->keys[i]), move(node->values[i]));
+                node->keys[i] = move(right->keys[0]);
+                node->values[i] = move(right->values[0]);
+                right->eraseEntry(0);
+                return i;
+            }
+
+            // Both neighbours are small - merge with one of them around the separator
+            size_t left_index = (i < node->key_count) ? i : i - 1;
+            mergeChildren(node, left_index);
+            return left_index;
+        }
+
+        // Merge child i+1 and the separator key i into child i (node must be writable)
+        void mergeChildren(Node *node, size_t i)
+        {
+            Node *left = makeWritable(node->children[i]);
+            Node *right = node->children[i + 1]; // Only read, then dropped
+
+            size_t count = left->key_count;
+            left->keys[count] = move(node->keys[i]);
+            left->values[count] = move(node->values[i]);
+            copy(right->keys, right->keys + right->key_count, left->keys + count + 1);
+            copy(right->values, right->values + right->key_count, left->values + count + 1);
+            if (!left->is_leaf)
+            {
+                copy(right->children, right->children + right->key_count + 1, left->children + count + 1);
+            }
+            left->key_count = static_cast<uint16_t>(count + 1 + right->key_count);
+
+            node->eraseChild(i + 1, node->key_count + 1);
+            node->eraseEntry(i);
+            disposeNode(right);
+        }
+
+        // Remove one entry with this key from the subtree under a writable node - every
+        // node visited on the way down is first given a spare key, so removal never underflows
+        bool removeRecursive(Node *node, const KeyType &key)
+        {
+            size_t i = lowerBound(node, key); // First key >= search key
+
+            if (i < node->key_count && !(key < node->keys[i]))
+            {
+                if (node->is_leaf)
+                {
+                    node->eraseEntry(i); // Simple case - drop from leaf
+                    return true;
+                }
+
+                // Internal node - replace the key with its predecessor or successor
+                if (node->children[i]->key_count > Node::MIN_KEYS)
+                {
+                    const Node *pred = node->children[i];
+                    while (!pred->is_leaf)
+                    {
+                        pred = pred->children[pred->key_count];
+                    }
+                    node->keys[i] = pred->keys[pred->key_count - 1];
+                    node->values[i] = pred->values[pred->key_count - 1];
+                    return removeRecursive(makeWritable(node->children[i]), node->keys[i]);
+                }
+                if (node->children[i + 1]->key_count > Node::MIN_KEYS)
+                {
+                    const Node *succ = node->children[i + 1];
+                    while (!succ->is_leaf)
+                    {
+                        succ = succ->children[0];
+                    }
+                    node->keys[i] = succ->keys[0];
+                    node->values[i] = succ->values[0];
+                    return removeRecursive(makeWritable(node->children[i + 1]), node->keys[i]);
+                }
+
+                // Both neighbours are small - merge them and remove from the result
+                mergeChildren(node, i);
+                return removeRecursive(node->children[i], key);
             }
 
-            // If this is a leaf and we didn't find it, key doesn't exist
             if (node->is_leaf)
             {
-                return nullptr; // Not found
+                return false; // Key not in tree
             }
 
-            // Continue search in appropriate child
-            return searchRecursive(node->children[i].get(), key);
+            i = fillChild(node, i);
+            return removeRecursive(makeWritable(node->children[i]), key);
+        }
+
+        // Most keys a subtree of this height can hold (height 0 = a single leaf)
+        static size_t subtreeCapacity(size_t height)
+        {
+            size_t capacity = Node::MAX_KEYS;
+            for (size_t i = 0; i < height; i++)
+            {
+                capacity = capacity * (Node::MAX_KEYS + 1) + Node::MAX_KEYS;
+            }
+            return capacity;
+        }
+
+        // Build a subtree over sorted items[begin, end) whose leaves are all at depth height
+        // Each node gets as few children as will hold the keys (but at least MIN_DEGREE
+        // below the root), so nodes come out nearly full and never under MIN_KEYS
+        Node *buildSubtree(const vector<pair<KeyType, ValueType>> &items, size_t begin, size_t end,
+                           size_t height, bool is_root)
+        {
+            Node *node = createNode(height == 0);
+            size_t count = end - begin;
+            if (height == 0)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    node->keys[i] = items[begin + i].first;
+                    node->values[i] = items[begin + i].second;
+                }
+                node->key_count = static_cast<uint16_t>(count);
+                return node;
+            }
+
+            // One separator key between each pair of children, the rest split evenly
+            size_t child_capacity = subtreeCapacity(height - 1);
+            size_t children = (count + child_capacity + 1) / (child_capacity + 1);
+            children = max<size_t>(children, is_root ? 2 : Node::MIN_DEGREE);
+            size_t child_keys = count - (children - 1);
+
+            size_t pos = begin;
+            for (size_t c = 0; c < children; c++)
+            {
+                size_t size = child_keys / children + (c < child_keys % children ? 1 : 0);
+                node->children[c] = buildSubtree(items, pos, pos + size, height - 1, false);
+                pos += size;
+                if (c + 1 < children)
+                {
+                    node->keys[c] = items[pos].first;
+                    node->values[c] = items[pos].second;
+                    pos++;
+                }
+            }
+            node->key_count = static_cast<uint16_t>(children - 1);
+            return node;
+        }
+
+        // Call f on every key (in order) so the caller can rewrite it in place
+        template <typename KeyUpdater>
+        void updateKeysRecursive(Node *node, KeyUpdater &f)
+        {
+            for (size_t i = 0; i < node->key_count; i++)
+            {
+                if (!node->is_leaf)
+                {
+                    updateKeysRecursive(node->children[i], f);
+                }
+                f(node->keys[i]);
+            }
+            if (!node->is_leaf)
+            {
+                updateKeysRecursive(node->children[node->key_count], f);
+            }
         }
 
         // Debug method to print the tree structure (helpful for testing)
-        void printRecursive(BTreeNode<KeyType, ValueType> *node, int depth = 0)
+        void printRecursive(Node *node, int depth = 0)
         {
             if (!node)
                 return; // Nothing to print
@@ -178,48 +748,132 @@ namespace db
             cout << indent << "Node (leaf: " << node->is_leaf << "): ";
 
             // Print all keys in this node
-            for (size_t i = 0; i < node->keys.size(); i++)
+            for (size_t i = 0; i < node->key_count; i++)
             {
                 cout << node->keys[i] << " ";
             }
             cout << endl;
 
             // If this is an internal node, recursively print all children
-            if (!node->is_leaf)
+            for (size_t i = 0; i < node->childCount(); i++)
             {
-                for (auto &child : node->children)
-                {
-                    printRecursive(child.get(), depth + 1); // Print child with increased depth
-                }
+                printRecursive(node->children[i], depth + 1); // Print child with increased depth
             }
         }
 
     public:
+        // Read-only view of the tree as of one moment
+        // Copies share the same snapshot; the last copy to go releases it. Reading
+        // needs no lock, but the tree must outlive every snapshot of it.
+        class Snapshot
+        {
+        private:
+            shared_ptr<const SnapshotRoot> state;
+
+        public:
+            explicit Snapshot(shared_ptr<const SnapshotRoot> state) : state(move(state)) {}
+
+            // Search for a key and return pointer to its value (or nullptr if not found)
+            const ValueType *search(const KeyType &key) const
+            {
+                return searchRecursive(state->root, key);
+            }
+
+            // Visit key/value pairs in sorted order between low and high (nullptr = unbounded)
+            template <typename Visitor>
+            void scanRange(const KeyType *low, bool low_inclusive,
+                           const KeyType *high, bool high_inclusive, Visitor visitor) const
+            {
+                scanRecursive(state->root, low, low_inclusive, high, high_inclusive, visitor);
+            }
+
+            // Largest key (nullptr if the tree was empty)
+            const KeyType *lastKey() const { return lastKeyIn(state->root); }
+        };
+
         // Constructor - creates an empty B-tree with just a root node
-        BTree() : root(createNode()) {}
+        BTree() : version(1), frozen_version(0), modified(true) { root = createNode(); }
+
+        // Destructor - waits for open snapshots (held by other threads) to close,
+        // then returns every node to the pool so keys are destroyed
+        ~BTree()
+        {
+            {
+                unique_lock<mutex> lock(snapshot_mutex);
+                snapshots_closed.wait(lock, [&]
+                                      { return open_snapshots.empty(); });
+            }
+            reclaim();
+            destroyRecursive(root);
+        }
+
+        BTree(const BTree &) = delete;
+        BTree &operator=(const BTree &) = delete;
 
         // Main insert method - adds a key-value pair to the tree
         void insert(const KeyType &key, const ValueType &value)
         {
-            auto r = root.get(); // Get current root
+            beginWrite();
 
             // If root is full, we need to split it and create new root
-            if (r->isFull())
+            if (root->isFull())
             {
-                auto new_root = createNode(false);        // Create new internal root
-                new_root->children.push_back(move(root)); // Old root becomes child
-                root = move(new_root);                    // Update root pointer
-                splitChild(root.get(), 0);                // Split the old root
+                Node *new_root = createNode(false); // Create new internal root
+                new_root->children[0] = root;       // Old root becomes child
+                root = new_root;                    // Update root pointer
+                splitChild(root, 0);                // Split the old root
             }
 
             // Insert into the tree (now guaranteed root is not full)
-            insertNonFull(root.get(), key, value);
+            insertNonFull(makeWritable(root), key, value);
+        }
+
+        // Fill an empty tree from items sorted by key - builds the nodes bottom-up,
+        // which is much faster than inserting one by one and leaves them nearly full
+        // (a tree that already has keys just gets the items inserted)
+        void bulkLoad(const vector<pair<KeyType, ValueType>> &items)
+        {
+            if (root->key_count > 0)
+            {
+                for (const auto &item : items)
+                {
+                    insert(item.first, item.second);
+                }
+                return;
+            }
+
+            beginWrite();
+            size_t height = 0;
+            while (subtreeCapacity(height) < items.size())
+            {
+                height++;
+            }
+            disposeNode(root);
+            root = buildSubtree(items, 0, items.size(), height, true);
         }
 
         // Search for a key and return pointer to its value (or nullptr if not found)
         ValueType *search(const KeyType &key)
         {
-            return searchRecursive(root.get(), key);
+            return searchRecursive(root, key);
+        }
+
+        // Remove one entry with this key (returns false if the key isn't present)
+        // With duplicate keys any one of them may be removed, so callers that need
+        // to remove a specific entry should keep keys unique
+        bool remove(const KeyType &key)
+        {
+            beginWrite();
+            bool removed = removeRecursive(makeWritable(root), key);
+
+            // Root emptied by a merge - its only child becomes the new root
+            if (root->key_count == 0 && !root->is_leaf)
+            {
+                Node *old_root = root;
+                root = root->children[0];
+                disposeNode(old_root);
+            }
+            return removed;
         }
 
         // Check if a key exists in the tree (convenience method)
@@ -231,18 +885,79 @@ namespace db
         // Print the entire tree structure (for debugging and visualization)
         void print()
         {
-            printRecursive(root.get());
+            printRecursive(root);
+        }
+
+        // Visit key/value pairs in sorted order between low and high (nullptr = unbounded)
+        // Duplicate keys are all visited; the visitor returns false to stop early
+        template <typename Visitor>
+        void scanRange(const KeyType *low, bool low_inclusive,
+                       const KeyType *high, bool high_inclusive, Visitor visitor)
+        {
+            scanRecursive(root, low, low_inclusive, high, high_inclusive, visitor);
+        }
+
+        // Largest key in the tree, found in one root-to-leaf descent (nullptr if empty)
+        const KeyType *lastKey() const { return lastKeyIn(root); }
+
+        // Take a snapshot of the tree as it is now
+        // Must not run concurrently with writes (call it from the writer or under the
+        // same lock); the snapshot can then be read from any thread
+        Snapshot snapshot()
+        {
+            shared_ptr<SnapshotRoot> state = latest.lock();
+            if (state && !modified)
+            {
+                return Snapshot(state); // Nothing changed - share the open snapshot
+            }
+
+            frozen_version = version++; // Every existing node is now frozen
+            {
+                lock_guard<mutex> lock(snapshot_mutex);
+                open_snapshots[frozen_version]++;
+            }
+            state = make_shared<SnapshotRoot>(this, root, frozen_version);
+            latest = state;
+            modified = false;
+            return Snapshot(state);
         }
 
+        // Are any snapshots still open?
+        bool hasOpenSnapshots()
+        {
+            lock_guard<mutex> lock(snapshot_mutex);
+            return !open_snapshots.empty();
+        }
+
+        // Rewrite every stored key in place (the new key must compare equal to the old)
+        // Used to move keys into a new arena without rebuilding the tree. Snapshots
+        // read keys in place, so this returns false (and does nothing) while any are open
+        template <typename KeyUpdater>
+        bool updateKeys(KeyUpdater f)
+        {
+            beginWrite();
+            if (frozen_version != 0)
+            {
+                return false; // reclaim() found open snapshots
+            }
+            updateKeysRecursive(root, f);
+            return true;
+        }
+
+        // Bytes reserved for nodes
+        size_t nodeBytes() const { return node_pool.bytesReserved(); }
+
         // Range query - get all values for keys in range [start, end)
         // This is very efficient in B-trees due to sorted nature
         vector<ValueType> rangeQuery(const KeyType &start, const KeyType &end)
         {
             vector<ValueType> result; // Collect results here
-            // Implementation for range queries would traverse tree collecting values in range
-            // For now, simple implementation - full implementation would be recursive
+            scanRange(&start, true, &end, false, [&](const KeyType &, const ValueType &value)
+                      {
+                result.push_back(value);
+                return true; });
             return result;
         }
     };
 
-} // namespace db
\ No newline at end of file
+} // namespace db
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "types.h"
+#include "index.h"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // Compressed bitmap of tuple IDs (Roaring layout)
+    // IDs are split into a high part (id >> 16) and a 16-bit low part. Each high part
+    // owns one container for its 65536 possible low values, stored either as a sorted
+    // array (sparse: up to 4096 values) or as a 8KB bitset (dense). Set operations
+    // work container by container; bitset pairs are combined 128 bits at a time.
+    class RoaringBitmap
+    {
+    private:
+        static constexpr size_t ARRAY_MAX = 4096;   // Larger containers switch to a bitset
+        static constexpr size_t BITSET_WORDS = 1024; // 65536 bits
+
+        // Values sharing one high part
+        struct Container
+        {
+            vector<uint16_t> array; // Sorted low values (array form)
+            vector<uint64_t> bits;  // BITSET_WORDS words (bitset form, empty otherwise)
+            uint32_t cardinality = 0;
+
+            bool isBitset() const { return !bits.empty(); }
+            bool contains(uint16_t low) const;
+            bool add(uint16_t low);    // false if already present
+            bool remove(uint16_t low); // false if absent
+
+            // Pick the smaller representation for the current cardinality
+            void normalize();
+        };
+
+        vector<uint64_t> keys;        // High parts, ascending
+        vector<Container> containers; // containers[i] holds the values of keys[i]
+
+        // Position of a high part in keys (or where it would be inserted)
+        size_t findKey(uint64_t high) const;
+
+        // Container-level set operations
+        static Container andContainers(const Container &a, const Container &b);
+        static Container orContainers(const Container &a, const Container &b);
+        static Container andNotContainers(const Container &a, const Container &b);
+
+    public:
+        // Add an ID (false if it was already present)
+        bool add(TupleId id);
+
+        // Remove an ID (false if it was absent)
+        bool remove(TupleId id);
+
+        // Is this ID in the bitmap?
+        bool contains(TupleId id) const;
+
+        // Number of IDs stored
+        size_t cardinality() const;
+
+        bool empty() const { return keys.empty(); }
+
+        // IDs in both bitmaps
+        RoaringBitmap operator&(const RoaringBitmap &other) const;
+
+        // IDs in either bitmap
+        RoaringBitmap operator|(const RoaringBitmap &other) const;
+
+        // IDs in this bitmap but not in other (AND NOT)
+        RoaringBitmap andNot(const RoaringBitmap &other) const;
+
+        // IDs in any of the bitmaps - one pass over all of them, where a chain of |
+        // would copy the growing result once per bitmap
+        static RoaringBitmap unionAll(const vector<const RoaringBitmap *> &bitmaps);
+
+        // Visit every ID in ascending order; the visitor returns false to stop
+        template <typename Visitor>
+        void forEach(Visitor &&visitor) const
+        {
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                TupleId base = keys[i] << 16;
+                const Container &c = containers[i];
+                if (c.isBitset())
+                {
+                    for (size_t w = 0; w < BITSET_WORDS; w++)
+                    {
+                        for (uint64_t word = c.bits[w]; word != 0; word &= word - 1)
+                        {
+                            if (!visitor(base + w * 64 + __builtin_ctzll(word)))
+                                return;
+                        }
+                    }
+                }
+                else
+                {
+                    for (uint16_t low : c.array)
+                    {
+                        if (!visitor(base + low))
+                            return;
+                    }
+                }
+            }
+        }
+
+        // All IDs in ascending order
+        vector<TupleId> toVector() const;
+    };
+
+    // Bitmap index - one compressed bitmap of tuple IDs per distinct key
+    // Meant for low-cardinality columns (flags, small enums) where a tree gains
+    // little: predicates on several bitmap-indexed columns are answered by
+    // combining their bitmaps, then fetching only the surviving rows in ID order.
+    class BitmapIndex : public Index
+    {
+    private:
+        map<string, RoaringBitmap> bitmaps; // Key -> rows with that key (ordered for range scans)
+        size_t entry_count = 0;             // Total (key, tuple ID) entries
+
+    public:
+        IndexType getType() const override { return IndexType::BITMAP; }
+
+        void insert(const string &key, TupleId tuple_id) override;
+
+        vector<TupleId> lookup(const string &key) override;
+
+        bool remove(const string &key, TupleId tuple_id) override;
+
+        bool isOrdered() const override { return true; }
+
+        // Visits keys in order and, within a key, rows in ascending ID order
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override;
+
+        size_t size() const override { return entry_count; }
+
+        // Rows whose key falls in the range (the OR of their bitmaps)
+        RoaringBitmap rangeBitmap(const KeyRange &range) const;
+    };
+
+} // namespace db
@@ -96,8 +96,11 @@ namespace db
         // Load a page from disk into memory buffer
         void readPageFromDisk(PageId page_id, vector<uint8_t> &data)
         {
+            // Clear error flags left by an earlier short read (e.g. a brand new page)
+            db_file.clear();
+
             // Calculate byte offset: page_id * 4096 bytes per page
-            db_file.seekg(static_cast<streamoff>(page_id * PAGE_SIZE));
+            db_file.seekg(static_cast<streamoff>(page_id) * static_cast<streamoff>(PAGE_SIZE));
             // Read exactly 4096 bytes into our buffer
             db_file.read(reinterpret_cast<char *>(data.data()), PAGE_SIZE);
 
@@ -106,6 +109,7 @@ namespace db
             {
                 // Initialize new page with all zeros
                 fill(data.begin(), data.end(), 0);
+                db_file.clear(); // Keep the stream usable for the next read
             }
         }
 
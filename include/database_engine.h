@@ -55,6 +55,9 @@ namespace db
 
         // Query execution - SQL interface
         QueryResult executeQuery(const string &query); // Execute any SQL statement
+        void setVectorized(bool enabled);              // Batch (default) or row-at-a-time SELECT execution
+        void setWorkMemory(size_t bytes);              // Memory a sort or aggregation may use before spilling
+        void setParallelWorkers(size_t workers);       // Threads a full-table aggregation may use
 
         // Table operations - DDL (Data Definition Language)
         bool createTable(const string &name, const Schema &schema); // Create new table
@@ -71,7 +74,8 @@ namespace db
                          const vector<Value> &new_values);
 
         // Index operations - performance optimization
-        bool createIndex(const string &table_name, const string &column_name); // Create index for fast lookups
+        bool createIndex(const string &table_name, const string &column_name, // Create index for fast lookups
+                         IndexType type = IndexType::B_TREE);
 
         // Utility functions - monitoring and debugging
         void printStats();                             // Show database statistics
@@ -115,6 +119,9 @@ namespace db
 
         // Query execution - direct SQL interface
         QueryResult executeQuery(const string &query); // Execute raw SQL statement
+        void setVectorized(bool enabled);              // Batch (default) or row-at-a-time SELECT execution
+        void setWorkMemory(size_t bytes);              // Memory a sort or aggregation may use before spilling
+        void setParallelWorkers(size_t workers);       // Threads a full-table aggregation may use
 
         // Transaction support - ACID compliance
         bool begin();    // Start transaction
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "types.h"
+#include "row_batch.h"
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // Kinds of nodes in a WHERE expression tree
+    enum class ExprType
+    {
+        COMPARE, // column <op> value            (column <> value is NOT(column = value))
+        BETWEEN, // column BETWEEN low AND high  (both ends inclusive)
+        IN,      // column IN (value, ...)
+        IS_NULL, // column IS NULL               (IS NOT NULL is NOT(IS NULL))
+        AND,     // every child holds
+        OR,      // at least one child holds
+        NOT      // the single child does not hold
+    };
+
+    struct Expr;
+    using ExprPtr = shared_ptr<Expr>;
+
+    // Expr - one node of a parsed WHERE clause
+    // Leaves test one column against constants; AND / OR / NOT combine other nodes.
+    struct Expr
+    {
+        ExprType type = ExprType::COMPARE; // What this node tests
+        string column;                     // Column tested by a leaf node
+        CompareOp op = CompareOp::EQ;      // Operator of a COMPARE node
+        vector<Value> values;              // COMPARE: the constant, BETWEEN: low and high, IN: the list
+        vector<ExprPtr> children;          // Operands of AND / OR (two or more) and NOT (one)
+
+        // Leaf node: column <op> value
+        static ExprPtr compare(string column, CompareOp op, Value value)
+        {
+            auto expr = make_shared<Expr>();
+            expr->type = ExprType::COMPARE;
+            expr->column = move(column);
+            expr->op = op;
+            expr->values.push_back(move(value));
+            return expr;
+        }
+
+        // Inner node combining other expressions
+        static ExprPtr combine(ExprType type, vector<ExprPtr> children)
+        {
+            auto expr = make_shared<Expr>();
+            expr->type = type;
+            expr->children = move(children);
+            return expr;
+        }
+    };
+
+    // Collect the comparisons an index can use: leaves ANDed at the top of the tree
+    // (BETWEEN becomes >= and <=). Returns true when they say everything the
+    // expression does, so rows matching all of them need no further filtering.
+    bool extractConditions(const Expr &expr, vector<Condition> &conditions);
+
+    // Predicate compiled against a table schema, evaluated on a row's values
+    // Compiling resolves every column to its position and picks a comparison for the
+    // column's type once, so evaluating a row is a tree of direct typed comparisons -
+    // no column name lookups and no variant dispatch per row.
+    // A second, vectorized form tests a whole RowBatch: each comparison is one loop
+    // over a typed column array that narrows the batch's selection vector.
+    class CompiledPredicate
+    {
+    public:
+        using Evaluator = function<bool(const vector<Value> &row)>;
+
+        // Keeps the rows of selection (positions in the batch, increasing) that satisfy the node
+        using BatchEvaluator = function<void(const RowBatch &batch, vector<uint32_t> &selection)>;
+
+        CompiledPredicate() = default;
+
+        // Compile an expression - throws runtime_error for a column the schema lacks
+        static CompiledPredicate compile(const Expr &expr, const Schema &schema);
+
+        // Does a row (values in schema order) satisfy the expression?
+        bool operator()(const vector<Value> &row) const { return evaluator(row); }
+
+        // Drop the selected rows of a batch (columns in schema order) that don't satisfy it
+        void filter(const RowBatch &batch, vector<uint32_t> &selection) const { batch_evaluator(batch, selection); }
+
+        // Schema positions of every column the expression reads
+        const vector<int> &columnIds() const { return column_ids; }
+
+    private:
+        Evaluator evaluator;            // Root of the compiled closure tree
+        BatchEvaluator batch_evaluator; // Root of the vectorized closure tree
+        vector<int> column_ids;         // Columns read by the expression (no duplicates)
+
+        Evaluator compileNode(const Expr &expr, const Schema &schema);
+        BatchEvaluator compileBatchNode(const Expr &expr, const Schema &schema);
+    };
+
+} // namespace db
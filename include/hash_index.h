@@ -0,0 +1,127 @@
+#pragma once
+
+#include "types.h"
+#include "index.h"
+#include "buffer_pool.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // Header page of a hash index file - always stored on page 1
+    struct HashIndexHeader
+    {
+        uint32_t magic;          // Marks the file as a hash index
+        uint32_t global_depth;   // Hash bits used to pick a directory slot
+        uint32_t next_page_id;   // Next unused page in the index file
+        uint32_t directory_page; // First page of the directory chain
+        uint64_t entry_count;    // Total (key, tuple ID) entries stored
+    };
+
+    // Directory page header - the directory is a chain of these pages
+    struct HashDirectoryPageHeader
+    {
+        uint32_t next_page;  // Next directory page (0 if last)
+        uint32_t slot_count; // Directory slots stored on this page
+    };
+
+    // Bucket page header - every bucket page and overflow page starts with this
+    struct HashBucketHeader
+    {
+        uint32_t local_depth;   // Hash bits shared by every key in this bucket
+        uint32_t entry_count;   // Entries stored on this page
+        uint32_t used_bytes;    // Bytes used by entries after this header
+        uint32_t overflow_page; // Next page for keys that cannot be split apart (0 if none)
+    };
+
+    // Entry header - stored before the key bytes of every bucket entry
+    struct HashEntryHeader
+    {
+        uint32_t hash;       // Cached hash of the key (avoids rehashing on split)
+        uint32_t key_length; // Number of key bytes that follow
+        TupleId tuple_id;    // Row this key points to
+    };
+
+    // HashIndex class - disk-backed extendible hash index
+    // Equality lookups hash the key, pick a bucket through the directory and
+    // read a single page. Growth splits one bucket at a time, so inserts never
+    // pause to rehash the whole index.
+    class HashIndex : public Index
+    {
+    private:
+        static constexpr uint32_t MAGIC = 0x48494458;   // "HIDX"
+        static constexpr uint32_t MAX_GLOBAL_DEPTH = 24; // Caps the directory at 16M slots
+        static constexpr PageId HEADER_PAGE = 1;         // Page 0 is never used by BufferPool
+
+        unique_ptr<BufferPool> buffer_pool; // Caches index pages (evicts to the index file)
+        vector<PageId> directory;           // 2^global_depth slots -> bucket page
+        uint32_t global_depth;              // Current directory size as a power of two
+        PageId next_page_id;                // Page allocator for new buckets
+        PageId directory_page;              // First page of the on-disk directory chain
+        uint64_t entry_count;               // Entries stored across all buckets
+        vector<PageId> free_pages;          // Overflow pages released by bucket splits
+
+        // Stable hash of a key (must not change between runs - it is stored on disk)
+        static uint32_t hashKey(const string &key);
+
+        // Grab an unused page and initialize it as an empty bucket
+        PageId allocateBucket(uint32_t local_depth);
+
+        // Read every entry stored in a bucket and its overflow chain
+        void readBucket(PageId bucket_page, vector<pair<HashEntryHeader, string>> &entries);
+
+        // Rewrite a bucket chain so it holds exactly the given entries
+        void writeBucket(PageId bucket_page, uint32_t local_depth,
+                         const vector<pair<HashEntryHeader, string>> &entries);
+
+        // Split a full bucket into two buckets with one more hash bit each
+        void splitBucket(uint32_t slot);
+
+        // Double the directory so a bucket at global depth can be split
+        void doubleDirectory();
+
+        // Try to append an entry to a bucket chain (false if it needs a split)
+        bool appendToBucket(PageId bucket_page, const HashEntryHeader &entry,
+                            const string &key, bool allow_overflow);
+
+        // Persist header and directory pages
+        void writeHeader();
+
+    public:
+        // Create a fresh hash index stored in file_path (any old contents are discarded)
+        HashIndex(const string &file_path);
+
+        // Destructor - write directory and dirty pages to disk
+        ~HashIndex();
+
+        IndexType getType() const override { return IndexType::HASH; }
+
+        // Add a key -> row mapping (may split one bucket)
+        // Throws runtime_error for a key longer than maxKeySize (an entry never spans pages)
+        void insert(const string &key, TupleId tuple_id) override;
+
+        // Find all rows stored under an exact key - one bucket chain read
+        vector<TupleId> lookup(const string &key) override;
+
+        // Remove one key -> row mapping from its bucket chain
+        bool remove(const string &key, TupleId tuple_id) override;
+
+        bool isDiskBacked() const override { return true; }
+
+        // An entry (header and key) has to fit one bucket page
+        size_t maxKeySize() const override;
+
+        size_t size() const override { return entry_count; }
+
+        // Number of hash bits used by the directory
+        uint32_t getGlobalDepth() const { return global_depth; }
+
+        // Write header, directory and all dirty pages to disk
+        void flush();
+    };
+
+} // namespace db
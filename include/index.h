@@ -0,0 +1,554 @@
+#pragma once
+
+#include "types.h"
+#include "b_tree.h"
+#include "key_encoding.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // Range of encoded keys for ordered index scans
+    struct KeyRange
+    {
+        string low;                 // Lower bound (only used when has_low is set)
+        string high;                // Upper bound (only used when has_high is set)
+        bool has_low = false;       // Is the range bounded below?
+        bool has_high = false;      // Is the range bounded above?
+        bool low_inclusive = true;  // Does the range include low itself?
+        bool high_inclusive = true; // Does the range include high itself?
+
+        // Range holding a single key
+        static KeyRange exact(const string &key)
+        {
+            KeyRange range;
+            range.low = range.high = key;
+            range.has_low = range.has_high = true;
+            return range;
+        }
+
+        // Is the key at or above the lower bound?
+        bool aboveLow(const string &key) const
+        {
+            return !has_low || (low_inclusive ? key >= low : key > low);
+        }
+
+        // Is the key at or below the upper bound?
+        bool belowHigh(const string &key) const
+        {
+            return !has_high || (high_inclusive ? key <= high : key < high);
+        }
+
+        // Does the range contain this key?
+        bool contains(const string &key) const { return aboveLow(key) && belowHigh(key); }
+    };
+
+    // Callback for ordered scans - receives each key and row, returns false to stop
+    using IndexVisitor = function<bool(const string &key, TupleId tuple_id)>;
+
+    // Human-readable name of an index type (for statistics output)
+    string indexTypeName(IndexType type);
+
+    // Does an index of this type keep its keys in order (i.e. will isOrdered() hold)?
+    bool indexTypeIsOrdered(IndexType type);
+
+    // Index interface - the operations every index structure must support
+    // Tables and the index manager only talk to indexes through this class
+    class Index
+    {
+    public:
+        virtual ~Index() = default;
+
+        // Which data structure backs this index
+        virtual IndexType getType() const = 0;
+
+        // Add a key -> row mapping to the index
+        virtual void insert(const string &key, TupleId tuple_id) = 0;
+
+        // Find all rows stored under an exact key
+        virtual vector<TupleId> lookup(const string &key) = 0;
+
+        // Remove one key -> row mapping (false if it wasn't in the index)
+        virtual bool remove(const string &key, TupleId tuple_id) = 0;
+
+        // Does this index keep keys sorted (so range scans are possible)?
+        virtual bool isOrdered() const { return false; }
+
+        // Longest key (in bytes) the index can store - tables refuse rows whose key for
+        // some index would be longer, before anything is written
+        virtual size_t maxKeySize() const { return SIZE_MAX; }
+
+        // Does this index keep its entries in pages on disk?
+        // Tables put a change buffer in front of these (random page writes are costly)
+        virtual bool isDiskBacked() const { return false; }
+
+        // Visit entries whose keys fall in the range, in ascending key order
+        // Only ordered indexes support this - check isOrdered() first
+        virtual void scanRange(const KeyRange &range, const IndexVisitor &visitor)
+        {
+            (void)range;
+            (void)visitor;
+            throw runtime_error(indexTypeName(getType()) + " index does not support range scans");
+        }
+
+        // Largest key in the index (false if it is empty) - the smallest is the first key
+        // scanRange visits. Only ordered indexes support this; this version walks every
+        // entry, indexes that can reach their last key directly override it.
+        virtual bool lastKey(string &key)
+        {
+            bool found = false;
+            scanRange(KeyRange(), [&](const string &entry_key, TupleId)
+                      {
+                key = entry_key;
+                found = true;
+                return true; });
+            return found;
+        }
+
+        // Number of key -> row entries stored in the index
+        virtual size_t size() const = 0;
+
+        // Add entries sorted by key, then tuple ID, to an empty index (used to reload
+        // index snapshot files) - types that can build straight from sorted input override it
+        virtual void bulkLoad(const vector<pair<string, TupleId>> &entries)
+        {
+            for (const auto &entry : entries)
+            {
+                insert(entry.first, entry.second);
+            }
+        }
+
+        // Read-only copy of the index as it is now, which later writes don't change
+        // and which can be read without the table latch (nullptr = not supported)
+        // Call it like a write (under the table latch); the index must outlive it
+        virtual unique_ptr<Index> snapshot() { return nullptr; }
+    };
+
+    // B-tree index - wraps the in-memory BTree template behind the Index interface
+    // Each tree key is the index key followed by the 8-byte big-endian tuple ID.
+    // That keeps tree keys unique (so one row's entry can be removed) while every
+    // entry for an index key stays contiguous, ordered by tuple ID.
+    // Tree key bytes are packed into a KeyArena rather than one string per entry.
+    class BTreeIndex : public Index
+    {
+    private:
+        static constexpr size_t SUFFIX_SIZE = sizeof(TupleId);
+
+        using Tree = BTree<ArenaKey, TupleId>;
+
+        // Read-only view returned by snapshot()
+        class Snapshot : public Index
+        {
+        private:
+            Tree::Snapshot tree; // Tree as of the snapshot
+            size_t entry_count;  // Entries at that time
+
+        public:
+            Snapshot(Tree::Snapshot tree, size_t entry_count) : tree(move(tree)), entry_count(entry_count) {}
+
+            IndexType getType() const override { return IndexType::B_TREE; }
+
+            void insert(const string &, TupleId) override
+            {
+                throw runtime_error("Index snapshots are read-only");
+            }
+
+            bool remove(const string &, TupleId) override
+            {
+                throw runtime_error("Index snapshots are read-only");
+            }
+
+            vector<TupleId> lookup(const string &key) override { return lookupIn(tree, key); }
+
+            bool isOrdered() const override { return true; }
+
+            void scanRange(const KeyRange &range, const IndexVisitor &visitor) override
+            {
+                scanRangeIn(tree, range, visitor);
+            }
+
+            bool lastKey(string &key) override { return lastKeyIn(tree, key); }
+
+            size_t size() const override { return entry_count; }
+        };
+
+        KeyArena arena;     // Bytes of every tree key (declared first so it outlives the tree)
+        Tree tree;          // Sorted (key + tuple ID) -> tuple ID mapping
+        size_t entry_count; // Entries inserted so far
+
+        // Tree key bytes for one index entry
+        static string entryKey(const string &key, TupleId tuple_id)
+        {
+            string entry = key;
+            for (int shift = 56; shift >= 0; shift -= 8)
+            {
+                entry.push_back(static_cast<char>((tuple_id >> shift) & 0xFF));
+            }
+            return entry;
+        }
+
+        // Copy the live keys into a fresh arena once removals have left it mostly empty
+        // (put off while snapshots still read keys from the old arena)
+        void compactArena()
+        {
+            KeyArena fresh;
+            if (tree.updateKeys([&](ArenaKey &key)
+                                { key = fresh.store(key.data, key.length); }))
+            {
+                arena = move(fresh);
+            }
+        }
+
+        // Lookup on the live tree or a snapshot of it
+        template <typename TreeView>
+        static vector<TupleId> lookupIn(TreeView &view, const string &key)
+        {
+            // Every entry for key lies between key + 00..00 and key + FF..FF
+            string low = key + string(SUFFIX_SIZE, '\x00');
+            string high = key + string(SUFFIX_SIZE, '\xFF');
+            ArenaKey low_key = ArenaKey::view(low);
+            ArenaKey high_key = ArenaKey::view(high);
+            vector<TupleId> result;
+            view.scanRange(&low_key, true, &high_key, true, [&](const ArenaKey &, TupleId tuple_id)
+                           {
+                result.push_back(tuple_id); // Collect every duplicate of the key
+                return true; });
+            return result;
+        }
+
+        // Largest index key of the live tree or a snapshot of it (the tree key minus its suffix)
+        template <typename TreeView>
+        static bool lastKeyIn(const TreeView &view, string &key)
+        {
+            const ArenaKey *entry = view.lastKey();
+            if (!entry)
+            {
+                return false;
+            }
+            key.assign(entry->data, entry->length - SUFFIX_SIZE);
+            return true;
+        }
+
+        // Range scan on the live tree or a snapshot of it
+        template <typename TreeView>
+        static void scanRangeIn(TreeView &view, const KeyRange &range, const IndexVisitor &visitor)
+        {
+            // Bounds that include an index key itself must also cover its suffixes:
+            // an inclusive high / exclusive low bound becomes key + FF..FF
+            string low = range.low_inclusive ? range.low : range.low + string(SUFFIX_SIZE, '\xFF');
+            string high = range.high_inclusive ? range.high + string(SUFFIX_SIZE, '\xFF') : range.high;
+            ArenaKey low_key = ArenaKey::view(low);
+            ArenaKey high_key = ArenaKey::view(high);
+
+            string key; // Reused buffer for the index key without its suffix
+            view.scanRange(range.has_low ? &low_key : nullptr, range.low_inclusive,
+                           range.has_high ? &high_key : nullptr, range.high_inclusive,
+                           [&](const ArenaKey &entry, TupleId tuple_id)
+                           {
+                key.assign(entry.data, entry.length - SUFFIX_SIZE);
+                return visitor(key, tuple_id); });
+        }
+
+    public:
+        BTreeIndex() : entry_count(0) {}
+
+        IndexType getType() const override { return IndexType::B_TREE; }
+
+        void insert(const string &key, TupleId tuple_id) override
+        {
+            tree.insert(arena.store(entryKey(key, tuple_id)), tuple_id);
+            entry_count++;
+        }
+
+        vector<TupleId> lookup(const string &key) override { return lookupIn(tree, key); }
+
+        bool remove(const string &key, TupleId tuple_id) override
+        {
+            // The probe has the same length as the stored key, so it tells the arena
+            // how many bytes died (the stored copy may have moved inside the tree)
+            string entry = entryKey(key, tuple_id);
+            ArenaKey probe = ArenaKey::view(entry);
+            if (!tree.remove(probe))
+            {
+                return false;
+            }
+            arena.release(probe);
+            entry_count--;
+            if (arena.needsCompaction())
+            {
+                compactArena();
+            }
+            return true;
+        }
+
+        bool isOrdered() const override { return true; }
+
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override
+        {
+            scanRangeIn(tree, range, visitor);
+        }
+
+        // The rightmost path of the tree - one descent instead of a full scan
+        bool lastKey(string &key) override { return lastKeyIn(tree, key); }
+
+        size_t size() const override { return entry_count; }
+
+        void bulkLoad(const vector<pair<string, TupleId>> &entries) override
+        {
+            if (entry_count > 0)
+            {
+                Index::bulkLoad(entries);
+                return;
+            }
+
+            vector<pair<ArenaKey, TupleId>> items;
+            items.reserve(entries.size());
+            for (const auto &entry : entries)
+            {
+                items.emplace_back(arena.store(entryKey(entry.first, entry.second)), entry.second);
+            }
+            // Sorted by (key, tuple ID) is sorted by tree key unless one key is a prefix of another
+            auto by_key = [](const pair<ArenaKey, TupleId> &a, const pair<ArenaKey, TupleId> &b)
+            { return a.first < b.first; };
+            if (!is_sorted(items.begin(), items.end(), by_key))
+            {
+                sort(items.begin(), items.end(), by_key);
+            }
+            tree.bulkLoad(items);
+            entry_count = items.size();
+        }
+
+        // Snapshots share nodes and key bytes with the live tree (copy-on-write)
+        unique_ptr<Index> snapshot() override
+        {
+            return make_unique<Snapshot>(tree.snapshot(), entry_count);
+        }
+    };
+
+    // Change-buffered index - defers insert work on another index
+    // Inserts are queued and merged into the wrapped index as one batch sorted by key,
+    // so a burst of writes walks the index in order instead of descending it at random
+    // for every row. A read merges first if a queued insert touches the keys it looks
+    // at, so results always include every change. A remove cancels a queued insert of
+    // the same entry, or goes straight to the wrapped index - either way it can tell
+    // whether the entry existed.
+    class BufferedIndex : public Index
+    {
+    private:
+        // One queued insert
+        struct PendingInsert
+        {
+            string key;       // Index key being added
+            TupleId tuple_id; // Row the entry points to
+        };
+
+        static constexpr size_t CAPACITY = 1024; // Queued inserts that trigger a merge
+
+        unique_ptr<Index> inner;            // Index that receives merged inserts
+        vector<PendingInsert> pending;      // Inserts not merged yet, oldest first
+        unordered_set<string> pending_keys; // Keys of the queued inserts
+
+        // Apply every queued insert to the wrapped index, in key order
+        void merge()
+        {
+            stable_sort(pending.begin(), pending.end(), [](const PendingInsert &a, const PendingInsert &b)
+                        { return a.key < b.key; });
+            for (const auto &change : pending)
+            {
+                inner->insert(change.key, change.tuple_id);
+            }
+            pending.clear();
+            pending_keys.clear();
+        }
+
+    public:
+        explicit BufferedIndex(unique_ptr<Index> inner) : inner(move(inner)) {}
+
+        IndexType getType() const override { return inner->getType(); }
+
+        void insert(const string &key, TupleId tuple_id) override
+        {
+            pending.push_back({key, tuple_id});
+            pending_keys.insert(key);
+            if (pending.size() >= CAPACITY)
+            {
+                merge();
+            }
+        }
+
+        vector<TupleId> lookup(const string &key) override
+        {
+            if (pending_keys.count(key))
+            {
+                merge(); // This key has queued inserts
+            }
+            return inner->lookup(key);
+        }
+
+        bool remove(const string &key, TupleId tuple_id) override
+        {
+            if (pending_keys.count(key))
+            {
+                for (size_t i = pending.size(); i-- > 0;)
+                {
+                    if (pending[i].tuple_id == tuple_id && pending[i].key == key)
+                    {
+                        pending.erase(pending.begin() + i); // Never reaches the wrapped index
+                        if (none_of(pending.begin(), pending.end(), [&](const PendingInsert &change)
+                                    { return change.key == key; }))
+                        {
+                            pending_keys.erase(key); // Lookups of this key need no merge any more
+                        }
+                        return true;
+                    }
+                }
+            }
+            return inner->remove(key, tuple_id);
+        }
+
+        bool isOrdered() const override { return inner->isOrdered(); }
+
+        bool isDiskBacked() const override { return inner->isDiskBacked(); }
+
+        size_t maxKeySize() const override { return inner->maxKeySize(); }
+
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override
+        {
+            for (const auto &change : pending)
+            {
+                if (range.contains(change.key))
+                {
+                    merge(); // Some queued insert falls inside the range
+                    break;
+                }
+            }
+            inner->scanRange(range, visitor);
+        }
+
+        bool lastKey(string &key) override
+        {
+            if (!pending.empty())
+            {
+                merge(); // A queued insert may add the last key
+            }
+            return inner->lastKey(key);
+        }
+
+        // Queued inserts are all new entries (a re-inserted entry was removed first,
+        // cancelling its queued insert or leaving the wrapped index), so they just add up
+        size_t size() const override { return inner->size() + pending.size(); }
+    };
+
+    // Adaptive hash index - shortcut for hot point lookups on a tree index
+    // Each lookup lands in a counter slot picked by the key's hash. A slot remembers
+    // which key it is counting (a hash fingerprint) and starts over when another key
+    // lands there, so only keys looked up again and again reach HOT_THRESHOLD while
+    // scattered traffic never does. Hot keys have their rows cached in a hash table
+    // and later lookups take one hash probe instead of a tree descent. Any insert or
+    // remove on a key drops its cached entry.
+    class AdaptiveHashIndex : public Index
+    {
+    private:
+        static constexpr size_t COUNTER_SLOTS = 65536; // Lookup counters (keys share slots by hash)
+        static constexpr uint32_t HOT_THRESHOLD = 4;   // Lookups in a row that make a key hot
+        static constexpr size_t MAX_HOT_KEYS = 65536;  // Bound on cached keys
+
+        unique_ptr<Index> inner;                         // Index that owns the entries
+        vector<uint32_t> lookup_slots;                   // Per slot: key fingerprint << 8 | lookup count
+        unordered_map<string, vector<TupleId>> hot_keys; // Cached lookup results of hot keys
+
+    public:
+        explicit AdaptiveHashIndex(unique_ptr<Index> inner)
+            : inner(move(inner)), lookup_slots(COUNTER_SLOTS, 0) {}
+
+        IndexType getType() const override { return inner->getType(); }
+
+        void insert(const string &key, TupleId tuple_id) override
+        {
+            if (!hot_keys.empty())
+            {
+                hot_keys.erase(key); // Cached rows are stale now
+            }
+            inner->insert(key, tuple_id);
+        }
+
+        vector<TupleId> lookup(const string &key) override
+        {
+            if (!hot_keys.empty())
+            {
+                auto hot = hot_keys.find(key);
+                if (hot != hot_keys.end())
+                {
+                    return hot->second; // One hash probe, no tree descent
+                }
+            }
+
+            vector<TupleId> result = inner->lookup(key);
+
+            size_t hash = std::hash<string>()(key);
+            uint32_t &slot = lookup_slots[hash & (COUNTER_SLOTS - 1)];
+            uint32_t fingerprint = static_cast<uint32_t>((hash >> 16) & 0xFFFFFF) << 8;
+            if ((slot & ~0xFFu) != fingerprint)
+            {
+                slot = fingerprint | 1; // Slot was counting another key - start over
+            }
+            else if ((slot & 0xFF) + 1 >= HOT_THRESHOLD)
+            {
+                slot = fingerprint;
+                if (hot_keys.size() >= MAX_HOT_KEYS)
+                {
+                    hot_keys.clear(); // Start adapting again from scratch
+                }
+                hot_keys.emplace(key, result);
+            }
+            else
+            {
+                slot++;
+            }
+            return result;
+        }
+
+        bool remove(const string &key, TupleId tuple_id) override
+        {
+            if (!hot_keys.empty())
+            {
+                hot_keys.erase(key);
+            }
+            return inner->remove(key, tuple_id);
+        }
+
+        bool isOrdered() const override { return inner->isOrdered(); }
+
+        bool isDiskBacked() const override { return inner->isDiskBacked(); }
+
+        size_t maxKeySize() const override { return inner->maxKeySize(); }
+
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override
+        {
+            inner->scanRange(range, visitor);
+        }
+
+        bool lastKey(string &key) override { return inner->lastKey(key); }
+
+        size_t size() const override { return inner->size(); }
+
+        void bulkLoad(const vector<pair<string, TupleId>> &entries) override { inner->bulkLoad(entries); }
+
+        unique_ptr<Index> snapshot() override { return inner->snapshot(); }
+    };
+
+    // Create an empty index of the requested type
+    // Disk-backed index types keep their pages in the file at file_path
+    unique_ptr<Index> makeIndex(IndexType type, const string &file_path);
+
+} // namespace db
@@ -1,7 +1,7 @@
 #pragma once
 
 #include "types.h"
-#include "b_tree.h"
+#include "index.h"
 #include <unordered_map>
 #include <memory>
 #include <string>
@@ -14,30 +14,31 @@ namespace db
     // Forward declarations - tell compiler these classes exist
     class StorageEngine;
 
-    // IndexManager class - manages all database indexes for fast data lookup
-    // Creates and maintains B-tree indexes on table columns for quick searches
+    // IndexManager class - database-wide view of the indexes for fast data lookup
+    // It keeps no indexes of its own: every index lives in its table's catalog
+    // (Table::listIndexes), which insert/update/delete maintain and the database
+    // metadata persists, so lookups here never see a stale copy.
     class IndexManager
     {
     private:
-        // Map from "table.column" names to their B-tree indexes
-        // Each index maps values to tuple IDs (row locations)
-        unordered_map<string, unique_ptr<BTree<string, TupleId>>> indexes;
-        StorageEngine *storage_engine; // Reference to storage system
+        StorageEngine *storage_engine; // Reference to storage system (owns the tables and their indexes)
 
     public:
         // Constructor - initialize with reference to storage engine
         IndexManager(StorageEngine *storage_engine);
 
         // Create a new index on a table column (speeds up searches on that column)
-        bool createIndex(const string &table_name, const string &column_name);
+        bool createIndex(const string &table_name, const string &column_name,
+                         IndexType type = IndexType::B_TREE);
 
         // Look up all rows that have a specific value in an indexed column
         vector<TupleId> lookupIndex(const string &table_name,
                                     const string &column_name,
                                     const Value &value);
 
-        // Remove an index (frees up space but slows down searches)
-        void dropIndex(const string &table_name, const string &column_name);
+        // Remove an index by name (frees up space but slows down searches) - an index made
+        // by createIndex above is named after its column, with "@TYPE" unless it is a B-tree
+        void dropIndex(const string &table_name, const string &index_name);
 
         // Check if an index exists on a specific table column
         bool indexExists(const string &table_name, const string &column_name);
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "types.h"
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+
+using namespace std;
+
+namespace db
+{
+
+    // Binary-comparable key encoding
+    // Values are turned into byte strings whose plain byte-by-byte order
+    // (memcmp / string comparison) matches the order of the original values.
+    // Index structures can then compare and split keys without knowing types.
+    //
+    //   INTEGER - 4 bytes big-endian with the sign bit flipped
+    //   DOUBLE  - 8 bytes big-endian IEEE bits (negatives inverted, positives sign-flipped);
+    //             -0.0 is encoded as 0.0 (they compare equal), and every NaN as one
+    //             quiet NaN that sorts after +infinity
+    //   BOOLEAN - 1 byte (0 or 1)
+    //   VARCHAR - bytes with 0x00 escaped as 0x00 0xFF, terminated by 0x00 0x00
+    //
+    // Every encoding is prefix-free, so encoded values can be concatenated
+    // (multi-column keys) and still compare column by column.
+
+    // Append the encoding of one value to an existing key
+    inline void appendKey(string &key, const Value &value)
+    {
+        visit([&](const auto &v)
+              {
+            using T = decay_t<decltype(v)>;
+            if constexpr (is_same_v<T, int32_t>) {
+                uint32_t bits = static_cast<uint32_t>(v) ^ 0x80000000u; // Negatives sort first
+                for (int shift = 24; shift >= 0; shift -= 8) {
+                    key.push_back(static_cast<char>((bits >> shift) & 0xFF));
+                }
+            } else if constexpr (is_same_v<T, double>) {
+                double canonical = v == 0.0 ? 0.0 : (isnan(v) ? numeric_limits<double>::quiet_NaN() : v);
+                uint64_t bits;
+                memcpy(&bits, &canonical, sizeof(double));
+                bits = (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+                for (int shift = 56; shift >= 0; shift -= 8) {
+                    key.push_back(static_cast<char>((bits >> shift) & 0xFF));
+                }
+            } else if constexpr (is_same_v<T, bool>) {
+                key.push_back(v ? 1 : 0);
+            } else if constexpr (is_same_v<T, string>) {
+                for (char c : v) {
+                    key.push_back(c);
+                    if (c == '\0') {
+                        key.push_back(static_cast<char>(0xFF)); // Escape embedded zero bytes
+                    }
+                }
+                key.push_back('\0'); // Terminator sorts before any continuation
+                key.push_back('\0');
+            } }, value);
+    }
+
+    // Encode a single value as an index key
+    inline string encodeKey(const Value &value)
+    {
+        string key;
+        appendKey(key, value);
+        return key;
+    }
+
+    // Decode one value of the given type starting at pos (the inverse of appendKey)
+    // Advances pos past the value; returns false if the key is truncated
+    inline bool decodeKey(const string &key, size_t &pos, DataType type, Value &value)
+    {
+        auto byte_at = [&](size_t i)
+        { return static_cast<uint8_t>(key[i]); };
+
+        switch (type)
+        {
+        case DataType::INTEGER:
+        {
+            if (pos + 4 > key.size())
+                return false;
+            uint32_t bits = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                bits = (bits << 8) | byte_at(pos++);
+            }
+            value = static_cast<int32_t>(bits ^ 0x80000000u);
+            return true;
+        }
+        case DataType::DOUBLE:
+        {
+            if (pos + 8 > key.size())
+                return false;
+            uint64_t bits = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                bits = (bits << 8) | byte_at(pos++);
+            }
+            bits = (bits & 0x8000000000000000ULL) ? (bits & ~0x8000000000000000ULL) : ~bits;
+            double d;
+            memcpy(&d, &bits, sizeof(double));
+            value = d;
+            return true;
+        }
+        case DataType::BOOLEAN:
+        {
+            if (pos + 1 > key.size())
+                return false;
+            value = byte_at(pos++) != 0;
+            return true;
+        }
+        case DataType::VARCHAR:
+        {
+            string str;
+            while (pos + 1 < key.size())
+            {
+                char c = key[pos++];
+                if (c == '\0')
+                {
+                    if (key[pos++] == '\0')
+                    {
+                        value = move(str); // Terminator reached
+                        return true;
+                    }
+                }
+                str.push_back(c); // Ordinary byte, or an escaped zero byte
+            }
+            return false;
+        }
+        }
+        return false;
+    }
+
+    // Turn a key prefix into the smallest key that sorts after every key starting
+    // with it (trailing 0xFF bytes are dropped and the last byte incremented)
+    // Returns false if no such key exists (the prefix was empty or all 0xFF)
+    inline bool nextKeyPrefix(string &prefix)
+    {
+        while (!prefix.empty() && static_cast<uint8_t>(prefix.back()) == 0xFF)
+        {
+            prefix.pop_back();
+        }
+        if (prefix.empty())
+        {
+            return false;
+        }
+        prefix.back() = static_cast<char>(static_cast<uint8_t>(prefix.back()) + 1);
+        return true;
+    }
+
+} // namespace db
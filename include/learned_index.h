@@ -0,0 +1,88 @@
+#pragma once
+
+#include "types.h"
+#include "index.h"
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // One linear model covering a run of the sorted key array
+    // Predicts position = start_pos + slope * (key - first_key) within MAX_ERROR
+    struct LearnedSegment
+    {
+        uint32_t first_key; // Smallest key covered by this segment
+        size_t start_pos;   // Position of first_key in the sorted array
+        double slope;       // Positions per key unit
+    };
+
+    // Learned index - experimental, for read-mostly single INTEGER columns
+    // Keys are kept in one sorted array, and piecewise-linear models learned from it
+    // replace the tree: the segment for a key is found by binary search over the
+    // (few) segment start keys, its model predicts a position, and only a window of
+    // 2 * MAX_ERROR entries around that position is searched. Monotonic keys such as
+    // ids and timestamps fit in very few segments.
+    // New entries go to a small sorted delta buffer and removals are recorded as
+    // tombstones; both are folded into the array (and the models retrained) once the
+    // delta grows past a fraction of the array.
+    class LearnedIndex : public Index
+    {
+    private:
+        static constexpr size_t MAX_ERROR = 32;         // Max distance between predicted and real position
+        static constexpr size_t MIN_DELTA_MERGE = 4096; // Delta size that always triggers a merge
+
+        vector<uint32_t> keys;           // Sorted keys (encoded INTEGER values as numbers)
+        vector<TupleId> tuple_ids;       // Rows, parallel to keys (duplicates ordered by tuple ID)
+        vector<LearnedSegment> segments; // Models over keys, ordered by first_key
+
+        set<pair<uint32_t, TupleId>> delta;      // Entries inserted since the last merge
+        set<pair<uint32_t, TupleId>> tombstones; // Array entries removed since the last merge
+
+        // Key string (4-byte encoded INTEGER) as a number with the same order
+        static bool toNumber(const string &key, uint32_t &number);
+
+        // Number back to its 4-byte key string
+        static string toKey(uint32_t number);
+
+        // Fit segments to the sorted array (greedy shrinking-cone fit)
+        void train();
+
+        // First array position whose key is >= number
+        size_t lowerBound(uint32_t number) const;
+
+        // Fold the delta and tombstones into the array and retrain
+        void merge();
+
+        // Is this array entry still live?
+        bool isLive(size_t pos) const
+        {
+            return tombstones.empty() || tombstones.count({keys[pos], tuple_ids[pos]}) == 0;
+        }
+
+    public:
+        IndexType getType() const override { return IndexType::LEARNED; }
+
+        void insert(const string &key, TupleId tuple_id) override;
+
+        vector<TupleId> lookup(const string &key) override;
+
+        bool remove(const string &key, TupleId tuple_id) override;
+
+        bool isOrdered() const override { return true; }
+
+        void scanRange(const KeyRange &range, const IndexVisitor &visitor) override;
+
+        size_t size() const override { return keys.size() - tombstones.size() + delta.size(); }
+
+        // Sorted entries become the array directly and the models are trained once
+        void bulkLoad(const vector<pair<string, TupleId>> &entries) override;
+
+        // Number of linear models currently used (for benchmarks and statistics)
+        size_t segmentCount() const { return segments.size(); }
+    };
+
+} // namespace db
@@ -0,0 +1,659 @@
+#pragma once
+
+#include "types.h"
+#include "expression.h"
+#include "row_batch.h"
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+    // Forward declaration - scans read rows through the Table interface
+    class Table;
+
+    // Operator - one node of a physical query plan (pull-based "Volcano" model)
+    // A parent asks its child for rows one at a time: open() prepares the operator,
+    // every next() call produces one row until it returns false, and close() gives
+    // back whatever open() took. Operators only see their children through this
+    // interface, so any of them can sit on top of any other.
+    // Rows hold values in the order of the operator's output schema.
+    //
+    // Plans can also run vectorized: the root is pulled with nextBatch() instead, and
+    // operators hand each other RowBatches of up to 1024 rows stored column by column.
+    // One plan is pulled in one mode only - don't mix next() and nextBatch() calls.
+    class Operator
+    {
+    protected:
+        Schema schema; // Columns of the rows this operator produces
+
+    public:
+        virtual ~Operator() = default;
+
+        // Prepare to produce rows (opens the children too)
+        virtual void open() = 0;
+
+        // Produce the next row - returns false once there are no more
+        virtual bool next(Tuple &tuple) = 0;
+
+        // Release buffered rows and close the children
+        virtual void close() = 0;
+
+        // Produce the next batch of rows - returns false once there are no more
+        // A returned batch has at least one selected row. This default fills the batch
+        // from next(), so any operator can feed a vectorized parent; scans, filters,
+        // projections and aggregates override it to work on whole columns at a time.
+        virtual bool nextBatch(RowBatch &batch);
+
+        // Columns of the produced rows
+        const Schema &getSchema() const { return schema; }
+    };
+
+    using OperatorPtr = unique_ptr<Operator>;
+
+    // SeqScanOperator - reads a table page by page in page chain order
+    // Only one page's rows are buffered; with a column mask the other columns are
+    // skipped while decoding and hold placeholder values. Rows have the table's schema.
+    class SeqScanOperator : public Operator
+    {
+    private:
+        Table *table;                // Table being scanned
+        vector<bool> decode_columns; // Columns to decode (empty = all)
+        PageId next_page;            // Next page to read (0 once the chain is done)
+        vector<Tuple> page_rows;     // Rows of the page being returned
+        size_t page_position;        // Next row of page_rows (of next_page when batched) to return
+
+    public:
+        SeqScanOperator(Table *table, vector<bool> decode_columns = {});
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Decodes pages straight into the batch's column vectors
+        bool nextBatch(RowBatch &batch) override;
+    };
+
+    // IndexScanOperator - reads the rows an index says may match the conditions
+    // open() asks the table for the candidate row IDs; each next() fetches one row.
+    // Candidates can include rows that fail the conditions (e.g. a composite index
+    // matching only a prefix), so a FilterOperator above must still check them.
+    // With covered columns set, rows are rebuilt from a covering index alone instead
+    // (index-only scan) - only those columns hold real values. Given the WHERE
+    // expression, bitmap indexes can answer its OR / NOT / IN parts as well.
+    // Rows have the table's schema.
+    class IndexScanOperator : public Operator
+    {
+    private:
+        Table *table;                   // Table being read
+        vector<Condition> conditions;   // Conditions the index is chosen for
+        ExprPtr where;                  // Whole WHERE expression, for the bitmap indexes (may be null)
+        vector<bool> decode_columns;    // Columns to decode from fetched rows (empty = all)
+        vector<string> covered_columns; // Index-only scan: the columns to read from the index
+        vector<TupleId> tuple_ids;      // Candidate rows found at open()
+        vector<Tuple> index_rows;       // Index-only scan: rows rebuilt from index entries
+        size_t position;                // Next candidate (or index row) to return
+        OperatorPtr fallback;           // Sequential scan used if the index was dropped meanwhile
+
+    public:
+        IndexScanOperator(Table *table, vector<Condition> conditions, vector<bool> decode_columns = {},
+                          vector<string> covered_columns = {}, ExprPtr where = nullptr);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+    };
+
+    // IndexOrderScanOperator - reads a table in the key order of an ordered index
+    // Rows come back sorted ascending on the index's key columns, so an ORDER BY on
+    // them needs no sort. Row IDs are read CHUNK_SIZE at a time and each row is fetched
+    // as it is returned, so a LIMIT above stops after a few rows without walking the
+    // whole index. Rows have the table's schema.
+    class IndexOrderScanOperator : public Operator
+    {
+    private:
+        static constexpr size_t CHUNK_SIZE = 1024; // Index entries read per call into the table
+
+        Table *table;                // Table being read
+        string index_name;           // Ordered index giving the row order
+        vector<bool> decode_columns; // Columns to decode from fetched rows (empty = all)
+        vector<TupleId> tuple_ids;   // Current chunk of row IDs, in key order
+        size_t position;             // Next row ID of the chunk to fetch
+        string last_key;             // Last index key read so far (where the next chunk starts)
+        bool started;                // Has the first chunk been read?
+        bool finished;               // Has the end of the index been reached?
+
+    public:
+        IndexOrderScanOperator(Table *table, string index_name, vector<bool> decode_columns = {});
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+    };
+
+    // FilterOperator - passes on only the rows that satisfy a compiled predicate
+    class FilterOperator : public Operator
+    {
+    private:
+        OperatorPtr child;           // Rows to test
+        CompiledPredicate predicate; // Compiled against the child's schema
+
+    public:
+        FilterOperator(OperatorPtr child, CompiledPredicate predicate);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Narrows each batch's selection vector with the predicate's typed kernels
+        bool nextBatch(RowBatch &batch) override;
+    };
+
+    // ProjectOperator - keeps the listed columns of each row, in the listed order
+    // Values are moved out of the child's row; a column listed twice is copied for
+    // every use but its last.
+    class ProjectOperator : public Operator
+    {
+    private:
+        OperatorPtr child;      // Rows to project
+        vector<int> column_ids; // Positions in the child's schema, in output order
+        vector<bool> last_use;  // Can column_ids[i]'s value be moved instead of copied?
+        RowBatch input;         // Child's batch (its column vectors are swapped into the output)
+
+    public:
+        ProjectOperator(OperatorPtr child, vector<int> column_ids);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Hands over whole column vectors - no per-row work
+        bool nextBatch(RowBatch &batch) override;
+    };
+
+    // LimitOperator - skips the first offset rows, then passes on at most limit rows
+    // Once the limit is reached it closes its child straight away, so scans stop and
+    // drop their buffered pages and candidate lists without waiting for close().
+    class LimitOperator : public Operator
+    {
+    private:
+        OperatorPtr child; // Rows to limit
+        size_t limit;      // Most rows to return
+        size_t offset;     // Rows to skip first
+        size_t skipped;    // Offset rows skipped so far
+        size_t returned;   // Rows returned so far
+        bool child_open;   // Is the child still open?
+
+        // Close the child early (the limit was reached)
+        void finish();
+
+    public:
+        LimitOperator(OperatorPtr child, size_t limit, size_t offset = 0);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Trims the selection vector of the child's batches to the offset and limit
+        bool nextBatch(RowBatch &batch) override;
+    };
+
+    // One ORDER BY term: a column of the child's schema and its direction
+    struct SortKey
+    {
+        int column;      // Position in the child's schema
+        bool descending; // DESC instead of the default ASC
+    };
+
+    // Default memory budget of an operator that buffers rows (a sort or an aggregation), in bytes
+    constexpr size_t DEFAULT_WORK_MEMORY = 16 * 1024 * 1024;
+
+    // A row and its binary-comparable key - how sorts buffer rows and how sorts and
+    // aggregations write rows to their temporary spill files
+    struct SpillRow
+    {
+        string key;  // Normalized sort key or encoded group key (compare with <)
+        Tuple tuple; // The row itself
+    };
+
+    // SortOperator - returns the child's rows ordered by the sort keys (external merge sort)
+    // Every row gets a normalized key - the binary-comparable encodings of its sort
+    // columns, DESC columns with their bytes inverted - so two rows compare with one
+    // memcmp whatever the key types. open() buffers rows until the memory budget is
+    // used up, sorts them and writes them to a temporary spill file as one sorted run.
+    // If anything was spilled, the runs are merged MAX_MERGE_FAN_IN at a time until one
+    // k-way merge can produce the output, which next() then pulls row by row - so
+    // memory stays bounded by the budget however large the input is.
+    // Rows with equal keys keep the order the child produced them in.
+    class SortOperator : public Operator
+    {
+    public:
+        static constexpr size_t MAX_MERGE_FAN_IN = 64; // Most runs merged at once
+
+        // K-way merge of sorted runs: repeatedly yields the smallest head row
+        // Ties go to the earlier run, so the merge is stable.
+        class RunMerger
+        {
+        private:
+            vector<FILE *> runs;    // Runs being merged, in input order
+            vector<SpillRow> heads; // Current row of each run
+            vector<size_t> heap;    // Runs with a head row, smallest head at the front
+
+            // Min-heap order on (head key, run position)
+            bool after(size_t a, size_t b) const;
+
+        public:
+            RunMerger(vector<FILE *> runs);
+            ~RunMerger();
+
+            // Produce the next row in key order - returns false once every run is used up
+            bool next(SpillRow &row);
+        };
+
+    private:
+        OperatorPtr child;            // Rows to sort
+        vector<SortKey> keys;         // Most significant first
+        size_t memory_budget;         // Bytes of rows to buffer before spilling a run
+        bool vectorized;              // Read the child with nextBatch() instead of next()
+        vector<SpillRow> rows;        // Buffered rows (all of them when nothing spilled)
+        size_t buffered_bytes;        // Estimated memory held by rows
+        size_t position;              // Next row of rows to return
+        vector<FILE *> runs;          // Spilled sorted runs (temporary files, in input order)
+        unique_ptr<RunMerger> merger; // Final merge of the runs (set when anything spilled)
+        size_t spilled_runs;          // Runs written by the last open()
+
+        // Normalized key of a row
+        string sortKey(const Tuple &tuple) const;
+
+        // Buffer one row from the child, spilling a run when the budget is used up
+        void addRow(Tuple &&tuple);
+
+        // Sort the buffered rows and write them out as one run
+        void spillRun();
+
+        // Merge runs down to at most MAX_MERGE_FAN_IN
+        void reduceRuns();
+
+    public:
+        SortOperator(OperatorPtr child, vector<SortKey> keys, size_t memory_budget = DEFAULT_WORK_MEMORY,
+                     bool vectorized = true);
+        ~SortOperator() override;
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Sorted runs written to disk by the last open() (0 = sorted in memory)
+        size_t spilledRuns() const { return spilled_runs; }
+    };
+
+    // TopNOperator - the first limit rows of the child in sort key order (ORDER BY ... LIMIT)
+    // While reading the child it keeps a max-heap of the best limit rows seen so far,
+    // keyed like SortOperator's normalized keys. A row whose key doesn't beat the worst
+    // row kept is dropped as soon as its key is built (in batch mode it never becomes a
+    // Tuple), so memory is O(limit) and only the rows kept are ever sorted.
+    // Rows with equal keys keep the order the child produced them in.
+    class TopNOperator : public Operator
+    {
+    private:
+        // A kept row, its normalized key and its position in the child's output
+        struct HeapRow
+        {
+            string key;      // Normalized sort key
+            size_t sequence; // Arrival order (breaks ties between equal keys)
+            Tuple tuple;     // The row itself
+        };
+
+        OperatorPtr child;    // Rows to rank
+        vector<SortKey> keys; // Most significant first
+        size_t limit;         // Rows to keep
+        bool vectorized;      // Read the child with nextBatch() instead of next()
+        vector<HeapRow> rows; // Max-heap while reading the child, then sorted ascending
+        size_t position;      // Next row to return
+
+        // Order on (key, sequence) - the heap keeps the greatest (worst) row at the front
+        static bool before(const HeapRow &a, const HeapRow &b);
+
+    public:
+        TopNOperator(OperatorPtr child, vector<SortKey> keys, size_t limit, bool vectorized = true);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+    };
+
+    // Aggregate functions
+    enum class AggregateFunc
+    {
+        COUNT, // Number of rows (COUNT(*)) or of values in a column
+        SUM,   // Total of a numeric column
+        AVG,   // Average of a numeric column (always DOUBLE)
+        MIN,   // Smallest value of a column
+        MAX    // Largest value of a column
+    };
+
+    // One aggregate in a query, e.g. SUM(amount)
+    struct AggregateSpec
+    {
+        AggregateFunc func; // What to compute
+        int column;         // Position in the child's schema (-1 for COUNT(*))
+        string name;        // Output column name, e.g. "SUM(amount)"
+    };
+
+    // Running state of one aggregate for one group
+    struct AggregateState
+    {
+        int64_t count = 0;       // Rows seen
+        int64_t int_sum = 0;     // Total of INTEGER values (64 bits, so it doesn't overflow)
+        double double_sum = 0.0; // Total of DOUBLE values
+        Value min;               // Smallest value seen (valid when count > 0)
+        Value max;               // Largest value seen (valid when count > 0)
+
+        // Fold one value in
+        void add(const Value &value);
+
+        // Fold in the selected values of a column vector (one typed loop)
+        void addBatch(const ColumnVector &column, const vector<uint32_t> &selection);
+
+        // Fold in another state of the same aggregate (a partial result from another thread)
+        void merge(const AggregateState &other);
+
+        // Final value of the aggregate, of the type its output column is declared with
+        // Throws runtime_error when a COUNT or an INTEGER SUM doesn't fit 32 bits
+        Value result(const AggregateSpec &spec, DataType input_type) const;
+    };
+
+    // GroupTable - open-addressing hash table of aggregation groups
+    // Linear probing over a power-of-two slot array; groups are keyed by their encoded
+    // group column values and hold one running AggregateState per aggregate.
+    class GroupTable
+    {
+    public:
+        // One group: its encoded key and running aggregate states
+        struct Group
+        {
+            string key;                    // Encoded group column values
+            size_t hash;                   // Hash of key
+            vector<AggregateState> states; // One per aggregate
+        };
+
+        static constexpr size_t NOT_FOUND = SIZE_MAX;
+
+        vector<Group> groups; // Groups in the order they were created
+
+        // Position of the group with this key in groups (NOT_FOUND if there is none)
+        size_t find(const string &key, size_t hash) const;
+
+        // Add a new group (the key must not be in the table) and return its position
+        size_t insert(const string &key, size_t hash, size_t aggregate_count);
+
+        // Estimated memory held by the table
+        size_t memoryBytes() const { return group_bytes + slots.size() * sizeof(uint32_t); }
+
+        // Drop every group
+        void clear();
+
+    private:
+        vector<uint32_t> slots; // Position in groups + 1 of each slot's group (0 = empty)
+        size_t group_bytes = 0; // Estimated memory held by groups
+
+        // Put a group in the first free slot of its probe sequence
+        void place(size_t position);
+    };
+
+    // AggregateOperator - groups the child's rows and computes aggregates per group
+    // Output rows hold the group columns followed by one value per aggregate. Without
+    // group columns there is exactly one output row, even for an empty input
+    // (COUNT is 0; the engine has no NULLs, so the other aggregates return zero values).
+    // Vectorized, it reads its child in batches and folds each column with typed loops.
+    //
+    // Groups live in an open-addressing hash table keyed by the encoded group columns.
+    // Once the table outgrows the memory budget, rows of groups already in it are still
+    // aggregated in memory, but rows of new groups are written to one of PARTITIONS
+    // spill files picked by their hash. After the input ends the in-memory groups are
+    // returned, then each partition is read back and aggregated the same way (spilling
+    // again, on other hash bits, if it is still too large). A group only ever lives in
+    // one place, so no partial results have to be combined.
+    class AggregateOperator : public Operator
+    {
+    public:
+        static constexpr size_t PARTITIONS = 16;     // Spill files per spilling pass
+        static constexpr size_t MAX_SPILL_DEPTH = 4; // Passes after which a partition stays in memory
+
+    private:
+        OperatorPtr child;                    // Rows to aggregate
+        vector<int> group_columns;            // Positions of the GROUP BY columns in the child's schema
+        vector<AggregateSpec> aggregates;     // Aggregates to compute
+        size_t memory_budget;                 // Bytes the group table may use before new groups spill
+        bool vectorized;                      // Read the child with nextBatch() instead of next()
+        vector<DataType> input_types;         // Type of each aggregate's input column
+        GroupTable table;                     // Groups being aggregated or returned
+        size_t position;                      // Next group of table to return
+        size_t depth;                         // Spilling pass the table's groups come from (0 = the child)
+        vector<FILE *> spill_files;           // Partitions written by this pass (nullptr = unused)
+        vector<pair<FILE *, size_t>> pending; // Partitions still to aggregate, with their pass
+        size_t spilled_partitions;            // Partition files written since open()
+
+        // Find or create the group of a key; returns NOT_FOUND when the group is new and
+        // the table is full, after writing the row's aggregate inputs (agg_value(i) gives
+        // aggregate i's input) to the key's partition
+        template <typename AggValue>
+        size_t findGroup(const string &key, AggValue &&agg_value);
+
+        // Fold one row into a group (agg_value(i) gives aggregate i's input value)
+        template <typename AggValue>
+        void fold(size_t group, AggValue &&agg_value);
+
+        // Aggregate every row of the child into the table
+        void aggregateChild();
+
+        // Aggregate every row of a spilled partition into the (empty) table
+        void aggregatePartition(FILE *file);
+
+        // Queue the partitions written by this pass for the next one
+        void finishPass();
+
+    public:
+        AggregateOperator(OperatorPtr child, vector<int> group_columns, vector<AggregateSpec> aggregates,
+                          size_t memory_budget = DEFAULT_WORK_MEMORY, bool vectorized = true);
+        ~AggregateOperator() override;
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Partition files written to disk since open() (0 = aggregated in memory)
+        size_t spilledPartitions() const { return spilled_partitions; }
+    };
+
+    // ParallelAggregateOperator - aggregates a whole table (a filtered sequential scan)
+    // on several threads; output rows are the same as AggregateOperator's.
+    //
+    // Worker threads take MORSEL_PAGES pages at a time off the table's page chain, copy
+    // them out under the table latch, then decode, filter and aggregate them with no
+    // shared state: each worker has its own group tables, one per hash partition.
+    // Once the scan ends, partitions are merged in parallel - a group's partial states
+    // are all in the same partition of every worker, so each partition is merged by one
+    // thread without locks. If the workers' groups together outgrow the memory budget,
+    // the parallel work is dropped and a single-threaded AggregateOperator, which
+    // spills, aggregates the table instead.
+    class ParallelAggregateOperator : public Operator
+    {
+    public:
+        static constexpr size_t MORSEL_PAGES = 8; // Pages a worker takes off the chain at a time
+        static constexpr size_t PARTITIONS = 16;  // Hash partitions of each worker's groups
+
+    private:
+        Table *table;                          // Table to aggregate
+        vector<bool> decode_columns;           // Columns to decode (empty = all)
+        optional<CompiledPredicate> predicate; // WHERE clause (none = every row)
+        vector<int> group_columns;             // Positions of the GROUP BY columns in the table's schema
+        vector<AggregateSpec> aggregates;      // Aggregates to compute
+        size_t memory_budget;                  // Bytes all workers' groups may use together
+        size_t workers;                        // Threads to scan and merge with
+        vector<DataType> input_types;          // Type of each aggregate's input column
+        vector<GroupTable> partitions;         // Merged groups, by partition
+        size_t partition;                      // Partition being returned
+        size_t position;                       // Next group of that partition to return
+        OperatorPtr fallback;                  // Single-threaded plan, when the groups didn't fit
+
+        mutex cursor_latch; // Guards next_page
+        PageId next_page;   // Next page of the chain for a worker to take (0 once the chain is done)
+
+        // Copy up to MORSEL_PAGES pages from the chain; returns how many were copied
+        size_t takePages(vector<vector<uint8_t>> &pages);
+
+        // Worker loop: aggregate pages into the worker's group tables until the chain ends
+        // or stop is set (stop is set here when memory_used exceeds the budget)
+        void scanPages(vector<GroupTable> &tables, atomic<size_t> &memory_used, atomic<bool> &stop);
+
+        // Filter a batch and fold its selected rows into a worker's group tables
+        void aggregateBatch(RowBatch &batch, vector<GroupTable> &tables, atomic<size_t> &memory_used,
+                            atomic<bool> &stop);
+
+        // Merge every worker's tables partition by partition into partitions
+        void mergePartitions(vector<vector<GroupTable>> &worker_tables);
+
+    public:
+        ParallelAggregateOperator(Table *table, vector<bool> decode_columns, optional<CompiledPredicate> predicate,
+                                  vector<int> group_columns, vector<AggregateSpec> aggregates,
+                                  size_t memory_budget = DEFAULT_WORK_MEMORY, size_t workers = 2);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Did the last open() give up on the parallel plan because the groups didn't fit?
+        bool fellBack() const { return fallback != nullptr; }
+    };
+
+    // MetadataAggregateOperator - answers an ungrouped, unfiltered aggregation without
+    // reading any rows: COUNT from the table's row count, MIN / MAX of a column from the
+    // first / last key of an ordered index on it. Returns the one row AggregateOperator
+    // would return for the same aggregates (the planner checks they can all be answered).
+    class MetadataAggregateOperator : public Operator
+    {
+    private:
+        Table *table;                     // Table being aggregated
+        vector<AggregateSpec> aggregates; // COUNT, MIN and MAX only
+        vector<string> bound_indexes;     // Index read by each MIN / MAX ("" for a COUNT)
+        vector<DataType> input_types;     // Type of each aggregate's input column
+        bool returned;                    // Has the row been returned since open()?
+
+    public:
+        MetadataAggregateOperator(Table *table, vector<AggregateSpec> aggregates, vector<string> bound_indexes);
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+    };
+
+    // HashJoinOperator - inner equality join of two inputs (left.key = right.key)
+    // Output rows hold the left row's values followed by the right row's. One input, the
+    // build side, is read into a hash table keyed by the encoded join value; the other,
+    // the probe side, is then streamed past it and each row is returned joined with
+    // every build row of the same key.
+    //
+    // If the build side outgrows the memory budget, the join turns into a grace hash
+    // join: both inputs are split into PARTITIONS temporary files by the hash of the
+    // join value (probe rows whose build partition is empty are dropped right away),
+    // and each pair of partitions is then joined in memory - a build partition still
+    // too large is split again on other hash bits. Each input is read once either way.
+    class HashJoinOperator : public Operator
+    {
+    public:
+        static constexpr size_t PARTITIONS = 16;     // Files per partitioning pass
+        static constexpr size_t MAX_SPILL_DEPTH = 4; // Passes after which a partition stays in memory
+
+    private:
+        // Build row in the hash table; rows of a bucket are chained through next
+        struct BuildRow
+        {
+            SpillRow row;  // Encoded join value and the row
+            size_t hash;   // Hash of row.key
+            uint32_t next; // Next row of the bucket + 1 (0 = end of the chain)
+        };
+
+        // Matching build and probe partition files of one pass
+        struct PartitionPair
+        {
+            FILE *build;  // Build rows of the partition
+            FILE *probe;  // Probe rows of the partition (nullptr = none)
+            size_t depth; // Pass that wrote them (the next split uses the next hash bits)
+        };
+
+        OperatorPtr left;               // Left input (its columns come first)
+        OperatorPtr right;              // Right input
+        int left_key;                   // Join column in the left input's schema
+        int right_key;                  // Join column in the right input's schema
+        bool build_left;                // Build the hash table from the left input instead of the right
+        size_t memory_budget;           // Bytes the hash table may use before the build side spills
+        bool vectorized;                // Read the inputs with nextBatch() instead of next()
+        vector<BuildRow> build_rows;    // Hash table rows
+        vector<uint32_t> buckets;       // First row + 1 of each bucket's chain (0 = empty)
+        size_t build_bytes;             // Estimated memory held by build_rows
+        RowBatch probe_batch;           // Batch being read from the probe input
+        size_t batch_position;          // Next selected row of probe_batch
+        bool probe_input_done;          // Has the probe input been read to its end (or into partitions)?
+        FILE *probe_file;               // Probe partition being joined (nullptr = the probe input)
+        SpillRow probe_row;             // Current probe row and its encoded join value
+        size_t probe_hash;              // Hash of probe_row.key
+        uint32_t match;                 // Next build row + 1 to test against the probe row (0 = none)
+        vector<PartitionPair> pending;  // Partitions still to join
+        size_t spilled_partitions;      // Partition files written since open()
+
+        Operator &buildInput() { return build_left ? *left : *right; }
+        Operator &probeInput() { return build_left ? *right : *left; }
+        int buildKey() const { return build_left ? left_key : right_key; }
+        int probeKey() const { return build_left ? right_key : left_key; }
+
+        // Next row of an input (read in batches when vectorized)
+        bool pullRow(Operator &input, RowBatch &batch, size_t &position, Tuple &tuple);
+
+        // Add a row to the hash table
+        void addBuildRow(SpillRow &&row, size_t hash);
+
+        // Estimated memory held by the hash table
+        size_t tableBytes() const { return build_bytes + buckets.size() * sizeof(uint32_t); }
+
+        // Empty the hash table, releasing its memory
+        void clearTable();
+
+        // Move the hash table's rows into new build partition files for a pass
+        void spillBuildRows(vector<FILE *> &files, size_t depth);
+
+        // Write a row to its partition for a pass, creating the file when needed
+        void writePartition(vector<FILE *> &files, size_t depth, const SpillRow &row, size_t hash);
+
+        // Split probe rows (from the probe input, or a file) like the build partitions of
+        // a pass, then queue each build partition with its probe partition
+        void partitionProbe(FILE *source, const vector<FILE *> &build_files, size_t depth);
+
+        // Load the next partition pair whose build rows fit; false when none are left
+        bool loadPartition();
+
+        // Next probe row into probe_row / probe_hash; false when the current source ends
+        bool nextProbeRow();
+
+    public:
+        // schema: the output columns (the left input's, then the right's) as the caller names them
+        HashJoinOperator(OperatorPtr left, OperatorPtr right, int left_key, int right_key, Schema schema,
+                         bool build_left = false, size_t memory_budget = DEFAULT_WORK_MEMORY,
+                         bool vectorized = true);
+        ~HashJoinOperator() override;
+
+        void open() override;
+        bool next(Tuple &tuple) override;
+        void close() override;
+
+        // Partition files written to disk since open() (0 = joined in memory)
+        size_t spilledPartitions() const { return spilled_partitions; }
+    };
+
+} // namespace db
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "operator.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+    // Forward declarations - the planner reads parsed queries and the table catalog
+    class StorageEngine;
+    struct SelectNode;
+
+    // QueryPlanner - turns a parsed SELECT into a tree of physical operators
+    // The tree is built bottom-up: a scan (index or sequential), a filter for the
+    // WHERE clause, hash aggregation for GROUP BY / aggregates (scan, filter and
+    // aggregation in one parallel operator over a whole table), a sort for ORDER BY,
+    // LIMIT / OFFSET, then a projection to the selected columns. With JOINs, each
+    // table is scanned (and filtered by its own WHERE conditions) once and the scans
+    // are combined by hash joins below the rest of the plan. The executor only
+    // opens the root and pulls rows, so new query shapes are new operators here
+    // rather than new special cases in QueryExecutor.
+    class QueryPlanner
+    {
+    private:
+        StorageEngine *storage_engine; // Where tables are looked up
+        size_t work_memory;            // Memory budget given to sorts and aggregations
+        bool vectorized;               // Will the plan be pulled in batches?
+        size_t parallel_workers;       // Threads a full-table aggregation may use (1 = serial)
+
+        // Build the operator tree for a SELECT with JOINs
+        OperatorPtr planJoin(const SelectNode &node);
+
+        // Add ORDER BY (sort_keys; empty when the rows are already in order), LIMIT /
+        // OFFSET and the projection to output_ids on top of plan
+        OperatorPtr planOutput(OperatorPtr plan, const SelectNode &node, vector<SortKey> sort_keys,
+                               const vector<int> &output_ids);
+
+    public:
+        // Constructor - plan against the tables of this storage engine
+        QueryPlanner(StorageEngine *storage_engine, size_t work_memory = DEFAULT_WORK_MEMORY, bool vectorized = true,
+                     size_t parallel_workers = 1)
+            : storage_engine(storage_engine), work_memory(work_memory), vectorized(vectorized),
+              parallel_workers(parallel_workers) {}
+
+        // Build the operator tree for a SELECT
+        // Throws runtime_error for an unknown table or column, a misused aggregate or
+        // an invalid JOIN
+        OperatorPtr planSelect(const SelectNode &node);
+    };
+
+} // namespace db
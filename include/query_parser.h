@@ -1,6 +1,7 @@
 #pragma once
 
 #include "types.h"
+#include "expression.h"
 #include <string>
 #include <vector>
 #include <memory>
@@ -22,16 +23,48 @@ namespace db
         virtual ~QueryNode() = default; // Virtual destructor for polymorphism
     };
 
-    // SELECT statement representation: SELECT columns FROM table WHERE condition
-    struct SelectNode : public QueryNode
+    // One ORDER BY term: column [ASC | DESC]
+    struct OrderByItem
     {
-        vector<string> columns; // Column names to select (empty = SELECT *)
-        string table_name;      // Which table to select from
-        string where_column;    // Column name in WHERE clause
-        Value where_value;      // Value to compare against in WHERE
-        bool has_where;         // Does this query have a WHERE clause?
+        string column;   // Column to sort on
+        bool descending; // DESC instead of the default ASC
+    };
 
-        SelectNode() : has_where(false) {} // Default: no WHERE clause
+    // One aggregate call in a SELECT: FUNC(column) or COUNT(*)
+    struct AggregateItem
+    {
+        string function; // COUNT, SUM, AVG, MIN or MAX
+        string column;   // Argument column ("*" for COUNT(*))
+        string name;     // Output column name, e.g. "SUM(amount)"
+    };
+
+    // One JOIN clause: JOIN table ON left_column = right_column
+    struct JoinItem
+    {
+        string table_name;   // Table joined to the tables before it
+        string left_column;  // Column on the left of the = (either side may name the new table)
+        string right_column; // Column on the right of the =
+    };
+
+    // SELECT statement representation:
+    // SELECT columns | aggregates FROM table [JOIN table ON col = col ...] [WHERE expression]
+    //     [GROUP BY col, ...] [ORDER BY col [ASC|DESC], ...] [LIMIT n] [OFFSET m]
+    // With joins, column names may be qualified as table.column
+    struct SelectNode : public QueryNode
+    {
+        vector<string> columns;           // Column names to select (empty = SELECT *); aggregates by name
+        vector<AggregateItem> aggregates; // Aggregates used by the select list or ORDER BY (each once)
+        string table_name;                // Which table to select from (the first one, with joins)
+        vector<JoinItem> joins;           // Tables joined to it, in order (empty = single table)
+        ExprPtr where;                    // WHERE expression (set when has_where)
+        bool has_where;                   // Does this query have a WHERE clause?
+        vector<string> group_by;          // GROUP BY columns (empty = one group when aggregating)
+        vector<OrderByItem> order_by;     // ORDER BY terms, most significant first (empty = no ordering)
+        size_t limit;                     // Most rows to return (set when has_limit)
+        bool has_limit;                   // Does this query have a LIMIT clause?
+        size_t offset;                    // Rows to skip before returning any (0 = none)
+
+        SelectNode() : has_where(false), limit(0), has_limit(false), offset(0) {} // Default: every row
     };
 
     // INSERT statement representation: INSERT INTO table VALUES (...)
@@ -41,25 +74,23 @@ namespace db
         vector<Value> values; // The values to insert (one per column)
     };
 
-    // UPDATE statement representation: UPDATE table SET col=val WHERE condition
+    // UPDATE statement representation: UPDATE table SET col=val WHERE expression
     struct UpdateNode : public QueryNode
     {
         string table_name;                      // Which table to update
         vector<pair<string, Value>> set_values; // Columns and new values to set
-        string where_column;                    // Column name in WHERE clause
-        Value where_value;                      // Value to compare in WHERE
+        ExprPtr where;                          // WHERE expression (set when has_where)
         bool has_where;                         // Does this update have WHERE?
 
         UpdateNode() : has_where(false) {} // Default: no WHERE (update all rows)
     };
 
-    // DELETE statement representation: DELETE FROM table WHERE condition
+    // DELETE statement representation: DELETE FROM table WHERE expression
     struct DeleteNode : public QueryNode
     {
-        string table_name;   // Which table to delete from
-        string where_column; // Column name in WHERE clause
-        Value where_value;   // Value to compare in WHERE clause
-        bool has_where;      // Does this delete have WHERE? (false = delete all!)
+        string table_name; // Which table to delete from
+        ExprPtr where;     // WHERE expression (set when has_where)
+        bool has_where;    // Does this delete have WHERE? (false = delete all!)
 
         DeleteNode() : has_where(false) {} // Default: no WHERE (deletes ALL rows!)
     };
@@ -77,12 +108,28 @@ namespace db
         string table_name; // Name of table to completely remove
     };
 
+    // CREATE INDEX statement representation:
+    // CREATE INDEX table.column | table (col1, col2, ...) [INCLUDE (cols...)] [USING type]
+    //     [WHERE conditions]
+    struct CreateIndexNode : public QueryNode
+    {
+        string table_name;              // Table to index
+        vector<string> column_names;    // Columns whose values form the index key, in order
+        vector<string> include_columns; // Extra columns stored in the index (covering index)
+        IndexType index_type;           // B_TREE (default), HASH or ART
+        vector<Condition> conditions;   // Partial index predicate - only matching rows are indexed
+        bool has_where;                 // Is this a partial index?
+
+        CreateIndexNode() : index_type(IndexType::B_TREE), has_where(false) {} // Default: full B-tree index
+    };
+
     // Query result structure - contains the outcome of executing any SQL command
     struct QueryResult
     {
         bool success;         // Did the query execute successfully?
         string message;       // Success message or error description
         vector<Tuple> tuples; // Rows returned (for SELECT queries)
+        Schema schema;        // Columns of the returned rows (empty = the table's full schema)
 
         QueryResult() : success(false) {} // Default: failed query
 
@@ -107,6 +154,9 @@ namespace db
         // Read table names, column names, etc. (alphanumeric identifiers)
         string readIdentifier();
 
+        // Read a column name in a SELECT: an identifier, or table.column
+        string readColumnName();
+
         // Read quoted string values like 'Hello World'
         string readString();
 
@@ -116,12 +166,40 @@ namespace db
         // Parse column data types (INTEGER, VARCHAR, BOOLEAN, DOUBLE)
         DataType parseDataType();
 
+        // Parse a select list or ORDER BY item: a column name, or an aggregate call
+        // (added to the node's aggregates) whose output name is returned
+        string parseSelectItem(SelectNode &node);
+
+        // Parse the row count after LIMIT / OFFSET (a non-negative integer)
+        size_t parseRowCount(const string &clause);
+
+        // Parse WHERE conditions: column <op> value [AND column <op> value ...]
+        vector<Condition> parseConditions();
+
+        // Parse a full WHERE expression - OR binds loosest, then AND, then NOT:
+        //   expr      := and_expr [OR and_expr ...]
+        //   and_expr  := not_expr [AND not_expr ...]
+        //   not_expr  := NOT not_expr | ( expr ) | predicate
+        //   predicate := column <op> value | column [NOT] BETWEEN value AND value
+        //              | column [NOT] IN (value, ...) | column IS [NOT] NULL
+        ExprPtr parseExpression();
+        ExprPtr parseAndExpression();
+        ExprPtr parseNotExpression();
+        ExprPtr parsePredicate();
+
         // Expect a specific keyword or symbol (throw error if not found)
         void expect(const string &expected);
 
         // Try to match a keyword or symbol (return true/false)
         bool match(const string &expected);
 
+        // Try to match a whole keyword - unlike match, "OR" doesn't match the start of "ORDER"
+        bool matchKeyword(const string &keyword);
+
+        // Accept an optional ';' and then require end of input - the statement's clauses
+        // are optional, so a misspelled one would otherwise be silently ignored
+        void expectEnd(const string &statement);
+
         // Parsing functions for different SQL statement types
 
         // Parse SELECT statement and build SelectNode
@@ -142,6 +220,9 @@ namespace db
         // Parse DROP TABLE statement and build DropTableNode
         unique_ptr<DropTableNode> parseDropTable();
 
+        // Parse CREATE INDEX statement and build CreateIndexNode
+        unique_ptr<CreateIndexNode> parseCreateIndex();
+
     public:
         // Constructor - initialize parser with SQL string to parse
         QueryParser(const string &query) : query(query), position(0) {}
@@ -159,10 +240,25 @@ namespace db
     {
     private:
         StorageEngine *storage_engine; // Pointer to storage system for accessing tables
+        bool vectorized;               // Pull SELECT plans in 1024-row batches (default) or row by row
+        size_t work_memory;            // Bytes a sort or aggregation may buffer before spilling to disk
+        size_t parallel_workers;       // Threads a full-table aggregation may use (default: one per core)
 
     public:
         // Constructor - connect executor to the database storage engine
-        QueryExecutor(StorageEngine *storage_engine) : storage_engine(storage_engine) {}
+        QueryExecutor(StorageEngine *storage_engine);
+
+        // Switch between vectorized (batch) and row-at-a-time execution of SELECT plans
+        void setVectorized(bool enabled) { vectorized = enabled; }
+        bool isVectorized() const { return vectorized; }
+
+        // Memory budget of operators that buffer rows (sorts and aggregations spill past it)
+        void setWorkMemory(size_t bytes) { work_memory = bytes; }
+        size_t getWorkMemory() const { return work_memory; }
+
+        // Threads a full-table aggregation is split across (1 = always single-threaded)
+        void setParallelWorkers(size_t workers) { parallel_workers = workers > 0 ? workers : 1; }
+        size_t getParallelWorkers() const { return parallel_workers; }
 
         // Main execution method - takes SQL string, parses it, and executes it
         QueryResult execute(const string &query);
@@ -186,6 +282,9 @@ namespace db
 
         // Execute DROP TABLE query - completely remove table
         QueryResult executeDropTable(const DropTableNode &node);
+
+        // Execute CREATE INDEX query - build an index on a table column
+        QueryResult executeCreateIndex(const CreateIndexNode &node);
     };
 
 } // namespace db
\ No newline at end of file
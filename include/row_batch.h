@@ -0,0 +1,154 @@
+#pragma once
+
+#include "types.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace std;
+
+namespace db
+{
+
+    // ColumnVector - one column's values for every row of a batch
+    // Only the array matching the column's type is filled, so kernels loop over plain
+    // int32_t / double / uint8_t / string arrays with no per-value variant dispatch.
+    struct ColumnVector
+    {
+        DataType type = DataType::INTEGER; // Which array holds the values
+        vector<int32_t> ints;              // INTEGER values
+        vector<double> doubles;            // DOUBLE values
+        vector<uint8_t> bools;             // BOOLEAN values (0 / 1)
+        vector<string> strings;            // VARCHAR values
+
+        // Drop the values, keeping the arrays' capacity for the next batch
+        void clear()
+        {
+            ints.clear();
+            doubles.clear();
+            bools.clear();
+            strings.clear();
+        }
+
+        // The typed array of this column: data<int32_t>(), data<double>(), ...
+        template <typename C>
+        const vector<C> &data() const
+        {
+            if constexpr (is_same_v<C, int32_t>)
+                return ints;
+            else if constexpr (is_same_v<C, double>)
+                return doubles;
+            else if constexpr (is_same_v<C, uint8_t>)
+                return bools;
+            else
+                return strings;
+        }
+
+        // Append a value from a row (a value of another type, e.g. a placeholder, stores a zero value)
+        void append(Value &&value)
+        {
+            switch (type)
+            {
+            case DataType::INTEGER:
+                ints.push_back(holds_alternative<int32_t>(value) ? std::get<int32_t>(value) : 0);
+                break;
+            case DataType::DOUBLE:
+                doubles.push_back(holds_alternative<double>(value) ? std::get<double>(value) : 0.0);
+                break;
+            case DataType::BOOLEAN:
+                bools.push_back(holds_alternative<bool>(value) && std::get<bool>(value) ? 1 : 0);
+                break;
+            case DataType::VARCHAR:
+                strings.push_back(holds_alternative<string>(value) ? move(std::get<string>(value)) : string());
+                break;
+            }
+        }
+
+        // Copy one value out as a Value
+        Value get(size_t row) const
+        {
+            switch (type)
+            {
+            case DataType::INTEGER:
+                return ints[row];
+            case DataType::DOUBLE:
+                return doubles[row];
+            case DataType::BOOLEAN:
+                return bools[row] != 0;
+            case DataType::VARCHAR:
+            default:
+                return strings[row];
+            }
+        }
+
+        // Move one value out as a Value (the batch's string is left empty)
+        Value take(size_t row)
+        {
+            if (type == DataType::VARCHAR)
+            {
+                return move(strings[row]);
+            }
+            return get(row);
+        }
+    };
+
+    // RowBatch - up to CAPACITY rows stored column by column
+    // Every column holds size values. The selection vector lists, in increasing
+    // order, the positions of the rows still in the batch: filters shrink it rather
+    // than moving any column data, and later operators only visit the listed rows.
+    struct RowBatch
+    {
+        static constexpr size_t CAPACITY = 1024; // Rows per batch
+
+        size_t size = 0;              // Rows stored (filtered-out rows included)
+        vector<TupleId> ids;          // Tuple ID of each stored row
+        vector<ColumnVector> columns; // One vector per schema column
+        vector<uint32_t> selection;   // Positions of the rows that are still selected
+
+        // Empty the batch and shape its columns for a schema
+        void reset(const Schema &schema)
+        {
+            size = 0;
+            ids.clear();
+            selection.clear();
+            columns.resize(schema.columns.size());
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                columns[i].type = schema.columns[i].type;
+                columns[i].clear();
+            }
+        }
+
+        // Is there room for another row?
+        bool full() const { return size >= CAPACITY; }
+
+        // Rows still selected
+        size_t count() const { return selection.size(); }
+
+        // Append a row (values in schema order), selecting it
+        void appendRow(Tuple &&tuple)
+        {
+            ids.push_back(tuple.id);
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                columns[i].append(move(tuple.values[i]));
+            }
+            selection.push_back(static_cast<uint32_t>(size++));
+        }
+
+        // Move a stored row out as a Tuple
+        Tuple takeRow(uint32_t row)
+        {
+            Tuple tuple;
+            tuple.id = ids[row];
+            tuple.values.reserve(columns.size());
+            for (auto &column : columns)
+            {
+                tuple.values.push_back(column.take(row));
+            }
+            return tuple;
+        }
+    };
+
+} // namespace db
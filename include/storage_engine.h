@@ -2,9 +2,13 @@
 
 #include "types.h"
 #include "buffer_pool.h"
-#include "b_tree.h"
+#include "index.h"
+#include "bitmap_index.h"
+#include "expression.h"
 #include <unordered_map>
+#include <algorithm>
 #include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -22,6 +26,119 @@ namespace db
         TupleId tuple_id;           // Unique identifier for this row across entire database
     };
 
+    // TableIndex - one index on a table together with the columns it covers
+    // Multi-column (composite) indexes concatenate the encoded column values in
+    // order, so rows are sorted by the first column, then the second, and so on.
+    // INCLUDE columns are appended after the key columns: they don't change which
+    // rows a search finds, but let queries read those values straight from the index.
+    // A partial index has a predicate and only holds the rows that satisfy it.
+    struct TableIndex
+    {
+        string name;                    // Catalog name: columns joined with '+', plus type, INCLUDE and predicate tags
+        vector<string> columns;         // Indexed columns, most significant first
+        vector<int> column_ids;         // Positions of those columns in the schema
+        vector<string> include_columns; // Extra columns carried in each entry (covering index)
+        vector<int> include_ids;        // Positions of the INCLUDE columns in the schema
+        vector<Condition> predicate;    // WHERE conditions a row must meet to be indexed (empty = all rows)
+        vector<int> predicate_ids;      // Positions of the predicate columns in the schema
+        unique_ptr<Index> index;        // Data structure holding key -> tuple ID entries
+
+        // Does this index hold an entry for the row? (always true without a predicate)
+        bool holds(const Tuple &tuple) const
+        {
+            for (size_t i = 0; i < predicate.size(); i++)
+            {
+                if (!predicate[i].matches(tuple.values[predicate_ids[i]]))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Can a query with these conditions be answered from this index?
+        // Every row the query wants must be in the index, so the conditions have to
+        // imply each predicate condition (e.g. amount > 500 implies amount > 100)
+        bool answers(const vector<Condition> &conditions) const
+        {
+            for (const auto &required : predicate)
+            {
+                bool implied = false;
+                for (const auto &condition : conditions)
+                {
+                    if (condition.implies(required))
+                    {
+                        implied = true;
+                        break;
+                    }
+                }
+                if (!implied)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Build this index's entry key for a row (key columns, then INCLUDE columns)
+        string makeKey(const Tuple &tuple) const
+        {
+            string key;
+            for (int col_idx : column_ids)
+            {
+                appendKey(key, tuple.values[col_idx]);
+            }
+            for (int col_idx : include_ids)
+            {
+                appendKey(key, tuple.values[col_idx]);
+            }
+            return key;
+        }
+
+        // Does the index store every one of these schema columns?
+        bool covers(const vector<int> &col_ids) const
+        {
+            for (int col_idx : col_ids)
+            {
+                if (find(column_ids.begin(), column_ids.end(), col_idx) == column_ids.end() &&
+                    find(include_ids.begin(), include_ids.end(), col_idx) == include_ids.end())
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    // IndexInfo - a copy of one catalog entry, taken under the table latch
+    // Callers outside the table (metadata, statistics) read these instead of the live
+    // catalog, which writers and DROP INDEX change under the latch.
+    struct IndexInfo
+    {
+        string name;                    // Index name in the table's catalog
+        IndexType type;                 // Data structure behind the index
+        vector<string> columns;         // Indexed columns, most significant first
+        vector<string> include_columns; // Extra columns carried in each entry
+        vector<Condition> predicate;    // Partial index predicate (empty = all rows)
+        size_t entries;                 // Entries stored when the copy was taken
+    };
+
+    // One change made to a table while an index is being built online
+    struct IndexLogEntry
+    {
+        bool is_insert;   // true if the entry was added, false if it was removed
+        string key;       // Entry key, built with the new index's columns
+        TupleId tuple_id; // Row the entry points to
+    };
+
+    // IndexBuild - an index being built while writers keep running
+    // Writers append their changes to side_log; the builder replays them after its scan
+    struct IndexBuild
+    {
+        TableIndex table_index;         // The new index (not visible to queries yet)
+        vector<IndexLogEntry> side_log; // Changes made to the table since the build started
+    };
+
     // Table class - manages storage for one database table
     // Handles inserting, reading, updating, and deleting rows
     class Table
@@ -30,13 +147,29 @@ namespace db
         // Basic table information
         string name;           // Name of this table (like "users", "orders")
         Schema schema;         // Structure: what columns and types this table has
+        string file_path;      // Data file for this table (index files are stored next to it)
         PageId first_page_id;  // First page where this table's data is stored
+        PageId last_page_id;   // Last page in the page chain (new pages are linked after it)
         PageId next_page_id;   // Next available page ID for this table
         TupleId next_tuple_id; // Next available row ID (auto-incrementing)
 
         // Core storage components
-        unique_ptr<BufferPool> buffer_pool;                                // Manages pages in memory vs disk
-        unordered_map<string, unique_ptr<BTree<string, TupleId>>> indexes; // Fast lookup indexes
+        unique_ptr<BufferPool> buffer_pool;                // Manages pages in memory vs disk
+        unordered_map<string, TableIndex> indexes;      // Fast lookup indexes, keyed by index name
+        unordered_map<TupleId, PageId> tuple_directory; // Which page holds each row (for index fetches)
+        unordered_map<string, IndexBuild> index_builds; // Online index builds in progress, keyed by index name
+
+        // Table latch - guards pages, the tuple directory and the index catalog
+        // Recursive because public operations call each other (updateTuple -> insertTuple)
+        mutable recursive_mutex table_latch;
+
+        // Side log size small enough to replay while writers wait for the index switch
+        static constexpr size_t INDEX_LOG_SWITCH_THRESHOLD = 1024;
+
+        // Index snapshot files - set while files written at checkpoint (or loaded at
+        // startup) may exist; generation counts how often they were thrown away
+        bool index_snapshots_on_disk;
+        size_t index_snapshot_generation;
 
         // Helper methods for converting rows to/from disk storage format
 
@@ -44,7 +177,10 @@ namespace db
         size_t serializeTuple(const Tuple &tuple, vector<uint8_t> &buffer, size_t offset);
 
         // Convert raw bytes from disk back to a row object
-        Tuple deserializeTuple(const vector<uint8_t> &buffer, size_t offset);
+        // With a column mask, only flagged columns are decoded; the others are skipped
+        // over (VARCHAR bytes are never copied) and left as placeholder values
+        Tuple deserializeTuple(const vector<uint8_t> &buffer, size_t offset,
+                               const vector<bool> *decode_columns = nullptr);
 
         // Calculate how many bytes a row will need when stored
         size_t getTupleSize(const Tuple &tuple);
@@ -57,12 +193,83 @@ namespace db
         // Try to fit a row into a specific page
         bool insertTupleIntoPage(PageId page_id, const Tuple &tuple);
 
-        // Read all rows stored on a specific page
-        vector<Tuple> readTuplesFromPage(PageId page_id);
+        // Read all rows stored on a specific page (only the masked columns, if given)
+        vector<Tuple> readTuplesFromPage(PageId page_id, const vector<bool> *decode_columns = nullptr);
 
         // Load existing table data and metadata from disk
         void loadExistingTableData();
 
+        // Read one row by ID using the tuple directory (false if it doesn't exist)
+        bool fetchTuple(TupleId tuple_id, Tuple &tuple, const vector<bool> *decode_columns = nullptr);
+
+        // Rows matching the conditions and filter, decoding only the masked columns
+        // (nullptr = all) - selectWhere and the projecting path of selectColumns share it
+        vector<Tuple> selectRows(const vector<Condition> &conditions, const CompiledPredicate *filter,
+                                 const vector<bool> *decode_columns);
+
+        // Can every index (including ones being built) store the row's key?
+        // Rows that can't are refused before anything is written
+        bool fitsIndexes(const Tuple &tuple) const;
+
+        // Add a newly stored row to every index on this table
+        void addToIndexes(const Tuple &tuple);
+
+        // Remove a row's entries from every index on this table
+        void removeFromIndexes(const Tuple &tuple);
+
+        // Replay side log changes into an index being built (safe to replay twice)
+        static void applyIndexLog(TableIndex &table_index, const vector<IndexLogEntry> &side_log);
+
+        // Snapshot file for one index, next to the table file
+        string indexSnapshotPath(const string &index_name) const { return file_path + "." + index_name + ".snap"; }
+
+        // Page file of a disk-backed index (hash), next to the table file
+        string indexFilePath(const string &index_name) const { return file_path + "." + index_name + ".idx"; }
+
+        // Fill a new (empty) index from its snapshot file, then add the rows stored
+        // after the snapshot was taken. Returns false if there is no usable file
+        bool loadIndexSnapshot(TableIndex &table_index, IndexType type);
+
+        // Delete the snapshot files - called before a row they contain changes
+        void removeIndexSnapshots();
+
+        // Cut one row out of a page, sliding later rows down (false if not found)
+        bool removeTupleFromPage(PageId page_id, TupleId tuple_id);
+
+        // Check values against the schema, widening INTEGER literals for DOUBLE columns
+        // Returns false if the row has the wrong number or types of values
+        bool conformToSchema(vector<Value> &values) const;
+
+        // Pick the index that can answer the most conditions (nullptr if none helps)
+        // eq_columns receives how many leading index columns have an equality condition.
+        // If needed_columns is given, indexes covering all of them are preferred, and an
+        // ordered covering index is chosen even when no condition narrows it.
+        TableIndex *chooseIndex(const vector<Condition> &conditions, size_t &eq_columns,
+                                const vector<int> &needed_columns = {});
+
+        // The single-column bitmap index on column that can answer the conditions
+        // (nullptr if there is none)
+        TableIndex *findBitmapIndex(const string &column, const vector<Condition> &conditions);
+
+        // Rows that may satisfy a condition, from a bitmap index on its column
+        // Returns false if the column has no single-column bitmap index that can
+        // answer the query's conditions (a partial one must have its predicate implied)
+        bool conditionBitmap(const Condition &condition, const vector<Condition> &conditions,
+                             RoaringBitmap &rows);
+
+        // Rows that may satisfy a WHERE expression, from bitmap indexes alone: AND
+        // intersects, OR and IN unite, and a NOT under an AND is subtracted (AND NOT).
+        // Returns false if the expression needs rows no bitmap can name - a column
+        // without a bitmap index, IS NULL, or a NOT that is not under an AND. exact is
+        // set when rows holds no row the expression is false for. With rows == nullptr
+        // nothing is computed; the call only says whether the expression can be answered.
+        bool exprBitmap(const Expr &expr, const vector<Condition> &conditions, RoaringBitmap *rows, bool &exact);
+
+        // Visit the index entries (key, tuple ID) that can match the conditions,
+        // using an index chosen by chooseIndex
+        void scanIndex(const TableIndex &table_index, const vector<Condition> &conditions,
+                       size_t eq_columns, const IndexVisitor &visitor);
+
     public:
         // Constructor - create a new table with given name and structure
         Table(const string &name, const Schema &schema, const string &db_file_path);
@@ -78,6 +285,84 @@ namespace db
         // Get rows that match a condition (filtered query)
         vector<Tuple> selectWhere(const string &column, const Value &value);
 
+        // Get rows that match every condition (uses the best index when one applies)
+        // A filter, if given, is checked on every candidate row as well - conditions pick
+        // the index, the filter holds whatever they can't express (OR, NOT, IN, ...)
+        vector<Tuple> selectWhere(const vector<Condition> &conditions, const CompiledPredicate *filter = nullptr);
+
+        // Get only the listed columns of rows matching every condition (and the filter)
+        // Returned tuples hold values in the order of columns. When an index covers
+        // the columns, the conditions and the filter, rows are read from the index alone
+        // (index-only scan) and heap pages are never touched.
+        vector<Tuple> selectColumns(const vector<string> &columns, const vector<Condition> &conditions,
+                                    const CompiledPredicate *filter = nullptr);
+
+        // Row access for query operators (operator.h) - these pull rows a little at a
+        // time instead of materializing a whole result
+
+        // First page of the table's page chain, where sequential scans start
+        PageId getFirstPageId() const { return first_page_id; }
+
+        // Read the rows on one page (only the masked columns, if given) and the page
+        // after it in the chain (0 after the last). The table is latched and the page
+        // pinned only during the call, so a paused scan holds neither.
+        vector<Tuple> scanPage(PageId page_id, PageId &next_page, const vector<bool> *decode_columns = nullptr);
+
+        // Vectorized form of scanPage: decode rows straight from the page bytes into the
+        // batch's column vectors (no Tuple or Value per row), starting at the page's row
+        // number row, until the page ends or the batch is full. Advances row and returns
+        // true once the page's last row is decoded. Masked-out columns get zero values.
+        bool scanPageInto(PageId page_id, size_t &row, RowBatch &batch, PageId &next_page,
+                          const vector<bool> *decode_columns = nullptr);
+
+        // Copy one page's bytes (and find the page after it) under the table latch.
+        // Parallel scans copy pages this way, then decode them on their own threads.
+        void copyPage(PageId page_id, vector<uint8_t> &bytes, PageId &next_page);
+
+        // The decoding half of scanPageInto, over page bytes already copied out - takes
+        // no latch and changes nothing, so several threads may call it at once
+        bool decodePageInto(const uint8_t *data, size_t &row, RowBatch &batch,
+                            const vector<bool> *decode_columns = nullptr) const;
+
+        // IDs of the rows an index (or the bitmap indexes) says may match every condition
+        // Returns false if no index narrows the search - the caller has to scan instead.
+        // Given the whole WHERE expression, OR / NOT / IN on bitmap-indexed columns are
+        // answered from the bitmaps too, unless another index narrows the conditions.
+        bool findCandidates(const vector<Condition> &conditions, vector<TupleId> &tuple_ids,
+                            const Expr *where = nullptr);
+
+        // Would findCandidates use an index for these conditions (and WHERE expression)?
+        bool hasIndexFor(const vector<Condition> &conditions, const Expr *where = nullptr);
+
+        // Can one index answer the conditions while storing every needed column?
+        // (selectColumns then reads the rows from that index alone)
+        bool hasCoveringIndexFor(const vector<Condition> &conditions, const vector<int> &needed_columns);
+
+        // Name of an ordered index whose leading key columns are sort_columns and which
+        // holds every row the conditions can match ("" if there is none) - reading it in
+        // key order returns rows sorted ascending on those columns
+        string findOrderedIndex(const vector<int> &sort_columns, const vector<Condition> &conditions);
+
+        // Read an ordered index in key order, a chunk at a time: the entries with keys
+        // after last_key (from the first key when from_start is set), at least max_entries
+        // of them unless the index ends. A chunk always ends at a key boundary and sets
+        // last_key to its last key, so the next call resumes right after it.
+        // Returns false if the index no longer exists.
+        bool readIndexInOrder(const string &index_name, bool from_start, string &last_key, size_t max_entries,
+                              vector<TupleId> &tuple_ids);
+
+        // Name of an ordered index on every row whose leading key column is column ("" if
+        // there is none), preferring a B-tree - its first and last keys hold the column's
+        // smallest and largest values
+        string findBoundIndex(int column);
+
+        // Smallest (or largest) value of an index's leading column, read from its first
+        // (or last) key without a scan. Returns false if the index is empty or gone.
+        bool readIndexBound(const string &index_name, bool largest, Value &value);
+
+        // Read one row by ID (false if it no longer exists)
+        bool readTuple(TupleId tuple_id, Tuple &tuple, const vector<bool> *decode_columns = nullptr);
+
         // Remove a specific row by its ID
         bool deleteTuple(TupleId tuple_id);
 
@@ -86,12 +371,44 @@ namespace db
 
         // Index operations - create fast lookup structures for queries
 
-        // Build a B-tree index on a specific column for faster searching
-        void createIndex(const string &column_name);
+        // Build an index (B-tree by default) on a specific column for faster searching
+        bool createIndex(const string &column_name, IndexType type = IndexType::B_TREE);
+
+        // Build a composite index over several columns (keys are compared column by column)
+        // include_columns are stored in each entry so covered queries skip the heap.
+        // The build is online: writers on other threads are only held up for one page
+        // at a time, and their changes reach the new index before it is switched on.
+        // With a predicate the index is partial: only rows matching every condition get
+        // an entry, and only queries whose conditions imply the predicate use it.
+        bool createIndex(const vector<string> &column_names, IndexType type = IndexType::B_TREE,
+                         const vector<string> &include_columns = {},
+                         const vector<Condition> &predicate = {});
 
         // Use an index to quickly find rows matching a value (much faster than full scan)
         vector<Tuple> selectUsingIndex(const string &column, const Value &value);
 
+        // Remove an index by name (a full B-tree index is named after its columns joined
+        // with '+'; see listIndexes for the names of the others)
+        bool dropIndex(const string &index_name);
+
+        // Write a snapshot file for every memory-resident ordered index (at checkpoint)
+        // Files hold the sorted entries and the last tuple ID stored, so a restart can
+        // bulk-load each index and replay only newer rows instead of scanning the table.
+        // The first update or delete afterwards removes them.
+        void writeIndexSnapshots();
+
+        // Is there an index whose only key column is column?
+        bool hasIndexOn(const string &column) const;
+
+        // IDs of the rows whose column equals value, found through the column's indexes
+        // under the table latch (when only partial indexes that may not hold them exist,
+        // by a scan). Returns false if no index has column as its only key column.
+        bool lookupIndex(const string &column, const Value &value, vector<TupleId> &tuple_ids);
+
+        // A copy of this table's index catalog (indexes still being built online are not
+        // listed until they are switched on)
+        vector<IndexInfo> listIndexes() const;
+
         // Schema operations - access table structure information
 
         // Get the table's schema (column definitions)
@@ -102,7 +419,7 @@ namespace db
 
         // Statistics and monitoring
 
-        // Count how many rows are in this table
+        // Count how many rows are in this table (kept up to date, no scan)
         size_t getTupleCount() const;
 
         // Print debugging information about this table
@@ -148,6 +465,15 @@ namespace db
         vector<Tuple> selectWhere(const string &table_name,
                                   const string &column, const Value &value);
 
+        // Get rows from a table that match every condition (and the filter, if given)
+        vector<Tuple> selectWhere(const string &table_name, const vector<Condition> &conditions,
+                                  const CompiledPredicate *filter = nullptr);
+
+        // Get only the listed columns of matching rows (index-only when an index covers them)
+        vector<Tuple> selectColumns(const string &table_name, const vector<string> &columns,
+                                    const vector<Condition> &conditions,
+                                    const CompiledPredicate *filter = nullptr);
+
         // Delete a specific row from a table
         bool deleteTuple(const string &table_name, TupleId tuple_id);
 
@@ -158,7 +484,17 @@ namespace db
         // Index operations - improve query performance
 
         // Create an index on a column for faster lookups
-        bool createIndex(const string &table_name, const string &column_name);
+        bool createIndex(const string &table_name, const string &column_name,
+                         IndexType type = IndexType::B_TREE);
+
+        // Create a composite index over several columns of a table (partial with a predicate)
+        bool createIndex(const string &table_name, const vector<string> &column_names,
+                         IndexType type = IndexType::B_TREE,
+                         const vector<string> &include_columns = {},
+                         const vector<Condition> &predicate = {});
+
+        // Remove an index from a table
+        bool dropIndex(const string &table_name, const string &index_name);
 
         // Utility methods
 
@@ -170,6 +506,9 @@ namespace db
 
         // Flush all buffer pools to disk
         void flushAllPages();
+
+        // Write index snapshot files for every table (after flushAllPages at checkpoint)
+        void writeIndexSnapshots();
     };
 
 } // namespace db
\ No newline at end of file
@@ -39,7 +39,7 @@ namespace db
     // Tuple structure - represents one row of data in a table
     struct Tuple
     {
-        TupleId id;           // Unique identifier for this row
+        TupleId id = 0;       // Unique identifier for this row (0 = not assigned yet)
         vector<Value> values; // The actual column data (can be mixed types)
 
         // Default constructor creates empty tuple
@@ -71,6 +71,111 @@ namespace db
         {
             columns.emplace_back(name, type, size); // Create column object directly in vector
         }
+
+        // Helper method to find a column's position by name (-1 if it doesn't exist)
+        int findColumn(const string &name) const
+        {
+            for (size_t i = 0; i < columns.size(); i++)
+            {
+                if (columns[i].name == name)
+                {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1; // No column with this name
+        }
+    };
+
+    // Compare two values: negative if a < b, zero if equal, positive if a > b
+    // INTEGER and DOUBLE compare numerically; other mixed types order by type
+    inline int compareValues(const Value &a, const Value &b)
+    {
+        bool a_numeric = holds_alternative<int32_t>(a) || holds_alternative<double>(a);
+        bool b_numeric = holds_alternative<int32_t>(b) || holds_alternative<double>(b);
+        if (a_numeric && b_numeric && a.index() != b.index())
+        {
+            double x = holds_alternative<int32_t>(a) ? get<int32_t>(a) : get<double>(a);
+            double y = holds_alternative<int32_t>(b) ? get<int32_t>(b) : get<double>(b);
+            return x < y ? -1 : (x > y ? 1 : 0);
+        }
+        if (a.index() != b.index())
+        {
+            return a.index() < b.index() ? -1 : 1;
+        }
+        return a < b ? -1 : (b < a ? 1 : 0);
+    }
+
+    // Comparison operators allowed in WHERE conditions
+    enum class CompareOp
+    {
+        EQ, // column = value
+        LT, // column < value
+        LE, // column <= value
+        GT, // column > value
+        GE  // column >= value
+    };
+
+    // One WHERE condition: column <op> value (a WHERE clause is an AND of these)
+    struct Condition
+    {
+        string column;                // Column being tested
+        CompareOp op = CompareOp::EQ; // How the column is compared
+        Value value;                  // Constant on the right-hand side
+
+        Condition() = default;
+        Condition(string column, CompareOp op, Value value)
+            : column(move(column)), op(op), value(move(value)) {}
+
+        // Does a column value satisfy this condition?
+        bool matches(const Value &column_value) const
+        {
+            int cmp = compareValues(column_value, value);
+            switch (op)
+            {
+            case CompareOp::EQ:
+                return cmp == 0;
+            case CompareOp::LT:
+                return cmp < 0;
+            case CompareOp::LE:
+                return cmp <= 0;
+            case CompareOp::GT:
+                return cmp > 0;
+            case CompareOp::GE:
+                return cmp >= 0;
+            }
+            return false;
+        }
+
+        // Does every value satisfying this condition also satisfy other?
+        // Used to check that a query's WHERE clause implies a partial index predicate
+        bool implies(const Condition &other) const
+        {
+            if (column != other.column)
+            {
+                return false;
+            }
+            if (op == CompareOp::EQ)
+            {
+                return other.matches(value); // A single value - test it directly
+            }
+
+            int cmp = compareValues(value, other.value);
+            bool upper = op == CompareOp::LT || op == CompareOp::LE;
+            switch (other.op)
+            {
+            case CompareOp::EQ:
+                return false; // A range never pins one value
+            case CompareOp::LT:
+                return upper && (cmp < 0 || (cmp == 0 && op == CompareOp::LT));
+            case CompareOp::LE:
+                return upper && cmp <= 0;
+            case CompareOp::GT:
+                return !upper && (cmp > 0 || (cmp == 0 && op == CompareOp::GT));
+            case CompareOp::GE:
+                return !upper && cmp >= 0;
+            }
+            return false;
+        }
     };
 
     // Page header structure - metadata stored at the beginning of each 4KB page
@@ -112,14 +217,18 @@ namespace db
         UPDATE,       // Modify existing rows
         DELETE,       // Remove rows from tables
         CREATE_TABLE, // Create new table structure
-        DROP_TABLE    // Delete entire table
+        DROP_TABLE,   // Delete entire table
+        CREATE_INDEX  // Build an index on a table column
     };
 
     // Index types - different data structures for fast data lookup
     enum class IndexType
     {
         B_TREE, // Balanced tree index - good for range queries and sorted access
-        HASH    // Hash table index - very fast for exact matches
+        HASH,   // Hash table index - very fast for exact matches
+        ART,    // Adaptive radix tree - in-memory, fastest point lookups, also ordered
+        BITMAP, // Compressed bitmap per distinct value - for low-cardinality columns
+        LEARNED // Piecewise-linear models over sorted keys - experimental, single INTEGER column
     };
 
 } // namespace db
\ No newline at end of file
@@ -0,0 +1,744 @@
+#include "art.h"
+#include <algorithm>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace db
+{
+    // AdaptiveRadixTree implementation - insert, point lookup and ordered scans
+
+    // Turn a leaf held through a base pointer back into a leaf pointer
+    static unique_ptr<ArtLeaf> takeLeaf(unique_ptr<ArtNode> node)
+    {
+        return unique_ptr<ArtLeaf>(static_cast<ArtLeaf *>(node.release()));
+    }
+
+    // Move the fields every inner node shares when a node changes size class
+    static void moveInnerHeader(ArtInnerNode *from, ArtInnerNode *to)
+    {
+        to->prefix = move(from->prefix);
+        to->terminal = move(from->terminal);
+        to->child_count = from->child_count;
+    }
+
+    // Find the child slot for a key byte
+    unique_ptr<ArtNode> *AdaptiveRadixTree::findChild(ArtInnerNode *node, uint8_t byte)
+    {
+        switch (node->type)
+        {
+        case ArtNodeType::NODE4:
+        {
+            auto n = static_cast<ArtNode4 *>(node);
+            for (uint16_t i = 0; i < n->child_count; i++)
+            {
+                if (n->keys[i] == byte)
+                {
+                    return &n->children[i];
+                }
+            }
+            return nullptr;
+        }
+        case ArtNodeType::NODE16:
+        {
+            auto n = static_cast<ArtNode16 *>(node);
+#if defined(__SSE2__)
+            // Compare all 16 key bytes at once, mask off unused slots
+            __m128i cmp = _mm_cmpeq_epi8(_mm_set1_epi8(static_cast<char>(byte)),
+                                         _mm_loadu_si128(reinterpret_cast<const __m128i *>(n->keys)));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(cmp)) & ((1u << n->child_count) - 1);
+            if (mask)
+            {
+                return &n->children[__builtin_ctz(mask)];
+            }
+            return nullptr;
+#else
+            auto end = n->keys + n->child_count;
+            auto it = lower_bound(n->keys, end, byte); // Keys are kept sorted
+            if (it != end && *it == byte)
+            {
+                return &n->children[it - n->keys];
+            }
+            return nullptr;
+#endif
+        }
+        case ArtNodeType::NODE48:
+        {
+            auto n = static_cast<ArtNode48 *>(node);
+            uint8_t slot = n->child_index[byte];
+            return slot ? &n->children[slot - 1] : nullptr;
+        }
+        case ArtNodeType::NODE256:
+        {
+            auto n = static_cast<ArtNode256 *>(node);
+            return n->children[byte] ? &n->children[byte] : nullptr;
+        }
+        default:
+            return nullptr;
+        }
+    }
+
+    // Insert a child into a sorted key/child array of a Node4 or Node16
+    template <typename NodeT>
+    static void insertSorted(NodeT *node, uint8_t byte, unique_ptr<ArtNode> child)
+    {
+        uint16_t pos = 0;
+        while (pos < node->child_count && node->keys[pos] < byte)
+        {
+            pos++;
+        }
+        for (uint16_t i = node->child_count; i > pos; i--)
+        {
+            node->keys[i] = node->keys[i - 1];
+            node->children[i] = move(node->children[i - 1]);
+        }
+        node->keys[pos] = byte;
+        node->children[pos] = move(child);
+        node->child_count++;
+    }
+
+    // Add a child to an inner node, growing it to the next node size if needed
+    void AdaptiveRadixTree::addChild(unique_ptr<ArtNode> &node_ref, uint8_t byte, unique_ptr<ArtNode> child)
+    {
+        switch (node_ref->type)
+        {
+        case ArtNodeType::NODE4:
+        {
+            auto n = static_cast<ArtNode4 *>(node_ref.get());
+            if (n->child_count < 4)
+            {
+                insertSorted(n, byte, move(child));
+                return;
+            }
+            // Full - grow into a Node16
+            auto bigger = make_unique<ArtNode16>();
+            moveInnerHeader(n, bigger.get());
+            for (uint16_t i = 0; i < 4; i++)
+            {
+                bigger->keys[i] = n->keys[i];
+                bigger->children[i] = move(n->children[i]);
+            }
+            insertSorted(bigger.get(), byte, move(child));
+            node_ref = move(bigger);
+            return;
+        }
+        case ArtNodeType::NODE16:
+        {
+            auto n = static_cast<ArtNode16 *>(node_ref.get());
+            if (n->child_count < 16)
+            {
+                insertSorted(n, byte, move(child));
+                return;
+            }
+            // Full - grow into a Node48
+            auto bigger = make_unique<ArtNode48>();
+            moveInnerHeader(n, bigger.get());
+            for (uint16_t i = 0; i < 16; i++)
+            {
+                bigger->child_index[n->keys[i]] = static_cast<uint8_t>(i + 1);
+                bigger->children[i] = move(n->children[i]);
+            }
+            node_ref = move(bigger);
+            addChild(node_ref, byte, move(child));
+            return;
+        }
+        case ArtNodeType::NODE48:
+        {
+            auto n = static_cast<ArtNode48 *>(node_ref.get());
+            if (n->child_count < 48)
+            {
+                uint8_t slot = 0;
+                while (n->children[slot])
+                {
+                    slot++; // First free slot
+                }
+                n->children[slot] = move(child);
+                n->child_index[byte] = static_cast<uint8_t>(slot + 1);
+                n->child_count++;
+                return;
+            }
+            // Full - grow into a Node256
+            auto bigger = make_unique<ArtNode256>();
+            moveInnerHeader(n, bigger.get());
+            for (int b = 0; b < 256; b++)
+            {
+                if (n->child_index[b])
+                {
+                    bigger->children[b] = move(n->children[n->child_index[b] - 1]);
+                }
+            }
+            node_ref = move(bigger);
+            addChild(node_ref, byte, move(child));
+            return;
+        }
+        case ArtNodeType::NODE256:
+        {
+            auto n = static_cast<ArtNode256 *>(node_ref.get());
+            n->children[byte] = move(child);
+            n->child_count++;
+            return;
+        }
+        default:
+            return;
+        }
+    }
+
+    // Remove the child under a byte - sorted arrays close the gap, Node48
+    // frees its slot and Node256 just clears the pointer. A node then shrinks
+    // one size class when it falls well below the next class's capacity (a
+    // little under, so a key added and removed at the boundary doesn't make
+    // the node grow and shrink every time).
+    void AdaptiveRadixTree::removeChild(unique_ptr<ArtNode> &node_ref, uint8_t byte)
+    {
+        auto remove_sorted = [&](auto *n)
+        {
+            uint16_t pos = 0;
+            while (pos < n->child_count && n->keys[pos] != byte)
+            {
+                pos++;
+            }
+            if (pos == n->child_count)
+            {
+                return;
+            }
+            for (uint16_t i = pos; i + 1 < n->child_count; i++)
+            {
+                n->keys[i] = n->keys[i + 1];
+                n->children[i] = move(n->children[i + 1]);
+            }
+            n->child_count--;
+            n->keys[n->child_count] = 0;
+            n->children[n->child_count].reset();
+        };
+
+        switch (node_ref->type)
+        {
+        case ArtNodeType::NODE4:
+            remove_sorted(static_cast<ArtNode4 *>(node_ref.get()));
+            return;
+        case ArtNodeType::NODE16:
+        {
+            auto n = static_cast<ArtNode16 *>(node_ref.get());
+            remove_sorted(n);
+            if (n->child_count > 3)
+            {
+                return;
+            }
+            // Sparse - shrink into a Node4
+            auto smaller = make_unique<ArtNode4>();
+            moveInnerHeader(n, smaller.get());
+            for (uint16_t i = 0; i < n->child_count; i++)
+            {
+                smaller->keys[i] = n->keys[i];
+                smaller->children[i] = move(n->children[i]);
+            }
+            node_ref = move(smaller);
+            return;
+        }
+        case ArtNodeType::NODE48:
+        {
+            auto n = static_cast<ArtNode48 *>(node_ref.get());
+            uint8_t slot = n->child_index[byte];
+            if (!slot)
+            {
+                return;
+            }
+            n->children[slot - 1].reset();
+            n->child_index[byte] = 0;
+            n->child_count--;
+            if (n->child_count > 12)
+            {
+                return;
+            }
+            // Sparse - shrink into a Node16 (bytes taken in order keep its keys sorted)
+            auto smaller = make_unique<ArtNode16>();
+            moveInnerHeader(n, smaller.get());
+            uint16_t pos = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                if (n->child_index[b])
+                {
+                    smaller->keys[pos] = static_cast<uint8_t>(b);
+                    smaller->children[pos++] = move(n->children[n->child_index[b] - 1]);
+                }
+            }
+            node_ref = move(smaller);
+            return;
+        }
+        case ArtNodeType::NODE256:
+        {
+            // The slot alone can't tell - the caller may already have emptied it - so
+            // this relies on callers only removing a byte they found a child under
+            auto n = static_cast<ArtNode256 *>(node_ref.get());
+            n->children[byte].reset();
+            n->child_count--;
+            if (n->child_count > 36)
+            {
+                return;
+            }
+            // Sparse - shrink into a Node48
+            auto smaller = make_unique<ArtNode48>();
+            moveInnerHeader(n, smaller.get());
+            uint8_t slot = 0;
+            for (int b = 0; b < 256; b++)
+            {
+                if (n->children[b])
+                {
+                    smaller->children[slot] = move(n->children[b]);
+                    smaller->child_index[b] = ++slot;
+                }
+            }
+            node_ref = move(smaller);
+            return;
+        }
+        default:
+            return;
+        }
+    }
+
+    // Path re-compression after a remove - a Node4 with one child adds nothing but a
+    // level, so the child takes its place and inherits the bytes the node consumed
+    void AdaptiveRadixTree::collapseNode(unique_ptr<ArtNode> &node_ref)
+    {
+        if (node_ref->type != ArtNodeType::NODE4)
+        {
+            return; // Larger classes shrink to a Node4 long before one child is left
+        }
+        auto n = static_cast<ArtNode4 *>(node_ref.get());
+        if (n->child_count != 1 || n->terminal)
+        {
+            return;
+        }
+
+        unique_ptr<ArtNode> child = move(n->children[0]);
+        if (child->type != ArtNodeType::LEAF)
+        {
+            // Leaves hold their full key; an inner child's path grows by the node's
+            child->prefix = n->prefix + static_cast<char>(n->keys[0]) + child->prefix;
+        }
+        node_ref = move(child);
+    }
+
+    // Hang a leaf below a fresh inner node - as the terminal leaf if its key
+    // ends here, otherwise under the key byte at this depth
+    void AdaptiveRadixTree::attachLeaf(unique_ptr<ArtNode> &inner_ref, unique_ptr<ArtLeaf> leaf, size_t depth)
+    {
+        if (depth == leaf->key.size())
+        {
+            static_cast<ArtInnerNode *>(inner_ref.get())->terminal = move(leaf);
+        }
+        else
+        {
+            uint8_t byte = static_cast<uint8_t>(leaf->key[depth]);
+            addChild(inner_ref, byte, move(leaf));
+        }
+    }
+
+    // Recursive insert - handles leaf splits and compressed prefix mismatches
+    void AdaptiveRadixTree::insertRecursive(unique_ptr<ArtNode> &node_ref, const string &key,
+                                            size_t depth, TupleId tuple_id)
+    {
+        if (!node_ref)
+        {
+            // Empty slot - a single leaf holds the whole key
+            auto leaf = make_unique<ArtLeaf>(key);
+            leaf->tuple_ids.push_back(tuple_id);
+            node_ref = move(leaf);
+            entry_count++;
+            return;
+        }
+
+        if (node_ref->type == ArtNodeType::LEAF)
+        {
+            auto leaf = static_cast<ArtLeaf *>(node_ref.get());
+            if (leaf->key == key)
+            {
+                leaf->tuple_ids.push_back(tuple_id); // Duplicate key - add row to leaf
+                entry_count++;
+                return;
+            }
+
+            // Two different keys - new Node4 holds the bytes they share
+            size_t common = 0;
+            while (depth + common < key.size() && depth + common < leaf->key.size() &&
+                   key[depth + common] == leaf->key[depth + common])
+            {
+                common++;
+            }
+
+            auto inner = make_unique<ArtNode4>();
+            inner->prefix = key.substr(depth, common);
+            unique_ptr<ArtNode> inner_ref = move(inner);
+
+            auto new_leaf = make_unique<ArtLeaf>(key);
+            new_leaf->tuple_ids.push_back(tuple_id);
+            attachLeaf(inner_ref, takeLeaf(move(node_ref)), depth + common);
+            attachLeaf(inner_ref, move(new_leaf), depth + common);
+
+            node_ref = move(inner_ref);
+            entry_count++;
+            return;
+        }
+
+        auto inner = static_cast<ArtInnerNode *>(node_ref.get());
+
+        // Compare the key against this node's compressed path
+        size_t matched = 0;
+        while (matched < inner->prefix.size() && depth + matched < key.size() &&
+               inner->prefix[matched] == key[depth + matched])
+        {
+            matched++;
+        }
+
+        if (matched < inner->prefix.size())
+        {
+            // Key leaves the compressed path - split the path with a new Node4
+            auto parent = make_unique<ArtNode4>();
+            parent->prefix = inner->prefix.substr(0, matched);
+            uint8_t old_byte = static_cast<uint8_t>(inner->prefix[matched]);
+            inner->prefix = inner->prefix.substr(matched + 1);
+
+            unique_ptr<ArtNode> parent_ref = move(parent);
+            addChild(parent_ref, old_byte, move(node_ref));
+
+            auto new_leaf = make_unique<ArtLeaf>(key);
+            new_leaf->tuple_ids.push_back(tuple_id);
+            attachLeaf(parent_ref, move(new_leaf), depth + matched);
+
+            node_ref = move(parent_ref);
+            entry_count++;
+            return;
+        }
+
+        depth += inner->prefix.size();
+        if (depth == key.size())
+        {
+            // Key ends exactly at this node
+            if (!inner->terminal)
+            {
+                inner->terminal = make_unique<ArtLeaf>(key);
+            }
+            inner->terminal->tuple_ids.push_back(tuple_id);
+            entry_count++;
+            return;
+        }
+
+        auto child = findChild(inner, static_cast<uint8_t>(key[depth]));
+        if (child)
+        {
+            insertRecursive(*child, key, depth + 1, tuple_id); // Descend one byte
+            return;
+        }
+
+        auto new_leaf = make_unique<ArtLeaf>(key);
+        new_leaf->tuple_ids.push_back(tuple_id);
+        addChild(node_ref, static_cast<uint8_t>(key[depth]), move(new_leaf));
+        entry_count++;
+    }
+
+    // Insert a key -> tuple ID mapping
+    void AdaptiveRadixTree::insert(const string &key, TupleId tuple_id)
+    {
+        insertRecursive(root, key, 0, tuple_id);
+    }
+
+    // Remove a row from the leaf holding key
+    // A leaf left without rows is unlinked; an inner node left without children
+    // is replaced by its terminal leaf (or removed if it has none), and one left
+    // with a single child and no terminal leaf is merged into that child
+    bool AdaptiveRadixTree::removeRecursive(unique_ptr<ArtNode> &node_ref, const string &key,
+                                            size_t depth, TupleId tuple_id)
+    {
+        if (!node_ref)
+        {
+            return false;
+        }
+
+        auto remove_from_leaf = [&](ArtLeaf *leaf)
+        {
+            auto it = find(leaf->tuple_ids.begin(), leaf->tuple_ids.end(), tuple_id);
+            if (leaf->key != key || it == leaf->tuple_ids.end())
+            {
+                return false;
+            }
+            leaf->tuple_ids.erase(it);
+            entry_count--;
+            return true;
+        };
+
+        if (node_ref->type == ArtNodeType::LEAF)
+        {
+            if (!remove_from_leaf(static_cast<ArtLeaf *>(node_ref.get())))
+            {
+                return false;
+            }
+            if (static_cast<ArtLeaf *>(node_ref.get())->tuple_ids.empty())
+            {
+                node_ref.reset(); // Parent unlinks the empty slot
+            }
+            return true;
+        }
+
+        auto inner = static_cast<ArtInnerNode *>(node_ref.get());
+        size_t prefix_length = inner->prefix.size();
+        if (key.size() - depth < prefix_length || key.compare(depth, prefix_length, inner->prefix) != 0)
+        {
+            return false; // Key diverges from the compressed path
+        }
+        depth += prefix_length;
+
+        bool removed;
+        if (depth == key.size())
+        {
+            removed = inner->terminal && remove_from_leaf(inner->terminal.get());
+            if (removed && inner->terminal->tuple_ids.empty())
+            {
+                inner->terminal.reset();
+            }
+        }
+        else
+        {
+            uint8_t byte = static_cast<uint8_t>(key[depth]);
+            auto child = findChild(inner, byte);
+            removed = child && removeRecursive(*child, key, depth + 1, tuple_id);
+            if (removed && !*child)
+            {
+                removeChild(node_ref, byte);
+                inner = static_cast<ArtInnerNode *>(node_ref.get()); // May have shrunk
+            }
+        }
+
+        // Leaves hold their full key, so a terminal leaf can stand in for its node
+        if (removed && inner->child_count == 0)
+        {
+            node_ref = move(inner->terminal);
+        }
+        else if (removed && inner->child_count == 1)
+        {
+            collapseNode(node_ref);
+        }
+        return removed;
+    }
+
+    // Remove a key -> tuple ID mapping
+    bool AdaptiveRadixTree::remove(const string &key, TupleId tuple_id)
+    {
+        return removeRecursive(root, key, 0, tuple_id);
+    }
+
+    // Point lookup - one node per key byte, compressed paths compared in bulk
+    const vector<TupleId> *AdaptiveRadixTree::search(const string &key) const
+    {
+        ArtNode *node = root.get();
+        size_t depth = 0;
+
+        while (node)
+        {
+            if (node->type == ArtNodeType::LEAF)
+            {
+                auto leaf = static_cast<ArtLeaf *>(node);
+                return leaf->key == key ? &leaf->tuple_ids : nullptr; // Verify full key
+            }
+
+            auto inner = static_cast<ArtInnerNode *>(node);
+            size_t prefix_length = inner->prefix.size();
+            if (key.size() - depth < prefix_length || key.compare(depth, prefix_length, inner->prefix) != 0)
+            {
+                return nullptr; // Key diverges from the compressed path
+            }
+            depth += prefix_length;
+
+            if (depth == key.size())
+            {
+                return inner->terminal ? &inner->terminal->tuple_ids : nullptr;
+            }
+
+            auto child = findChild(inner, static_cast<uint8_t>(key[depth]));
+            node = child ? child->get() : nullptr;
+            depth++;
+        }
+
+        return nullptr;
+    }
+
+    // Largest key - the last child at every level (children sort after a terminal leaf)
+    const string *AdaptiveRadixTree::maxKey() const
+    {
+        ArtNode *node = root.get();
+        while (node && node->type != ArtNodeType::LEAF)
+        {
+            auto inner = static_cast<ArtInnerNode *>(node);
+            ArtNode *last = nullptr;
+            switch (inner->type)
+            {
+            case ArtNodeType::NODE4:
+            {
+                auto n = static_cast<ArtNode4 *>(inner);
+                last = n->child_count ? n->children[n->child_count - 1].get() : nullptr;
+                break;
+            }
+            case ArtNodeType::NODE16:
+            {
+                auto n = static_cast<ArtNode16 *>(inner);
+                last = n->child_count ? n->children[n->child_count - 1].get() : nullptr;
+                break;
+            }
+            case ArtNodeType::NODE48:
+            {
+                auto n = static_cast<ArtNode48 *>(inner);
+                for (int b = 255; !last && b >= 0; b--)
+                {
+                    last = n->child_index[b] ? n->children[n->child_index[b] - 1].get() : nullptr;
+                }
+                break;
+            }
+            case ArtNodeType::NODE256:
+            {
+                auto n = static_cast<ArtNode256 *>(inner);
+                for (int b = 255; !last && b >= 0; b--)
+                {
+                    last = n->children[b].get();
+                }
+                break;
+            }
+            default:
+                break;
+            }
+            node = last ? last : inner->terminal.get();
+        }
+        return node ? &static_cast<ArtLeaf *>(node)->key : nullptr;
+    }
+
+    // Report a leaf's rows if it lies inside the range
+    // Returns false once keys are past the upper bound (scan can stop)
+    bool AdaptiveRadixTree::visitLeaf(ArtLeaf *leaf, const KeyRange &range, const IndexVisitor &visitor)
+    {
+        if (!range.aboveLow(leaf->key))
+        {
+            return true; // Below range - keep going
+        }
+        if (!range.belowHigh(leaf->key))
+        {
+            return false; // Above range - everything after is too
+        }
+        for (TupleId tuple_id : leaf->tuple_ids)
+        {
+            if (!visitor(leaf->key, tuple_id))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // In-order traversal - children are visited in byte order, which is key order
+    // Subtrees whose path already falls outside the range are skipped
+    bool AdaptiveRadixTree::scanRecursive(ArtNode *node, string &path, const KeyRange &range,
+                                          const IndexVisitor &visitor)
+    {
+        if (node->type == ArtNodeType::LEAF)
+        {
+            return visitLeaf(static_cast<ArtLeaf *>(node), range, visitor);
+        }
+
+        auto inner = static_cast<ArtInnerNode *>(node);
+        size_t saved_length = path.size();
+        path += inner->prefix;
+
+        // Every key below starts with path - compare it against the bounds
+        if (range.has_high)
+        {
+            size_t n = min(path.size(), range.high.size());
+            int cmp = path.compare(0, n, range.high, 0, n);
+            if (cmp > 0 || (cmp == 0 && path.size() > range.high.size()))
+            {
+                path.resize(saved_length);
+                return false; // Whole subtree is above the range
+            }
+        }
+        if (range.has_low)
+        {
+            size_t n = min(path.size(), range.low.size());
+            if (path.compare(0, n, range.low, 0, n) < 0)
+            {
+                path.resize(saved_length);
+                return true; // Whole subtree is below the range
+            }
+        }
+
+        // A key ending here is shorter than (so sorts before) all children
+        bool keep_going = !inner->terminal || visitLeaf(inner->terminal.get(), range, visitor);
+
+        auto visit_child = [&](uint8_t byte, ArtNode *child)
+        {
+            path.push_back(static_cast<char>(byte));
+            keep_going = scanRecursive(child, path, range, visitor);
+            path.pop_back();
+        };
+
+        switch (inner->type)
+        {
+        case ArtNodeType::NODE4:
+        {
+            auto n = static_cast<ArtNode4 *>(inner);
+            for (uint16_t i = 0; keep_going && i < n->child_count; i++)
+            {
+                visit_child(n->keys[i], n->children[i].get());
+            }
+            break;
+        }
+        case ArtNodeType::NODE16:
+        {
+            auto n = static_cast<ArtNode16 *>(inner);
+            for (uint16_t i = 0; keep_going && i < n->child_count; i++)
+            {
+                visit_child(n->keys[i], n->children[i].get());
+            }
+            break;
+        }
+        case ArtNodeType::NODE48:
+        {
+            auto n = static_cast<ArtNode48 *>(inner);
+            for (int b = 0; keep_going && b < 256; b++)
+            {
+                if (n->child_index[b])
+                {
+                    visit_child(static_cast<uint8_t>(b), n->children[n->child_index[b] - 1].get());
+                }
+            }
+            break;
+        }
+        case ArtNodeType::NODE256:
+        {
+            auto n = static_cast<ArtNode256 *>(inner);
+            for (int b = 0; keep_going && b < 256; b++)
+            {
+                if (n->children[b])
+                {
+                    visit_child(static_cast<uint8_t>(b), n->children[b].get());
+                }
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        path.resize(saved_length);
+        return keep_going;
+    }
+
+    // Visit all keys inside the range in ascending order
+    void AdaptiveRadixTree::scanRange(const KeyRange &range, const IndexVisitor &visitor)
+    {
+        if (!root)
+        {
+            return; // Empty tree
+        }
+        string path;
+        scanRecursive(root.get(), path, range, visitor);
+    }
+
+} // namespace db
@@ -0,0 +1,506 @@
+#include "bitmap_index.h"
+#include <algorithm>
+#include <iterator>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace std;
+
+namespace db
+{
+    // Word-wise bitset operations - 128 bits per instruction when SSE2 is available
+    enum class BitOp
+    {
+        AND,
+        OR,
+        AND_NOT
+    };
+
+    static void combineBitsets(const uint64_t *a, const uint64_t *b, uint64_t *out, size_t words, BitOp op)
+    {
+        size_t w = 0;
+#if defined(__SSE2__)
+        for (; w + 2 <= words; w += 2)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + w));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + w));
+            __m128i r = op == BitOp::AND  ? _mm_and_si128(x, y)
+                        : op == BitOp::OR ? _mm_or_si128(x, y)
+                                          : _mm_andnot_si128(y, x); // x AND NOT y
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + w), r);
+        }
+#endif
+        for (; w < words; w++)
+        {
+            out[w] = op == BitOp::AND  ? (a[w] & b[w])
+                     : op == BitOp::OR ? (a[w] | b[w])
+                                       : (a[w] & ~b[w]);
+        }
+    }
+
+    // Number of set bits in a bitset
+    static uint32_t countBits(const vector<uint64_t> &bits)
+    {
+        uint32_t count = 0;
+        for (uint64_t word : bits)
+        {
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+
+    // Container implementation
+
+    bool RoaringBitmap::Container::contains(uint16_t low) const
+    {
+        if (isBitset())
+        {
+            return (bits[low >> 6] >> (low & 63)) & 1;
+        }
+        return binary_search(array.begin(), array.end(), low);
+    }
+
+    bool RoaringBitmap::Container::add(uint16_t low)
+    {
+        if (isBitset())
+        {
+            uint64_t mask = 1ULL << (low & 63);
+            if (bits[low >> 6] & mask)
+            {
+                return false;
+            }
+            bits[low >> 6] |= mask;
+            cardinality++;
+            return true;
+        }
+
+        auto it = lower_bound(array.begin(), array.end(), low);
+        if (it != array.end() && *it == low)
+        {
+            return false;
+        }
+        array.insert(it, low);
+        cardinality++;
+        normalize(); // Array may have outgrown its limit
+        return true;
+    }
+
+    bool RoaringBitmap::Container::remove(uint16_t low)
+    {
+        if (isBitset())
+        {
+            uint64_t mask = 1ULL << (low & 63);
+            if (!(bits[low >> 6] & mask))
+            {
+                return false;
+            }
+            bits[low >> 6] &= ~mask;
+            cardinality--;
+            normalize(); // Sparse again - go back to an array
+            return true;
+        }
+
+        auto it = lower_bound(array.begin(), array.end(), low);
+        if (it == array.end() || *it != low)
+        {
+            return false;
+        }
+        array.erase(it);
+        cardinality--;
+        return true;
+    }
+
+    // Convert between array and bitset form at ARRAY_MAX values
+    void RoaringBitmap::Container::normalize()
+    {
+        if (isBitset() && cardinality <= ARRAY_MAX)
+        {
+            array.clear();
+            array.reserve(cardinality);
+            for (size_t w = 0; w < BITSET_WORDS; w++)
+            {
+                for (uint64_t word = bits[w]; word != 0; word &= word - 1)
+                {
+                    array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+            bits.clear();
+            bits.shrink_to_fit();
+        }
+        else if (!isBitset() && cardinality > ARRAY_MAX)
+        {
+            bits.assign(BITSET_WORDS, 0);
+            for (uint16_t low : array)
+            {
+                bits[low >> 6] |= 1ULL << (low & 63);
+            }
+            array.clear();
+            array.shrink_to_fit();
+        }
+    }
+
+    RoaringBitmap::Container RoaringBitmap::andContainers(const Container &a, const Container &b)
+    {
+        Container result;
+        if (a.isBitset() && b.isBitset())
+        {
+            result.bits.resize(BITSET_WORDS);
+            combineBitsets(a.bits.data(), b.bits.data(), result.bits.data(), BITSET_WORDS, BitOp::AND);
+            result.cardinality = countBits(result.bits);
+        }
+        else if (!a.isBitset() && !b.isBitset())
+        {
+            set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                             back_inserter(result.array));
+            result.cardinality = result.array.size();
+        }
+        else
+        {
+            // Probe the bitset with each array value
+            const Container &sparse = a.isBitset() ? b : a;
+            const Container &dense = a.isBitset() ? a : b;
+            for (uint16_t low : sparse.array)
+            {
+                if (dense.contains(low))
+                {
+                    result.array.push_back(low);
+                }
+            }
+            result.cardinality = result.array.size();
+        }
+        result.normalize();
+        return result;
+    }
+
+    RoaringBitmap::Container RoaringBitmap::orContainers(const Container &a, const Container &b)
+    {
+        Container result;
+        if (a.isBitset() && b.isBitset())
+        {
+            result.bits.resize(BITSET_WORDS);
+            combineBitsets(a.bits.data(), b.bits.data(), result.bits.data(), BITSET_WORDS, BitOp::OR);
+            result.cardinality = countBits(result.bits);
+        }
+        else if (!a.isBitset() && !b.isBitset())
+        {
+            set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                      back_inserter(result.array));
+            result.cardinality = result.array.size();
+        }
+        else
+        {
+            // Set each array value in a copy of the bitset
+            const Container &sparse = a.isBitset() ? b : a;
+            result = a.isBitset() ? a : b;
+            for (uint16_t low : sparse.array)
+            {
+                result.add(low);
+            }
+        }
+        result.normalize();
+        return result;
+    }
+
+    RoaringBitmap::Container RoaringBitmap::andNotContainers(const Container &a, const Container &b)
+    {
+        Container result;
+        if (a.isBitset() && b.isBitset())
+        {
+            result.bits.resize(BITSET_WORDS);
+            combineBitsets(a.bits.data(), b.bits.data(), result.bits.data(), BITSET_WORDS, BitOp::AND_NOT);
+            result.cardinality = countBits(result.bits);
+        }
+        else if (a.isBitset())
+        {
+            // Clear each of b's values in a copy of a
+            result = a;
+            for (uint16_t low : b.array)
+            {
+                if (result.bits[low >> 6] & (1ULL << (low & 63)))
+                {
+                    result.bits[low >> 6] &= ~(1ULL << (low & 63));
+                    result.cardinality--;
+                }
+            }
+        }
+        else
+        {
+            for (uint16_t low : a.array)
+            {
+                if (!b.contains(low))
+                {
+                    result.array.push_back(low);
+                }
+            }
+            result.cardinality = result.array.size();
+        }
+        result.normalize();
+        return result;
+    }
+
+    // RoaringBitmap implementation
+
+    size_t RoaringBitmap::findKey(uint64_t high) const
+    {
+        return lower_bound(keys.begin(), keys.end(), high) - keys.begin();
+    }
+
+    bool RoaringBitmap::add(TupleId id)
+    {
+        uint64_t high = id >> 16;
+        size_t pos = findKey(high);
+        if (pos == keys.size() || keys[pos] != high)
+        {
+            keys.insert(keys.begin() + pos, high); // First value for this high part
+            containers.insert(containers.begin() + pos, Container());
+        }
+        return containers[pos].add(static_cast<uint16_t>(id));
+    }
+
+    bool RoaringBitmap::remove(TupleId id)
+    {
+        uint64_t high = id >> 16;
+        size_t pos = findKey(high);
+        if (pos == keys.size() || keys[pos] != high || !containers[pos].remove(static_cast<uint16_t>(id)))
+        {
+            return false;
+        }
+        if (containers[pos].cardinality == 0)
+        {
+            keys.erase(keys.begin() + pos); // Drop empty containers
+            containers.erase(containers.begin() + pos);
+        }
+        return true;
+    }
+
+    bool RoaringBitmap::contains(TupleId id) const
+    {
+        uint64_t high = id >> 16;
+        size_t pos = findKey(high);
+        return pos < keys.size() && keys[pos] == high && containers[pos].contains(static_cast<uint16_t>(id));
+    }
+
+    size_t RoaringBitmap::cardinality() const
+    {
+        size_t count = 0;
+        for (const auto &c : containers)
+        {
+            count += c.cardinality;
+        }
+        return count;
+    }
+
+    // Intersect - only high parts present in both bitmaps can produce values
+    RoaringBitmap RoaringBitmap::operator&(const RoaringBitmap &other) const
+    {
+        RoaringBitmap result;
+        size_t i = 0, j = 0;
+        while (i < keys.size() && j < other.keys.size())
+        {
+            if (keys[i] < other.keys[j])
+            {
+                i++;
+            }
+            else if (keys[i] > other.keys[j])
+            {
+                j++;
+            }
+            else
+            {
+                Container c = andContainers(containers[i], other.containers[j]);
+                if (c.cardinality > 0)
+                {
+                    result.keys.push_back(keys[i]);
+                    result.containers.push_back(move(c));
+                }
+                i++;
+                j++;
+            }
+        }
+        return result;
+    }
+
+    // Union - merge the two sorted key lists
+    RoaringBitmap RoaringBitmap::operator|(const RoaringBitmap &other) const
+    {
+        RoaringBitmap result;
+        size_t i = 0, j = 0;
+        while (i < keys.size() || j < other.keys.size())
+        {
+            if (j == other.keys.size() || (i < keys.size() && keys[i] < other.keys[j]))
+            {
+                result.keys.push_back(keys[i]);
+                result.containers.push_back(containers[i++]);
+            }
+            else if (i == keys.size() || other.keys[j] < keys[i])
+            {
+                result.keys.push_back(other.keys[j]);
+                result.containers.push_back(other.containers[j++]);
+            }
+            else
+            {
+                result.keys.push_back(keys[i]);
+                result.containers.push_back(orContainers(containers[i++], other.containers[j++]));
+            }
+        }
+        return result;
+    }
+
+    // Union of many bitmaps - gather every container by high part, then OR each group
+    // into one bitset (a high part found in a single bitmap is copied as it is)
+    RoaringBitmap RoaringBitmap::unionAll(const vector<const RoaringBitmap *> &bitmaps)
+    {
+        vector<pair<uint64_t, const Container *>> parts;
+        for (const RoaringBitmap *bitmap : bitmaps)
+        {
+            for (size_t i = 0; i < bitmap->keys.size(); i++)
+            {
+                parts.emplace_back(bitmap->keys[i], &bitmap->containers[i]);
+            }
+        }
+        stable_sort(parts.begin(), parts.end(), [](const auto &a, const auto &b)
+                    { return a.first < b.first; });
+
+        RoaringBitmap result;
+        for (size_t i = 0; i < parts.size();)
+        {
+            size_t end = i + 1;
+            while (end < parts.size() && parts[end].first == parts[i].first)
+            {
+                end++;
+            }
+
+            result.keys.push_back(parts[i].first);
+            if (end == i + 1)
+            {
+                result.containers.push_back(*parts[i].second);
+            }
+            else
+            {
+                Container merged;
+                merged.bits.assign(BITSET_WORDS, 0);
+                for (size_t p = i; p < end; p++)
+                {
+                    const Container &c = *parts[p].second;
+                    if (c.isBitset())
+                    {
+                        combineBitsets(merged.bits.data(), c.bits.data(), merged.bits.data(), BITSET_WORDS, BitOp::OR);
+                    }
+                    else
+                    {
+                        for (uint16_t low : c.array)
+                        {
+                            merged.bits[low >> 6] |= 1ULL << (low & 63);
+                        }
+                    }
+                }
+                merged.cardinality = countBits(merged.bits);
+                merged.normalize();
+                result.containers.push_back(move(merged));
+            }
+            i = end;
+        }
+        return result;
+    }
+
+    // Difference - containers without a partner in other are kept whole
+    RoaringBitmap RoaringBitmap::andNot(const RoaringBitmap &other) const
+    {
+        RoaringBitmap result;
+        size_t j = 0;
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            while (j < other.keys.size() && other.keys[j] < keys[i])
+            {
+                j++;
+            }
+
+            if (j < other.keys.size() && other.keys[j] == keys[i])
+            {
+                Container c = andNotContainers(containers[i], other.containers[j]);
+                if (c.cardinality > 0)
+                {
+                    result.keys.push_back(keys[i]);
+                    result.containers.push_back(move(c));
+                }
+            }
+            else
+            {
+                result.keys.push_back(keys[i]);
+                result.containers.push_back(containers[i]);
+            }
+        }
+        return result;
+    }
+
+    vector<TupleId> RoaringBitmap::toVector() const
+    {
+        vector<TupleId> ids;
+        ids.reserve(cardinality());
+        forEach([&](TupleId id)
+                {
+            ids.push_back(id);
+            return true; });
+        return ids;
+    }
+
+    // BitmapIndex implementation
+
+    void BitmapIndex::insert(const string &key, TupleId tuple_id)
+    {
+        if (bitmaps[key].add(tuple_id))
+        {
+            entry_count++;
+        }
+    }
+
+    vector<TupleId> BitmapIndex::lookup(const string &key)
+    {
+        auto it = bitmaps.find(key);
+        return it != bitmaps.end() ? it->second.toVector() : vector<TupleId>();
+    }
+
+    bool BitmapIndex::remove(const string &key, TupleId tuple_id)
+    {
+        auto it = bitmaps.find(key);
+        if (it == bitmaps.end() || !it->second.remove(tuple_id))
+        {
+            return false;
+        }
+        entry_count--;
+        if (it->second.empty())
+        {
+            bitmaps.erase(it); // Last row with this key is gone
+        }
+        return true;
+    }
+
+    void BitmapIndex::scanRange(const KeyRange &range, const IndexVisitor &visitor)
+    {
+        auto it = !range.has_low          ? bitmaps.begin()
+                  : range.low_inclusive   ? bitmaps.lower_bound(range.low)
+                                          : bitmaps.upper_bound(range.low);
+        bool keep_going = true;
+        for (; keep_going && it != bitmaps.end() && range.belowHigh(it->first); ++it)
+        {
+            it->second.forEach([&](TupleId tuple_id)
+                               { return keep_going = visitor(it->first, tuple_id); });
+        }
+    }
+
+    RoaringBitmap BitmapIndex::rangeBitmap(const KeyRange &range) const
+    {
+        auto it = !range.has_low          ? bitmaps.begin()
+                  : range.low_inclusive   ? bitmaps.lower_bound(range.low)
+                                          : bitmaps.upper_bound(range.low);
+        vector<const RoaringBitmap *> matching;
+        for (; it != bitmaps.end() && range.belowHigh(it->first); ++it)
+        {
+            matching.push_back(&it->second);
+        }
+        return RoaringBitmap::unionAll(matching);
+    }
+
+} // namespace db
@@ -102,9 +102,45 @@ namespace db
     }
 
     // Execute a SQL query and return results
+    // Successful DDL rewrites the metadata file so tables and indexes survive a crash
     QueryResult DatabaseEngine::executeQuery(const string &query)
     {
-        return query_executor->execute(query);
+        QueryResult result = query_executor->execute(query);
+        if (result.success)
+        {
+            try
+            {
+                QueryType type = query_parser->getQueryType(query);
+                if (type == QueryType::CREATE_TABLE || type == QueryType::DROP_TABLE ||
+                    type == QueryType::CREATE_INDEX)
+                {
+                    saveTableMetadata();
+                }
+            }
+            catch (const exception &)
+            {
+                // Not a recognized statement type - nothing to persist
+            }
+        }
+        return result;
+    }
+
+    // Choose how SELECT plans are pulled - in column batches or one row at a time
+    void DatabaseEngine::setVectorized(bool enabled)
+    {
+        query_executor->setVectorized(enabled);
+    }
+
+    // Set the memory budget of sorts and aggregations - past it they spill to disk
+    void DatabaseEngine::setWorkMemory(size_t bytes)
+    {
+        query_executor->setWorkMemory(bytes);
+    }
+
+    // Set how many threads a full-table aggregation may use
+    void DatabaseEngine::setParallelWorkers(size_t workers)
+    {
+        query_executor->setParallelWorkers(workers);
     }
 
     // Create a new table with specified schema
@@ -122,7 +158,12 @@ namespace db
     // Drop (delete) an existing table
     bool DatabaseEngine::dropTable(const string &name)
     {
-        return storage_engine->dropTable(name);
+        bool success = storage_engine->dropTable(name);
+        if (success)
+        {
+            saveTableMetadata(); // Forget the table and its indexes
+        }
+        return success;
     }
 
     // Get list of all table names in the database
@@ -152,10 +193,30 @@ namespace db
         return storage_engine->selectWhere(table_name, column, value);
     }
 
+    // Delete a row - the table removes its index entries too
+    bool DatabaseEngine::deleteTuple(const string &table_name, TupleId tuple_id)
+    {
+        return storage_engine->deleteTuple(table_name, tuple_id);
+    }
+
+    // Replace a row's values - the table keeps its indexes in step
+    bool DatabaseEngine::updateTuple(const string &table_name, TupleId tuple_id,
+                                     const vector<Value> &new_values)
+    {
+        return storage_engine->updateTuple(table_name, tuple_id, new_values);
+    }
+
     // Create an index on a table column for faster searches
-    bool DatabaseEngine::createIndex(const string &table_name, const string &column_name)
+    // The definition is saved with the table metadata so it is rebuilt on restart
+    bool DatabaseEngine::createIndex(const string &table_name, const string &column_name,
+                                     IndexType type)
     {
-        return storage_engine->createIndex(table_name, column_name);
+        bool success = storage_engine->createIndex(table_name, column_name, type);
+        if (success)
+        {
+            saveTableMetadata();
+        }
+        return success;
     }
 
     // Display database statistics and performance metrics
@@ -202,6 +263,7 @@ namespace db
         if (storage_engine)
         {
             storage_engine->flushAllPages();
+            storage_engine->writeIndexSnapshots(); // Indexes reload from these at startup
         }
 
         // Then write transaction checkpoint to WAL
@@ -264,6 +326,78 @@ namespace db
             }
         }
 
+        // Write the index catalog - after all tables, so metadata files written
+        // before indexes were persisted still load (they simply end here)
+        auto write_string = [&](const string &str)
+        {
+            uint32_t length = static_cast<uint32_t>(str.length());
+            metadata_file.write(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+            metadata_file.write(str.data(), length);
+        };
+        auto write_names = [&](const vector<string> &names)
+        {
+            uint32_t count = static_cast<uint32_t>(names.size());
+            metadata_file.write(reinterpret_cast<const char *>(&count), sizeof(uint32_t));
+            for (const string &name : names)
+            {
+                write_string(name);
+            }
+        };
+
+        // Copy every table's catalog once, so the count and both passes below agree even
+        // if an index is created or dropped meanwhile
+        vector<pair<string, vector<IndexInfo>>> catalogs;
+        uint32_t index_count = 0;
+        for (const string &table_name : table_names)
+        {
+            auto table = storage_engine->getTable(table_name);
+            if (table)
+            {
+                catalogs.push_back({table_name, table->listIndexes()});
+                index_count += static_cast<uint32_t>(catalogs.back().second.size());
+            }
+        }
+        metadata_file.write(reinterpret_cast<const char *>(&index_count), sizeof(uint32_t));
+
+        for (const auto &[table_name, catalog] : catalogs)
+        {
+            for (const auto &info : catalog)
+            {
+                write_string(table_name);
+                metadata_file.write(reinterpret_cast<const char *>(&info.type), sizeof(IndexType));
+                write_names(info.columns);
+                write_names(info.include_columns);
+            }
+        }
+
+        // Partial index predicates, one list per index in the same order - again
+        // appended, so files from before partial indexes load with full indexes
+        for (const auto &[table_name, catalog] : catalogs)
+        {
+            for (const auto &info : catalog)
+            {
+                uint32_t condition_count = static_cast<uint32_t>(info.predicate.size());
+                metadata_file.write(reinterpret_cast<const char *>(&condition_count), sizeof(uint32_t));
+                for (const auto &condition : info.predicate)
+                {
+                    write_string(condition.column);
+                    metadata_file.write(reinterpret_cast<const char *>(&condition.op), sizeof(CompareOp));
+
+                    // Value: variant alternative, then its bytes (strings length-prefixed)
+                    uint8_t value_type = static_cast<uint8_t>(condition.value.index());
+                    metadata_file.write(reinterpret_cast<const char *>(&value_type), sizeof(uint8_t));
+                    visit([&](const auto &v)
+                          {
+                        using T = decay_t<decltype(v)>;
+                        if constexpr (is_same_v<T, string>) {
+                            write_string(v);
+                        } else {
+                            metadata_file.write(reinterpret_cast<const char *>(&v), sizeof(T));
+                        } }, condition.value);
+                }
+            }
+        }
+
         metadata_file.close();
     }
 
@@ -338,6 +472,135 @@ namespace db
             storage_engine->createTable(table_name, schema);
         }
 
+        // Read the index catalog and rebuild every index from its table's rows
+        auto read_string = [&](string &str)
+        {
+            uint32_t length;
+            metadata_file.read(reinterpret_cast<char *>(&length), sizeof(uint32_t));
+            if (metadata_file.fail())
+                return false;
+            str.assign(length, '\0');
+            metadata_file.read(&str[0], length);
+            return !metadata_file.fail();
+        };
+        auto read_names = [&](vector<string> &names)
+        {
+            uint32_t count;
+            metadata_file.read(reinterpret_cast<char *>(&count), sizeof(uint32_t));
+            if (metadata_file.fail())
+                return false;
+            names.resize(count);
+            for (string &name : names)
+            {
+                if (!read_string(name))
+                    return false;
+            }
+            return true;
+        };
+
+        uint32_t index_count;
+        metadata_file.read(reinterpret_cast<char *>(&index_count), sizeof(uint32_t));
+        if (metadata_file.fail())
+        {
+            metadata_file.close();
+            return; // Written before the index catalog existed
+        }
+
+        struct IndexDefinition
+        {
+            string table_name;
+            IndexType type;
+            vector<string> columns;
+            vector<string> include_columns;
+            vector<Condition> predicate;
+        };
+        vector<IndexDefinition> definitions;
+
+        for (uint32_t i = 0; i < index_count; i++)
+        {
+            IndexDefinition definition;
+            if (!read_string(definition.table_name))
+                break;
+            metadata_file.read(reinterpret_cast<char *>(&definition.type), sizeof(IndexType));
+            if (metadata_file.fail() || !read_names(definition.columns) || !read_names(definition.include_columns))
+                break;
+            definitions.push_back(move(definition));
+        }
+
+        // Read partial index predicates - a file without them (or a damaged list) leaves
+        // every index without a predicate rather than with some other index's conditions
+        auto read_predicate = [&](vector<Condition> &predicate)
+        {
+            uint32_t condition_count;
+            metadata_file.read(reinterpret_cast<char *>(&condition_count), sizeof(uint32_t));
+            if (metadata_file.fail())
+                return false;
+            for (uint32_t j = 0; j < condition_count; j++)
+            {
+                Condition condition;
+                uint8_t value_type;
+                if (!read_string(condition.column))
+                    return false;
+                metadata_file.read(reinterpret_cast<char *>(&condition.op), sizeof(CompareOp));
+                metadata_file.read(reinterpret_cast<char *>(&value_type), sizeof(uint8_t));
+                if (metadata_file.fail())
+                    return false;
+
+                if (value_type == 0)
+                {
+                    int32_t v;
+                    metadata_file.read(reinterpret_cast<char *>(&v), sizeof(int32_t));
+                    condition.value = v;
+                }
+                else if (value_type == 1)
+                {
+                    string v;
+                    if (!read_string(v))
+                        return false;
+                    condition.value = v;
+                }
+                else if (value_type == 2)
+                {
+                    bool v;
+                    metadata_file.read(reinterpret_cast<char *>(&v), sizeof(bool));
+                    condition.value = v;
+                }
+                else if (value_type == 3)
+                {
+                    double v;
+                    metadata_file.read(reinterpret_cast<char *>(&v), sizeof(double));
+                    condition.value = v;
+                }
+                else
+                {
+                    return false;
+                }
+                if (metadata_file.fail())
+                    return false;
+                predicate.push_back(move(condition));
+            }
+            return true;
+        };
+
+        for (auto &definition : definitions)
+        {
+            if (!read_predicate(definition.predicate))
+            {
+                for (auto &other : definitions)
+                {
+                    other.predicate.clear();
+                }
+                break;
+            }
+        }
+
+        // Rebuild every index from its table's rows (or its snapshot file)
+        for (const auto &definition : definitions)
+        {
+            storage_engine->createIndex(definition.table_name, definition.columns, definition.type,
+                                        definition.include_columns, definition.predicate);
+        }
+
         metadata_file.close();
     }
 
@@ -388,23 +651,50 @@ namespace db
         }
     }
 
-    // Update rows in table (simplified implementation)
+    // Update rows in table - sets the given columns on every matching row
     bool Database::update(const string &table_name, const vector<string> &columns,
                           const vector<Value> &values, const string &where_column,
                           const Value &where_value)
     {
-        // Simplified update implementation
-        // In a real implementation, this would be more sophisticated
-        return true;
+        if (columns.size() != values.size())
+        {
+            return false; // Column count mismatch
+        }
+
+        Schema schema = engine->getTableSchema(table_name);
+        vector<int> col_ids;
+        for (const string &column : columns)
+        {
+            int col_idx = schema.findColumn(column);
+            if (col_idx < 0)
+            {
+                return false; // Unknown column
+            }
+            col_ids.push_back(col_idx);
+        }
+
+        bool success = true;
+        for (auto &tuple : select(table_name, where_column, where_value))
+        {
+            for (size_t i = 0; i < col_ids.size(); i++)
+            {
+                tuple.values[col_ids[i]] = values[i];
+            }
+            success = engine->updateTuple(table_name, tuple.id, tuple.values) && success;
+        }
+        return success;
     }
 
-    // Delete rows from table (simplified implementation)
+    // Delete rows from table - every row when no WHERE column is given
     bool Database::remove(const string &table_name, const string &where_column,
                           const Value &where_value)
     {
-        // Simplified delete implementation
-        // In a real implementation, this would be more sophisticated
-        return true;
+        bool success = true;
+        for (const auto &tuple : select(table_name, where_column, where_value))
+        {
+            success = engine->deleteTuple(table_name, tuple.id) && success;
+        }
+        return success;
     }
 
     // Transaction management - start new transaction
@@ -431,6 +721,24 @@ namespace db
         return engine->executeQuery(query);
     }
 
+    // Toggle vectorized SELECT execution
+    void Database::setVectorized(bool enabled)
+    {
+        engine->setVectorized(enabled);
+    }
+
+    // Set the memory budget of sorts and aggregations
+    void Database::setWorkMemory(size_t bytes)
+    {
+        engine->setWorkMemory(bytes);
+    }
+
+    // Set the thread count of full-table aggregations
+    void Database::setParallelWorkers(size_t workers)
+    {
+        engine->setParallelWorkers(workers);
+    }
+
     // Display database statistics
     void Database::printStats()
     {
@@ -0,0 +1,520 @@
+#include "expression.h"
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+using namespace std;
+
+namespace db
+{
+    using Evaluator = CompiledPredicate::Evaluator;
+
+    // Collect the top-level AND of comparisons - everything else makes the result inexact
+    bool extractConditions(const Expr &expr, vector<Condition> &conditions)
+    {
+        switch (expr.type)
+        {
+        case ExprType::AND:
+        {
+            bool exact = true;
+            for (const auto &child : expr.children)
+            {
+                exact = extractConditions(*child, conditions) && exact;
+            }
+            return exact;
+        }
+        case ExprType::COMPARE:
+            conditions.emplace_back(expr.column, expr.op, expr.values[0]);
+            return true;
+        case ExprType::BETWEEN:
+            conditions.emplace_back(expr.column, CompareOp::GE, expr.values[0]);
+            conditions.emplace_back(expr.column, CompareOp::LE, expr.values[1]);
+            return true;
+        default:
+            return false; // OR, NOT, IN and IS NULL are left to the compiled predicate
+        }
+    }
+
+    // Evaluator that ignores the row (comparisons whose outcome the types already decide)
+    static Evaluator constantEvaluator(bool result)
+    {
+        return [result](const vector<Value> &)
+        { return result; };
+    }
+
+    // Compare a column holding C values with a constant of type K
+    // The variant alternative is known from the schema, so get<C> never has to choose
+    template <typename C, typename K>
+    static Evaluator compareColumn(int col, CompareOp op, K constant)
+    {
+        switch (op)
+        {
+        case CompareOp::EQ:
+            return [col, constant](const vector<Value> &row)
+            { return get<C>(row[col]) == constant; };
+        case CompareOp::LT:
+            return [col, constant](const vector<Value> &row)
+            { return get<C>(row[col]) < constant; };
+        case CompareOp::LE:
+            return [col, constant](const vector<Value> &row)
+            { return get<C>(row[col]) <= constant; };
+        case CompareOp::GT:
+            return [col, constant](const vector<Value> &row)
+            { return get<C>(row[col]) > constant; };
+        case CompareOp::GE:
+            return [col, constant](const vector<Value> &row)
+            { return get<C>(row[col]) >= constant; };
+        }
+        return constantEvaluator(false);
+    }
+
+    // A value of the column's type - comparing it with a constant of another
+    // type gives the answer for every row (compareValues orders mixed types by type)
+    static Value sampleValue(DataType type)
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return int32_t(0);
+        case DataType::DOUBLE:
+            return 0.0;
+        case DataType::BOOLEAN:
+            return false;
+        case DataType::VARCHAR:
+        default:
+            return string();
+        }
+    }
+
+    // Pick the typed comparison for a column and a constant
+    static Evaluator compileCompare(int col, DataType type, CompareOp op, const Value &constant)
+    {
+        if (type == DataType::INTEGER && holds_alternative<int32_t>(constant))
+            return compareColumn<int32_t>(col, op, get<int32_t>(constant));
+        if (type == DataType::INTEGER && holds_alternative<double>(constant))
+            return compareColumn<int32_t>(col, op, get<double>(constant)); // Compared as doubles
+        if (type == DataType::DOUBLE && holds_alternative<double>(constant))
+            return compareColumn<double>(col, op, get<double>(constant));
+        if (type == DataType::DOUBLE && holds_alternative<int32_t>(constant))
+            return compareColumn<double>(col, op, static_cast<double>(get<int32_t>(constant)));
+        if (type == DataType::BOOLEAN && holds_alternative<bool>(constant))
+            return compareColumn<bool>(col, op, get<bool>(constant));
+        if (type == DataType::VARCHAR && holds_alternative<string>(constant))
+            return compareColumn<string>(col, op, get<string>(constant));
+
+        return constantEvaluator(Condition(string(), op, constant).matches(sampleValue(type)));
+    }
+
+    // Membership test against a sorted, duplicate-free list of C values
+    // Short lists are scanned, longer ones binary-searched
+    template <typename C>
+    static Evaluator inColumn(int col, vector<C> list)
+    {
+        sort(list.begin(), list.end());
+        list.erase(unique(list.begin(), list.end()), list.end());
+        if (list.empty())
+        {
+            return constantEvaluator(false);
+        }
+        if (list.size() <= 8)
+        {
+            return [col, list](const vector<Value> &row)
+            { return find(list.begin(), list.end(), get<C>(row[col])) != list.end(); };
+        }
+        return [col, list](const vector<Value> &row)
+        { return binary_search(list.begin(), list.end(), get<C>(row[col])); };
+    }
+
+    // IN lists converted to a column's type; constants that can never equal a value
+    // of that type (e.g. 2.5 for an INTEGER column) are dropped
+    static vector<int32_t> integerList(const vector<Value> &values)
+    {
+        vector<int32_t> list;
+        for (const auto &value : values)
+        {
+            if (holds_alternative<int32_t>(value))
+            {
+                list.push_back(get<int32_t>(value));
+            }
+            else if (holds_alternative<double>(value))
+            {
+                double d = get<double>(value);
+                if (d >= INT32_MIN && d <= INT32_MAX && d == floor(d))
+                {
+                    list.push_back(static_cast<int32_t>(d));
+                }
+            }
+        }
+        return list;
+    }
+
+    static vector<double> doubleList(const vector<Value> &values)
+    {
+        vector<double> list;
+        for (const auto &value : values)
+        {
+            if (holds_alternative<double>(value))
+                list.push_back(get<double>(value));
+            else if (holds_alternative<int32_t>(value))
+                list.push_back(static_cast<double>(get<int32_t>(value)));
+        }
+        return list;
+    }
+
+    static vector<string> stringList(const vector<Value> &values)
+    {
+        vector<string> list;
+        for (const auto &value : values)
+        {
+            if (holds_alternative<string>(value))
+                list.push_back(get<string>(value));
+        }
+        return list;
+    }
+
+    // Which of false / true a BOOLEAN IN list names
+    static void booleanList(const vector<Value> &values, bool &want_false, bool &want_true)
+    {
+        want_false = false;
+        want_true = false;
+        for (const auto &value : values)
+        {
+            if (holds_alternative<bool>(value))
+                (get<bool>(value) ? want_true : want_false) = true;
+        }
+    }
+
+    // Membership test for an IN list, in the column's type
+    static Evaluator compileIn(int col, DataType type, const vector<Value> &values)
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return inColumn(col, integerList(values));
+        case DataType::DOUBLE:
+            return inColumn(col, doubleList(values));
+        case DataType::BOOLEAN:
+        {
+            bool want_false, want_true;
+            booleanList(values, want_false, want_true);
+            if (want_false == want_true)
+            {
+                return constantEvaluator(want_true); // Both or neither listed
+            }
+            return [col, want_true](const vector<Value> &row)
+            { return get<bool>(row[col]) == want_true; };
+        }
+        case DataType::VARCHAR:
+        default:
+            return inColumn(col, stringList(values));
+        }
+    }
+
+    // Compile one node (and its children) into a closure
+    Evaluator CompiledPredicate::compileNode(const Expr &expr, const Schema &schema)
+    {
+        if (expr.type == ExprType::AND || expr.type == ExprType::OR || expr.type == ExprType::NOT)
+        {
+            vector<Evaluator> children;
+            for (const auto &child : expr.children)
+            {
+                children.push_back(compileNode(*child, schema));
+            }
+
+            if (expr.type == ExprType::NOT)
+            {
+                Evaluator child = children.at(0);
+                return [child](const vector<Value> &row)
+                { return !child(row); };
+            }
+
+            bool is_and = expr.type == ExprType::AND;
+            if (children.size() == 2)
+            {
+                // The common case - two operands captured directly, no loop
+                Evaluator left = children[0];
+                Evaluator right = children[1];
+                if (is_and)
+                {
+                    return [left, right](const vector<Value> &row)
+                    { return left(row) && right(row); };
+                }
+                return [left, right](const vector<Value> &row)
+                { return left(row) || right(row); };
+            }
+            return [children, is_and](const vector<Value> &row)
+            {
+                for (const auto &child : children)
+                {
+                    if (child(row) != is_and)
+                    {
+                        return !is_and; // AND stops at the first false, OR at the first true
+                    }
+                }
+                return is_and;
+            };
+        }
+
+        // Leaf - resolve the column once
+        int col = schema.findColumn(expr.column);
+        if (col < 0)
+        {
+            throw runtime_error("Unknown column: " + expr.column);
+        }
+        if (find(column_ids.begin(), column_ids.end(), col) == column_ids.end())
+        {
+            column_ids.push_back(col);
+        }
+        DataType type = schema.columns[col].type;
+
+        switch (expr.type)
+        {
+        case ExprType::COMPARE:
+            return compileCompare(col, type, expr.op, expr.values.at(0));
+        case ExprType::BETWEEN:
+        {
+            Evaluator low = compileCompare(col, type, CompareOp::GE, expr.values.at(0));
+            Evaluator high = compileCompare(col, type, CompareOp::LE, expr.values.at(1));
+            return [low, high](const vector<Value> &row)
+            { return low(row) && high(row); };
+        }
+        case ExprType::IN:
+            return compileIn(col, type, expr.values);
+        case ExprType::IS_NULL:
+        default:
+            return constantEvaluator(false); // Columns are never NULL in this engine
+        }
+    }
+
+    // ---- Vectorized form ----
+
+    using BatchEvaluator = CompiledPredicate::BatchEvaluator;
+
+    // Keep the selected rows whose value passes test
+    // The write position only advances for kept rows, so the loop body has no branch
+    // on the data and compiles to a tight pass over the typed array
+    template <typename C, typename Test>
+    static void narrowSelection(const vector<C> &data, vector<uint32_t> &selection, Test test)
+    {
+        size_t kept = 0;
+        for (uint32_t row : selection)
+        {
+            selection[kept] = row;
+            kept += test(data[row]) ? 1 : 0;
+        }
+        selection.resize(kept);
+    }
+
+    // Batch evaluator that keeps every row or none
+    static BatchEvaluator constantBatchEvaluator(bool result)
+    {
+        if (result)
+        {
+            return [](const RowBatch &, vector<uint32_t> &) {};
+        }
+        return [](const RowBatch &, vector<uint32_t> &selection)
+        { selection.clear(); };
+    }
+
+    // Compare a column vector of C values with a constant of type K
+    template <typename C, typename K>
+    static BatchEvaluator batchCompareColumn(int col, CompareOp op, K constant)
+    {
+        switch (op)
+        {
+        case CompareOp::EQ:
+            return [col, constant](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return v == constant; }); };
+        case CompareOp::LT:
+            return [col, constant](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return v < constant; }); };
+        case CompareOp::LE:
+            return [col, constant](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return v <= constant; }); };
+        case CompareOp::GT:
+            return [col, constant](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return v > constant; }); };
+        case CompareOp::GE:
+            return [col, constant](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return v >= constant; }); };
+        }
+        return constantBatchEvaluator(false);
+    }
+
+    // Vectorized counterpart of compileCompare (BOOLEAN vectors hold 0 / 1 bytes)
+    static BatchEvaluator compileBatchCompare(int col, DataType type, CompareOp op, const Value &constant)
+    {
+        if (type == DataType::INTEGER && holds_alternative<int32_t>(constant))
+            return batchCompareColumn<int32_t>(col, op, get<int32_t>(constant));
+        if (type == DataType::INTEGER && holds_alternative<double>(constant))
+            return batchCompareColumn<int32_t>(col, op, get<double>(constant));
+        if (type == DataType::DOUBLE && holds_alternative<double>(constant))
+            return batchCompareColumn<double>(col, op, get<double>(constant));
+        if (type == DataType::DOUBLE && holds_alternative<int32_t>(constant))
+            return batchCompareColumn<double>(col, op, static_cast<double>(get<int32_t>(constant)));
+        if (type == DataType::BOOLEAN && holds_alternative<bool>(constant))
+            return batchCompareColumn<uint8_t>(col, op, static_cast<uint8_t>(get<bool>(constant) ? 1 : 0));
+        if (type == DataType::VARCHAR && holds_alternative<string>(constant))
+            return batchCompareColumn<string>(col, op, get<string>(constant));
+
+        return constantBatchEvaluator(Condition(string(), op, constant).matches(sampleValue(type)));
+    }
+
+    // Vectorized IN over a list in the column's type
+    template <typename C>
+    static BatchEvaluator batchInColumn(int col, vector<C> list)
+    {
+        sort(list.begin(), list.end());
+        list.erase(unique(list.begin(), list.end()), list.end());
+        if (list.empty())
+        {
+            return constantBatchEvaluator(false);
+        }
+        if (list.size() <= 8)
+        {
+            return [col, list](const RowBatch &batch, vector<uint32_t> &selection)
+            { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                              { return find(list.begin(), list.end(), v) != list.end(); }); };
+        }
+        return [col, list](const RowBatch &batch, vector<uint32_t> &selection)
+        { narrowSelection(batch.columns[col].data<C>(), selection, [&](const C &v)
+                          { return binary_search(list.begin(), list.end(), v); }); };
+    }
+
+    static BatchEvaluator compileBatchIn(int col, DataType type, const vector<Value> &values)
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return batchInColumn(col, integerList(values));
+        case DataType::DOUBLE:
+            return batchInColumn(col, doubleList(values));
+        case DataType::BOOLEAN:
+        {
+            bool want_false, want_true;
+            booleanList(values, want_false, want_true);
+            if (want_false == want_true)
+            {
+                return constantBatchEvaluator(want_true);
+            }
+            return batchCompareColumn<uint8_t>(col, CompareOp::EQ, static_cast<uint8_t>(want_true ? 1 : 0));
+        }
+        case DataType::VARCHAR:
+        default:
+            return batchInColumn(col, stringList(values));
+        }
+    }
+
+    // Compile one node into a selection-narrowing closure
+    // AND narrows the selection child by child; OR runs each child only on the rows
+    // no earlier child accepted and merges the results; NOT keeps what its child drops
+    BatchEvaluator CompiledPredicate::compileBatchNode(const Expr &expr, const Schema &schema)
+    {
+        if (expr.type == ExprType::AND || expr.type == ExprType::OR || expr.type == ExprType::NOT)
+        {
+            vector<BatchEvaluator> children;
+            for (const auto &child : expr.children)
+            {
+                children.push_back(compileBatchNode(*child, schema));
+            }
+
+            if (expr.type == ExprType::NOT)
+            {
+                BatchEvaluator child = children.at(0);
+                return [child](const RowBatch &batch, vector<uint32_t> &selection)
+                {
+                    vector<uint32_t> passed = selection;
+                    child(batch, passed);
+                    vector<uint32_t> rest;
+                    set_difference(selection.begin(), selection.end(), passed.begin(), passed.end(),
+                                   back_inserter(rest));
+                    selection.swap(rest);
+                };
+            }
+
+            if (expr.type == ExprType::AND)
+            {
+                return [children](const RowBatch &batch, vector<uint32_t> &selection)
+                {
+                    for (const auto &child : children)
+                    {
+                        if (selection.empty())
+                        {
+                            return;
+                        }
+                        child(batch, selection);
+                    }
+                };
+            }
+
+            return [children](const RowBatch &batch, vector<uint32_t> &selection)
+            {
+                vector<uint32_t> pending = selection; // Rows no child has accepted yet
+                vector<uint32_t> accepted;
+                for (const auto &child : children)
+                {
+                    if (pending.empty())
+                    {
+                        break;
+                    }
+                    vector<uint32_t> passed = pending;
+                    child(batch, passed);
+
+                    vector<uint32_t> merged;
+                    merge(accepted.begin(), accepted.end(), passed.begin(), passed.end(), back_inserter(merged));
+                    accepted.swap(merged);
+
+                    vector<uint32_t> rest;
+                    set_difference(pending.begin(), pending.end(), passed.begin(), passed.end(),
+                                   back_inserter(rest));
+                    pending.swap(rest);
+                }
+                selection.swap(accepted);
+            };
+        }
+
+        int col = schema.findColumn(expr.column);
+        if (col < 0)
+        {
+            throw runtime_error("Unknown column: " + expr.column);
+        }
+        DataType type = schema.columns[col].type;
+
+        switch (expr.type)
+        {
+        case ExprType::COMPARE:
+            return compileBatchCompare(col, type, expr.op, expr.values.at(0));
+        case ExprType::BETWEEN:
+        {
+            BatchEvaluator low = compileBatchCompare(col, type, CompareOp::GE, expr.values.at(0));
+            BatchEvaluator high = compileBatchCompare(col, type, CompareOp::LE, expr.values.at(1));
+            return [low, high](const RowBatch &batch, vector<uint32_t> &selection)
+            {
+                low(batch, selection);
+                high(batch, selection);
+            };
+        }
+        case ExprType::IN:
+            return compileBatchIn(col, type, expr.values);
+        case ExprType::IS_NULL:
+        default:
+            return constantBatchEvaluator(false); // Columns are never NULL in this engine
+        }
+    }
+
+    CompiledPredicate CompiledPredicate::compile(const Expr &expr, const Schema &schema)
+    {
+        CompiledPredicate predicate;
+        predicate.evaluator = predicate.compileNode(expr, schema);
+        predicate.batch_evaluator = predicate.compileBatchNode(expr, schema);
+        return predicate;
+    }
+
+} // namespace db
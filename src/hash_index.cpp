@@ -0,0 +1,472 @@
+#include "hash_index.h"
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace db
+{
+    // HashIndex implementation - extendible hashing over buffer pool pages
+
+    // Space available for entries on a bucket page
+    static constexpr size_t BUCKET_CAPACITY = PAGE_SIZE - sizeof(HashBucketHeader);
+
+    // Directory slots that fit on one directory page
+    static constexpr size_t SLOTS_PER_DIRECTORY_PAGE =
+        (PAGE_SIZE - sizeof(HashDirectoryPageHeader)) / sizeof(PageId);
+
+    // Constructor - start with a single bucket and a one-slot directory
+    HashIndex::HashIndex(const string &file_path)
+        : global_depth(0), next_page_id(HEADER_PAGE + 1), directory_page(0),
+          entry_count(0)
+    {
+        // Discard any index pages left over from an earlier build
+        ofstream truncate_file(file_path, ios::binary | ios::trunc);
+        truncate_file.close();
+
+        buffer_pool = make_unique<BufferPool>(file_path);
+
+        directory_page = next_page_id++;         // Reserve first directory page
+        directory.push_back(allocateBucket(0)); // Every key starts in one bucket
+        writeHeader();
+    }
+
+    // Destructor - make sure the directory reaches disk with the buckets
+    HashIndex::~HashIndex()
+    {
+        flush();
+    }
+
+    // FNV-1a followed by a 64-bit finalizer so the low bits are well mixed
+    // The directory uses low bits, so poor low-bit quality would skew buckets
+    uint32_t HashIndex::hashKey(const string &key)
+    {
+        uint64_t hash = 14695981039346656037ULL;
+        for (unsigned char c : key)
+        {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return static_cast<uint32_t>(hash);
+    }
+
+    // Allocate a page (reusing freed overflow pages first) as an empty bucket
+    PageId HashIndex::allocateBucket(uint32_t local_depth)
+    {
+        PageId page_id;
+        if (!free_pages.empty())
+        {
+            page_id = free_pages.back(); // Reuse a page released by a split
+            free_pages.pop_back();
+        }
+        else
+        {
+            page_id = next_page_id++;
+        }
+
+        auto frame = buffer_pool->getPage(page_id);
+        HashBucketHeader header{local_depth, 0, 0, 0};
+        memcpy(frame->data.data(), &header, sizeof(HashBucketHeader));
+        buffer_pool->markDirty(page_id);
+        buffer_pool->releasePage(page_id);
+        return page_id;
+    }
+
+    // Collect all entries from a bucket page and its overflow pages
+    void HashIndex::readBucket(PageId bucket_page, vector<pair<HashEntryHeader, string>> &entries)
+    {
+        PageId current_page = bucket_page;
+        while (current_page != 0)
+        {
+            auto frame = buffer_pool->getPage(current_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+
+            size_t offset = sizeof(HashBucketHeader);
+            for (uint32_t i = 0; i < header.entry_count; i++)
+            {
+                HashEntryHeader entry;
+                memcpy(&entry, frame->data.data() + offset, sizeof(HashEntryHeader));
+                offset += sizeof(HashEntryHeader);
+                string key(reinterpret_cast<const char *>(frame->data.data() + offset), entry.key_length);
+                offset += entry.key_length;
+                entries.emplace_back(entry, move(key));
+            }
+
+            buffer_pool->releasePage(current_page);
+            current_page = header.overflow_page;
+        }
+    }
+
+    // Rewrite a bucket chain with exactly these entries
+    // Existing chain pages are reused; pages no longer needed go to the free list
+    void HashIndex::writeBucket(PageId bucket_page, uint32_t local_depth,
+                                const vector<pair<HashEntryHeader, string>> &entries)
+    {
+        // Remember the old chain so its pages can be reused
+        vector<PageId> chain;
+        PageId current_page = bucket_page;
+        while (current_page != 0)
+        {
+            chain.push_back(current_page);
+            auto frame = buffer_pool->getPage(current_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+            buffer_pool->releasePage(current_page);
+            current_page = header.overflow_page;
+        }
+
+        size_t entry_index = 0;
+        size_t chain_index = 0;
+        PageId page_id = bucket_page;
+        while (true)
+        {
+            auto frame = buffer_pool->getPage(page_id);
+            HashBucketHeader header{local_depth, 0, 0, 0};
+            size_t offset = sizeof(HashBucketHeader);
+
+            // Fill this page with as many entries as fit
+            while (entry_index < entries.size())
+            {
+                const auto &[entry, key] = entries[entry_index];
+                size_t needed = sizeof(HashEntryHeader) + key.size();
+                if (header.used_bytes + needed > BUCKET_CAPACITY)
+                {
+                    break; // Page full - continue on an overflow page
+                }
+                memcpy(frame->data.data() + offset, &entry, sizeof(HashEntryHeader));
+                memcpy(frame->data.data() + offset + sizeof(HashEntryHeader), key.data(), key.size());
+                offset += needed;
+                header.used_bytes += static_cast<uint32_t>(needed);
+                header.entry_count++;
+                entry_index++;
+            }
+
+            // Link an overflow page if entries remain
+            chain_index++;
+            if (entry_index < entries.size())
+            {
+                header.overflow_page = chain_index < chain.size() ? chain[chain_index]
+                                                                  : allocateBucket(local_depth);
+            }
+
+            memcpy(frame->data.data(), &header, sizeof(HashBucketHeader));
+            buffer_pool->markDirty(page_id);
+            buffer_pool->releasePage(page_id);
+
+            if (header.overflow_page == 0)
+            {
+                break; // All entries written
+            }
+            page_id = header.overflow_page;
+        }
+
+        // Return unused overflow pages for later buckets
+        for (size_t i = chain_index; i < chain.size(); i++)
+        {
+            free_pages.push_back(chain[i]);
+        }
+    }
+
+    // Double the directory - each new slot points at its buddy's bucket
+    void HashIndex::doubleDirectory()
+    {
+        size_t old_size = directory.size();
+        directory.resize(old_size * 2);
+        for (size_t i = 0; i < old_size; i++)
+        {
+            directory[old_size + i] = directory[i];
+        }
+        global_depth++;
+    }
+
+    // Split the bucket at a directory slot on its next hash bit
+    // Only this bucket's entries move - the rest of the index is untouched
+    void HashIndex::splitBucket(uint32_t slot)
+    {
+        PageId old_page = directory[slot];
+
+        vector<pair<HashEntryHeader, string>> entries;
+        readBucket(old_page, entries);
+
+        auto frame = buffer_pool->getPage(old_page);
+        HashBucketHeader header;
+        memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+        buffer_pool->releasePage(old_page);
+
+        if (header.local_depth == global_depth)
+        {
+            doubleDirectory(); // Need one more directory bit first
+        }
+
+        uint32_t new_depth = header.local_depth + 1;
+        uint32_t split_bit = 1u << header.local_depth;
+        PageId new_page = allocateBucket(new_depth);
+
+        // Entries with the split bit set move to the new bucket
+        vector<pair<HashEntryHeader, string>> keep;
+        vector<pair<HashEntryHeader, string>> moved;
+        for (auto &entry : entries)
+        {
+            if (entry.first.hash & split_bit)
+            {
+                moved.push_back(move(entry));
+            }
+            else
+            {
+                keep.push_back(move(entry));
+            }
+        }
+        writeBucket(old_page, new_depth, keep);
+        writeBucket(new_page, new_depth, moved);
+
+        // Repoint the directory slots that now belong to the new bucket
+        for (size_t i = 0; i < directory.size(); i++)
+        {
+            if (directory[i] == old_page && (i & split_bit))
+            {
+                directory[i] = new_page;
+            }
+        }
+    }
+
+    // Append an entry to the first page in a bucket chain with room for it
+    bool HashIndex::appendToBucket(PageId bucket_page, const HashEntryHeader &entry,
+                                   const string &key, bool allow_overflow)
+    {
+        size_t needed = sizeof(HashEntryHeader) + key.size();
+        PageId current_page = bucket_page;
+
+        while (true)
+        {
+            auto frame = buffer_pool->getPage(current_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+
+            if (header.used_bytes + needed <= BUCKET_CAPACITY)
+            {
+                // Room on this page - write entry after the existing ones
+                size_t offset = sizeof(HashBucketHeader) + header.used_bytes;
+                memcpy(frame->data.data() + offset, &entry, sizeof(HashEntryHeader));
+                memcpy(frame->data.data() + offset + sizeof(HashEntryHeader), key.data(), key.size());
+                header.used_bytes += static_cast<uint32_t>(needed);
+                header.entry_count++;
+                memcpy(frame->data.data(), &header, sizeof(HashBucketHeader));
+                buffer_pool->markDirty(current_page);
+                buffer_pool->releasePage(current_page);
+                return true;
+            }
+
+            if (header.overflow_page != 0)
+            {
+                buffer_pool->releasePage(current_page);
+                current_page = header.overflow_page; // Try the next page in the chain
+                continue;
+            }
+
+            if (!allow_overflow)
+            {
+                buffer_pool->releasePage(current_page);
+                return false; // Caller should split instead
+            }
+
+            // Keys can't be separated by splitting - chain an overflow page
+            PageId overflow_page = allocateBucket(header.local_depth);
+            header.overflow_page = overflow_page;
+            memcpy(frame->data.data(), &header, sizeof(HashBucketHeader));
+            buffer_pool->markDirty(current_page);
+            buffer_pool->releasePage(current_page);
+            current_page = overflow_page;
+        }
+    }
+
+    size_t HashIndex::maxKeySize() const
+    {
+        return BUCKET_CAPACITY - sizeof(HashEntryHeader);
+    }
+
+    // Insert a key -> tuple ID entry, splitting the target bucket if it is full
+    void HashIndex::insert(const string &key, TupleId tuple_id)
+    {
+        if (key.size() > maxKeySize())
+        {
+            // No page could ever take it - overflow chaining would allocate pages forever
+            throw runtime_error("Key of " + to_string(key.size()) + " bytes is too long for a hash index");
+        }
+        HashEntryHeader entry{hashKey(key), static_cast<uint32_t>(key.size()), tuple_id};
+        uint32_t max_mask = (1u << MAX_GLOBAL_DEPTH) - 1;
+
+        while (true)
+        {
+            uint32_t slot = entry.hash & ((1u << global_depth) - 1);
+            PageId bucket_page = directory[slot];
+
+            // Splitting only helps if some existing key differs in the hash bits
+            // we could still use - otherwise the entry goes to an overflow page
+            vector<pair<HashEntryHeader, string>> entries;
+            auto frame = buffer_pool->getPage(bucket_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+            buffer_pool->releasePage(bucket_page);
+
+            bool can_split = false;
+            if (header.local_depth < MAX_GLOBAL_DEPTH &&
+                header.used_bytes + sizeof(HashEntryHeader) + key.size() > BUCKET_CAPACITY)
+            {
+                readBucket(bucket_page, entries);
+                for (const auto &existing : entries)
+                {
+                    if ((existing.first.hash ^ entry.hash) & max_mask)
+                    {
+                        can_split = true;
+                        break;
+                    }
+                }
+            }
+
+            if (appendToBucket(bucket_page, entry, key, !can_split))
+            {
+                entry_count++;
+                return;
+            }
+
+            splitBucket(slot); // Bucket full - split it and retry
+        }
+    }
+
+    // Exact-match lookup - hash selects the bucket, then scan its chain
+    vector<TupleId> HashIndex::lookup(const string &key)
+    {
+        vector<TupleId> result;
+        uint32_t hash = hashKey(key);
+        PageId current_page = directory[hash & ((1u << global_depth) - 1)];
+
+        while (current_page != 0)
+        {
+            auto frame = buffer_pool->getPage(current_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+
+            size_t offset = sizeof(HashBucketHeader);
+            for (uint32_t i = 0; i < header.entry_count; i++)
+            {
+                HashEntryHeader entry;
+                memcpy(&entry, frame->data.data() + offset, sizeof(HashEntryHeader));
+                offset += sizeof(HashEntryHeader);
+
+                // Compare cached hashes before touching the key bytes
+                if (entry.hash == hash && entry.key_length == key.size() &&
+                    memcmp(frame->data.data() + offset, key.data(), key.size()) == 0)
+                {
+                    result.push_back(entry.tuple_id);
+                }
+                offset += entry.key_length;
+            }
+
+            buffer_pool->releasePage(current_page);
+            current_page = header.overflow_page;
+        }
+
+        return result;
+    }
+
+    // Remove an entry - later entries on the page slide down over it
+    // Buckets are not merged back; a later insert reuses the freed space
+    bool HashIndex::remove(const string &key, TupleId tuple_id)
+    {
+        uint32_t hash = hashKey(key);
+        PageId current_page = directory[hash & ((1u << global_depth) - 1)];
+
+        while (current_page != 0)
+        {
+            auto frame = buffer_pool->getPage(current_page);
+            HashBucketHeader header;
+            memcpy(&header, frame->data.data(), sizeof(HashBucketHeader));
+
+            size_t offset = sizeof(HashBucketHeader);
+            for (uint32_t i = 0; i < header.entry_count; i++)
+            {
+                HashEntryHeader entry;
+                memcpy(&entry, frame->data.data() + offset, sizeof(HashEntryHeader));
+                size_t entry_size = sizeof(HashEntryHeader) + entry.key_length;
+
+                if (entry.hash == hash && entry.tuple_id == tuple_id && entry.key_length == key.size() &&
+                    memcmp(frame->data.data() + offset + sizeof(HashEntryHeader), key.data(), key.size()) == 0)
+                {
+                    size_t end = sizeof(HashBucketHeader) + header.used_bytes;
+                    memmove(frame->data.data() + offset, frame->data.data() + offset + entry_size,
+                            end - offset - entry_size);
+                    header.used_bytes -= static_cast<uint32_t>(entry_size);
+                    header.entry_count--;
+                    memcpy(frame->data.data(), &header, sizeof(HashBucketHeader));
+                    buffer_pool->markDirty(current_page);
+                    buffer_pool->releasePage(current_page);
+                    entry_count--;
+                    return true;
+                }
+                offset += entry_size;
+            }
+
+            buffer_pool->releasePage(current_page);
+            current_page = header.overflow_page;
+        }
+
+        return false;
+    }
+
+    // Write the header page and the directory page chain
+    void HashIndex::writeHeader()
+    {
+        // Directory slots are spread over a chain of pages
+        PageId page_id = directory_page;
+        size_t slot = 0;
+        while (true)
+        {
+            auto frame = buffer_pool->getPage(page_id);
+            HashDirectoryPageHeader dir_header;
+            memcpy(&dir_header, frame->data.data(), sizeof(HashDirectoryPageHeader));
+
+            size_t count = min(SLOTS_PER_DIRECTORY_PAGE, directory.size() - slot);
+            memcpy(frame->data.data() + sizeof(HashDirectoryPageHeader),
+                   directory.data() + slot, count * sizeof(PageId));
+            slot += count;
+            dir_header.slot_count = static_cast<uint32_t>(count);
+
+            // Extend the chain if the directory outgrew it
+            if (slot < directory.size() && dir_header.next_page == 0)
+            {
+                dir_header.next_page = next_page_id++;
+            }
+
+            memcpy(frame->data.data(), &dir_header, sizeof(HashDirectoryPageHeader));
+            buffer_pool->markDirty(page_id);
+            buffer_pool->releasePage(page_id);
+
+            if (slot >= directory.size())
+            {
+                break;
+            }
+            page_id = dir_header.next_page;
+        }
+
+        HashIndexHeader header{MAGIC, global_depth, next_page_id, directory_page, entry_count};
+        auto frame = buffer_pool->getPage(HEADER_PAGE);
+        memcpy(frame->data.data(), &header, sizeof(HashIndexHeader));
+        buffer_pool->markDirty(HEADER_PAGE);
+        buffer_pool->releasePage(HEADER_PAGE);
+    }
+
+    // Persist everything - directory first, then all cached pages
+    void HashIndex::flush()
+    {
+        writeHeader();
+        buffer_pool->flushAllPages();
+    }
+
+} // namespace db
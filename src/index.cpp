@@ -0,0 +1,57 @@
+#include "index.h"
+#include "hash_index.h"
+#include "art.h"
+#include "bitmap_index.h"
+#include "learned_index.h"
+
+using namespace std;
+
+namespace db
+{
+    // Index factory - creates the data structure behind each IndexType
+
+    // Create an empty index of the requested type
+    unique_ptr<Index> makeIndex(IndexType type, const string &file_path)
+    {
+        switch (type)
+        {
+        case IndexType::HASH:
+            return make_unique<HashIndex>(file_path); // Disk-backed extendible hashing
+        case IndexType::ART:
+            return make_unique<ArtIndex>(); // In-memory adaptive radix tree
+        case IndexType::BITMAP:
+            return make_unique<BitmapIndex>(); // In-memory compressed bitmaps
+        case IndexType::LEARNED:
+            return make_unique<LearnedIndex>(); // In-memory learned models
+        case IndexType::B_TREE:
+        default:
+            return make_unique<BTreeIndex>(); // In-memory B-tree
+        }
+    }
+
+    // Only hash buckets lose key order - every other structure supports ordered scans
+    bool indexTypeIsOrdered(IndexType type)
+    {
+        return type != IndexType::HASH;
+    }
+
+    // Human-readable name of an index type
+    string indexTypeName(IndexType type)
+    {
+        switch (type)
+        {
+        case IndexType::HASH:
+            return "HASH";
+        case IndexType::ART:
+            return "ART";
+        case IndexType::BITMAP:
+            return "BITMAP";
+        case IndexType::LEARNED:
+            return "LEARNED";
+        case IndexType::B_TREE:
+        default:
+            return "BTREE";
+        }
+    }
+
+} // namespace db
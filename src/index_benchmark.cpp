@@ -0,0 +1,106 @@
+#include "../include/index.h"
+#include "../include/learned_index.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace db;
+
+// Index benchmark - compares point lookup speed of the B-tree, ART and learned indexes
+// on INTEGER key sets shaped like real columns (dense ids, gapped timestamps,
+// random values). Run: ./index_benchmark [number_of_keys]
+
+// Time one lookup per probe key and return the average in nanoseconds
+static double timeLookups(Index &index, const vector<string> &probes, size_t &found)
+{
+    auto start = chrono::steady_clock::now();
+    for (const auto &key : probes)
+    {
+        found += index.lookup(key).size();
+    }
+    auto elapsed = chrono::steady_clock::now() - start;
+    return chrono::duration<double, nano>(elapsed).count() / probes.size();
+}
+
+// Build each index over the same keys and report build and lookup times
+static void runWorkload(const string &name, const vector<int32_t> &values, size_t probe_count)
+{
+    vector<string> keys;
+    keys.reserve(values.size());
+    for (int32_t value : values)
+    {
+        keys.push_back(encodeKey(Value(value)));
+    }
+
+    mt19937 rng(42);
+    vector<string> probes;
+    probes.reserve(probe_count);
+    for (size_t i = 0; i < probe_count; i++)
+    {
+        probes.push_back(keys[rng() % keys.size()]); // Existing keys, random order
+    }
+
+    cout << name << " (" << keys.size() << " keys)" << endl;
+    for (IndexType type : {IndexType::B_TREE, IndexType::ART, IndexType::LEARNED})
+    {
+        auto index = makeIndex(type, "");
+
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            index->insert(keys[i], i + 1);
+        }
+        double build_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        size_t found = 0;
+        double lookup_ns = timeLookups(*index, probes, found);
+
+        cout << "  " << setw(8) << left << indexTypeName(type)
+             << " build " << setw(8) << right << fixed << setprecision(1) << build_ms << " ms"
+             << "  lookup " << setw(7) << lookup_ns << " ns";
+        if (auto *learned = dynamic_cast<LearnedIndex *>(index.get()))
+        {
+            cout << "  (" << learned->segmentCount() << " segments)";
+        }
+        cout << "  found " << found << endl;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    size_t key_count = argc > 1 ? stoul(argv[1]) : 1000000;
+    size_t probe_count = 1000000;
+    mt19937 rng(7);
+
+    // Dense auto-increment ids
+    vector<int32_t> ids(key_count);
+    for (size_t i = 0; i < key_count; i++)
+    {
+        ids[i] = static_cast<int32_t>(i + 1);
+    }
+    runWorkload("Sequential ids", ids, probe_count);
+
+    // Increasing timestamps with irregular gaps
+    vector<int32_t> timestamps(key_count);
+    int32_t now = 1600000000;
+    for (size_t i = 0; i < key_count; i++)
+    {
+        now += 1 + static_cast<int32_t>(rng() % 60);
+        timestamps[i] = now;
+    }
+    runWorkload("Gapped timestamps", timestamps, probe_count);
+
+    // Uniformly random values inserted out of order
+    vector<int32_t> random_values(key_count);
+    for (auto &value : random_values)
+    {
+        value = static_cast<int32_t>(rng());
+    }
+    runWorkload("Random values", random_values, probe_count);
+
+    return 0;
+}
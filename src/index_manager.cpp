@@ -1,5 +1,4 @@
 #include "index_manager.h"
-#include "b_tree.h"
 #include "storage_engine.h"
 #include <iostream>
 
@@ -7,71 +6,22 @@ using namespace std;
 
 namespace db
 {
-    // IndexManager implementation - manages B-tree indexes for fast data lookup
+    // IndexManager implementation - thin layer over the per-table index catalogs
 
     // Constructor - initialize with reference to storage engine
     IndexManager::IndexManager(StorageEngine *storage_engine) : storage_engine(storage_engine) {}
 
     // Create a new index on a table column for faster searches
-    // Builds B-tree index from existing table data
-    bool IndexManager::createIndex(const string &table_name, const string &column_name)
+    // The table builds it from existing data and keeps it up to date afterwards
+    bool IndexManager::createIndex(const string &table_name, const string &column_name,
+                                   IndexType type)
     {
         if (!storage_engine)
         {
             return false; // No storage engine available
         }
 
-        string index_name = table_name + "_" + column_name; // Unique index identifier
-
-        // Check if index already exists to avoid duplicates
-        if (indexes.find(index_name) != indexes.end())
-        {
-            return false; // Index already exists
-        }
-
-        // Create new B-tree index structure
-        auto index = make_unique<BTree<string, TupleId>>();
-
-        // Get table to build index from existing data
-        auto table = storage_engine->getTable(table_name);
-        if (!table)
-        {
-            return false; // Table doesn't exist
-        }
-
-        auto all_tuples = table->selectAll(); // Get all existing rows
-        const auto &schema = table->getSchema();
-
-        // Find the column index in the schema
-        size_t col_idx = 0;
-        for (size_t i = 0; i < schema.columns.size(); i++)
-        {
-            if (schema.columns[i].name == column_name)
-            {
-                col_idx = i;
-                break;
-            }
-        }
-
-        // Build index by inserting all existing values
-        for (const auto &tuple : all_tuples)
-        {
-            if (col_idx < tuple.values.size())
-            {
-                // Convert value to string key for B-tree storage
-                string key = visit([](const auto &v)
-                                   {
-                    if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-                        return v;                           // Already a string
-                    } else {
-                        return to_string(v);               // Convert to string
-                    } }, tuple.values[col_idx]);
-                index->insert(key, tuple.id); // Add to B-tree index
-            }
-        }
-
-        indexes[index_name] = move(index); // Store completed index
-        return true;
+        return storage_engine->createIndex(table_name, column_name, type);
     }
 
     // Look up all tuples with a specific value using an index
@@ -80,54 +30,61 @@ namespace db
                                               const string &column_name,
                                               const Value &value)
     {
-        string index_name = table_name + "_" + column_name;
-
-        auto it = indexes.find(index_name);
-        if (it == indexes.end())
-        {
-            return {}; // Index doesn't exist
-        }
-
-        // Convert search value to string key
-        string key = visit([](const auto &v)
-                           {
-            if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-                return v;                                   // Already a string
-            } else {
-                return to_string(v);                       // Convert to string
-            } }, value);
-
-        auto tuple_id_ptr = it->second->search(key); // Search B-tree
-        if (tuple_id_ptr)
+        auto table = storage_engine ? storage_engine->getTable(table_name) : nullptr;
+        vector<TupleId> result;
+        if (table)
         {
-            return {*tuple_id_ptr}; // Return found tuple ID
+            table->lookupIndex(column_name, value, result); // Empty if the index doesn't exist
         }
-
-        return {}; // No match found
+        return result;
     }
 
     // Remove an index (frees memory but makes searches slower)
-    void IndexManager::dropIndex(const string &table_name, const string &column_name)
+    void IndexManager::dropIndex(const string &table_name, const string &index_name)
     {
-        string index_name = table_name + "_" + column_name;
-        indexes.erase(index_name); // Remove from index map
+        if (storage_engine)
+        {
+            storage_engine->dropIndex(table_name, index_name);
+        }
     }
 
     // Check if an index exists on a specific table column
     bool IndexManager::indexExists(const string &table_name, const string &column_name)
     {
-        string index_name = table_name + "_" + column_name;
-        return indexes.find(index_name) != indexes.end();
+        auto table = storage_engine ? storage_engine->getTable(table_name) : nullptr;
+        return table && table->hasIndexOn(column_name);
     }
 
     // Display statistics about all indexes
     void IndexManager::printStats() const
     {
         cout << "Index Manager Statistics:" << endl;
-        cout << "  Total indexes: " << indexes.size() << endl;
-        for (const auto &[name, index] : indexes)
+        if (!storage_engine)
         {
-            cout << "    Index: " << name << endl; // Display each index name
+            return;
+        }
+
+        // One copy of each catalog, so the total matches the list even while indexes change
+        vector<pair<string, vector<IndexInfo>>> catalogs;
+        size_t total = 0;
+        for (const string &table_name : storage_engine->getTableNames())
+        {
+            auto table = storage_engine->getTable(table_name);
+            if (table)
+            {
+                catalogs.push_back({table_name, table->listIndexes()});
+                total += catalogs.back().second.size();
+            }
+        }
+        cout << "  Total indexes: " << total << endl;
+
+        for (const auto &[table_name, catalog] : catalogs)
+        {
+            for (const auto &info : catalog)
+            {
+                cout << "    Index: " << table_name << "." << info.name << " (" << indexTypeName(info.type) << ", "
+                     << info.entries << " entries)" << endl;
+            }
         }
     }
 
@@ -0,0 +1,292 @@
+#include "learned_index.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+namespace db
+{
+    // Encoded INTEGER keys are 4 big-endian bytes, so reading them as an
+    // unsigned number keeps their order
+    bool LearnedIndex::toNumber(const string &key, uint32_t &number)
+    {
+        if (key.size() != 4)
+        {
+            return false; // Not a single INTEGER key
+        }
+        number = 0;
+        for (char c : key)
+        {
+            number = (number << 8) | static_cast<uint8_t>(c);
+        }
+        return true;
+    }
+
+    string LearnedIndex::toKey(uint32_t number)
+    {
+        string key(4, '\0');
+        for (int i = 3; i >= 0; i--)
+        {
+            key[i] = static_cast<char>(number & 0xFF);
+            number >>= 8;
+        }
+        return key;
+    }
+
+    // Greedy shrinking-cone fit over the distinct keys
+    // A segment starts at one key and keeps the range of slopes that predict every
+    // later key's first position within MAX_ERROR; when the range becomes empty the
+    // segment ends and a new one starts at that key.
+    void LearnedIndex::train()
+    {
+        segments.clear();
+        size_t n = keys.size();
+        size_t start = 0;
+        while (start < n)
+        {
+            double x0 = keys[start];
+            double slope_low = 0;
+            double slope_high = numeric_limits<double>::infinity();
+
+            size_t next = upper_bound(keys.begin() + start, keys.end(), keys[start]) - keys.begin();
+            while (next < n)
+            {
+                double dx = keys[next] - x0;
+                double dy = static_cast<double>(next - start);
+                double low = max(slope_low, (dy - MAX_ERROR) / dx);
+                double high = min(slope_high, (dy + MAX_ERROR) / dx);
+                if (low > high)
+                {
+                    break; // This key doesn't fit the current line
+                }
+                slope_low = low;
+                slope_high = high;
+                next = upper_bound(keys.begin() + next, keys.end(), keys[next]) - keys.begin();
+            }
+
+            double slope = slope_high == numeric_limits<double>::infinity() ? 0 : (slope_low + slope_high) / 2;
+            segments.push_back({keys[start], start, slope});
+            start = next;
+        }
+    }
+
+    // Model-guided search: predict, then binary search a small window
+    size_t LearnedIndex::lowerBound(uint32_t number) const
+    {
+        auto seg_it = upper_bound(segments.begin(), segments.end(), number,
+                                  [](uint32_t value, const LearnedSegment &seg)
+                                  { return value < seg.first_key; });
+        if (seg_it == segments.begin())
+        {
+            return 0; // Smaller than every key
+        }
+        size_t seg_end = seg_it == segments.end() ? keys.size() : seg_it->start_pos;
+        const LearnedSegment &seg = *prev(seg_it);
+
+        double predicted = seg.start_pos + seg.slope * (static_cast<double>(number) - seg.first_key);
+        size_t pos = static_cast<size_t>(max<double>(seg.start_pos, min<double>(predicted, seg_end)));
+        size_t low = pos > seg.start_pos + MAX_ERROR + 1 ? pos - MAX_ERROR - 1 : seg.start_pos;
+        size_t high = min(seg_end, pos + MAX_ERROR + 2);
+
+        size_t found = lower_bound(keys.begin() + low, keys.begin() + high, number) - keys.begin();
+
+        // Keys between trained points can land just outside the window - widen if so
+        if ((found == low && low > seg.start_pos && keys[low - 1] >= number) ||
+            (found == high && high < seg_end && keys[high] < number))
+        {
+            found = lower_bound(keys.begin() + seg.start_pos, keys.begin() + seg_end, number) - keys.begin();
+        }
+        return found;
+    }
+
+    // Rebuild the sorted array with the delta merged in and tombstones dropped
+    void LearnedIndex::merge()
+    {
+        vector<uint32_t> new_keys;
+        vector<TupleId> new_ids;
+        new_keys.reserve(keys.size() - tombstones.size() + delta.size());
+        new_ids.reserve(new_keys.capacity());
+
+        auto it = delta.begin();
+        for (size_t pos = 0; pos <= keys.size(); pos++)
+        {
+            // Emit delta entries that sort before this array entry
+            while (it != delta.end() &&
+                   (pos == keys.size() || *it < make_pair(keys[pos], tuple_ids[pos])))
+            {
+                new_keys.push_back(it->first);
+                new_ids.push_back(it->second);
+                ++it;
+            }
+            if (pos < keys.size() && isLive(pos))
+            {
+                new_keys.push_back(keys[pos]);
+                new_ids.push_back(tuple_ids[pos]);
+            }
+        }
+
+        keys.swap(new_keys);
+        tuple_ids.swap(new_ids);
+        delta.clear();
+        tombstones.clear();
+        train();
+    }
+
+    void LearnedIndex::insert(const string &key, TupleId tuple_id)
+    {
+        uint32_t number;
+        if (!toNumber(key, number))
+        {
+            return;
+        }
+
+        if (tombstones.erase({number, tuple_id}))
+        {
+            return; // Entry was removed from the array and is back again
+        }
+
+        delta.insert({number, tuple_id});
+        if (delta.size() >= max(MIN_DELTA_MERGE, keys.size() / 8))
+        {
+            merge();
+        }
+    }
+
+    vector<TupleId> LearnedIndex::lookup(const string &key)
+    {
+        vector<TupleId> result;
+        uint32_t number;
+        if (!toNumber(key, number))
+        {
+            return result;
+        }
+
+        for (size_t pos = lowerBound(number); pos < keys.size() && keys[pos] == number; pos++)
+        {
+            if (isLive(pos))
+            {
+                result.push_back(tuple_ids[pos]);
+            }
+        }
+        for (auto it = delta.lower_bound({number, 0}); it != delta.end() && it->first == number; ++it)
+        {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+
+    bool LearnedIndex::remove(const string &key, TupleId tuple_id)
+    {
+        uint32_t number;
+        if (!toNumber(key, number))
+        {
+            return false;
+        }
+
+        if (delta.erase({number, tuple_id}))
+        {
+            return true; // Never reached the array
+        }
+
+        for (size_t pos = lowerBound(number); pos < keys.size() && keys[pos] == number; pos++)
+        {
+            if (tuple_ids[pos] == tuple_id)
+            {
+                if (!tombstones.insert({number, tuple_id}).second)
+                {
+                    return false; // Already removed
+                }
+                if (tombstones.size() >= max(MIN_DELTA_MERGE, keys.size() / 8))
+                {
+                    merge();
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void LearnedIndex::bulkLoad(const vector<pair<string, TupleId>> &entries)
+    {
+        if (size() > 0)
+        {
+            Index::bulkLoad(entries);
+            return;
+        }
+
+        vector<pair<uint32_t, TupleId>> sorted;
+        sorted.reserve(entries.size());
+        for (const auto &entry : entries)
+        {
+            uint32_t number;
+            if (toNumber(entry.first, number))
+            {
+                sorted.emplace_back(number, entry.second);
+            }
+        }
+        if (!is_sorted(sorted.begin(), sorted.end()))
+        {
+            sort(sorted.begin(), sorted.end());
+        }
+
+        keys.clear();
+        tuple_ids.clear();
+        keys.reserve(sorted.size());
+        tuple_ids.reserve(sorted.size());
+        for (const auto &entry : sorted)
+        {
+            keys.push_back(entry.first);
+            tuple_ids.push_back(entry.second);
+        }
+        train();
+    }
+
+    // Walk the array and the delta side by side in key order
+    void LearnedIndex::scanRange(const KeyRange &range, const IndexVisitor &visitor)
+    {
+        // Start at the first key >= the low bound cut or zero-padded to 4 bytes
+        // (never past a key in range; aboveLow drops the few extra keys)
+        uint32_t start = 0;
+        if (range.has_low)
+        {
+            string low = range.low.substr(0, 4);
+            low.resize(4, '\0');
+            toNumber(low, start);
+        }
+
+        size_t pos = lowerBound(start);
+        auto it = delta.lower_bound({start, 0});
+        while (pos < keys.size() || it != delta.end())
+        {
+            uint32_t number;
+            TupleId tuple_id;
+            if (it == delta.end() || (pos < keys.size() && make_pair(keys[pos], tuple_ids[pos]) < *it))
+            {
+                if (!isLive(pos))
+                {
+                    pos++;
+                    continue;
+                }
+                number = keys[pos];
+                tuple_id = tuple_ids[pos++];
+            }
+            else
+            {
+                number = it->first;
+                tuple_id = it->second;
+                ++it;
+            }
+
+            string key = toKey(number);
+            if (!range.aboveLow(key))
+            {
+                continue;
+            }
+            if (!range.belowHigh(key) || !visitor(key, tuple_id))
+            {
+                return;
+            }
+        }
+    }
+
+} // namespace db
@@ -7,6 +7,7 @@
 #include <iomanip>
 #include <type_traits>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -17,18 +18,30 @@ void printHelp()
     cout << "Mini Database Engine Commands:" << endl;
     cout << "  CREATE TABLE <name> (<col1> <type1>, <col2> <type2>, ...)" << endl;
     cout << "  INSERT INTO <table> VALUES (<val1>, <val2>, ...)" << endl;
-    cout << "  SELECT * FROM <table> [WHERE <column> = <value>]" << endl;
+    cout << "  SELECT *|<col1>|<FUNC>(<col>|*), ... FROM <table> [JOIN <table> ON <col> = <col> ...]" << endl;
+    cout << "      [WHERE <expr>] [GROUP BY <col>, ...]" << endl;
+    cout << "      [ORDER BY <col> [ASC|DESC], ...] [LIMIT <n>] [OFFSET <m>]" << endl;
+    cout << "  UPDATE <table> SET <col> = <value> [, ...] [WHERE ...]" << endl;
+    cout << "  DELETE FROM <table> [WHERE ...]" << endl;
     cout << "  DROP TABLE <name>" << endl;
-    cout << "  CREATE INDEX <table>.<column>" << endl;
+    cout << "  CREATE INDEX <table>.<column> [USING BTREE|HASH|ART|BITMAP|LEARNED]" << endl;
+    cout << "  CREATE INDEX <table> (<col1>, <col2>, ...) [INCLUDE (<col>, ...)] [USING BTREE|HASH|ART|BITMAP|LEARNED]" << endl;
+    cout << "  CREATE INDEX ... [WHERE <column> <op> <value> [AND ...]]  (partial index)" << endl;
     cout << "  BEGIN" << endl;
     cout << "  COMMIT" << endl;
     cout << "  ROLLBACK" << endl;
     cout << "  STATS" << endl;
     cout << "  LOGS" << endl;           // Show WAL logs
     cout << "  VERBOSE ON/OFF" << endl; // Toggle verbose logging
+    cout << "  VECTORIZED ON/OFF" << endl;  // Batch or row-at-a-time SELECT execution
+    cout << "  WORK_MEM <KB>" << endl;      // Memory a sort or aggregation may use before spilling to disk
+    cout << "  PARALLEL <threads>" << endl; // Threads a full-table aggregation may use
     cout << "  HELP" << endl;
     cout << "  EXIT" << endl;
     cout << endl;
+    cout << "WHERE <expr>: <column> <op> <value>, <column> [NOT] BETWEEN <a> AND <b>," << endl;
+    cout << "  <column> [NOT] IN (<val>, ...), <column> IS [NOT] NULL, joined by AND / OR / NOT and ()" << endl;
+    cout << "FUNC: COUNT, SUM, AVG, MIN, MAX" << endl;
     cout << "Data Types: INTEGER, VARCHAR(n), BOOLEAN, DOUBLE" << endl;
 }
 
@@ -86,11 +99,11 @@ void displayQueryResults(const db::QueryResult &result, const string &query,
             cout << BLUE << "[LOG] Reading " << result.tuples.size() << " tuples from storage" << RESET << endl;
         }
 
-        // Extract table name and get schema for dynamic formatting
+        // Use the result's own columns (projections), else the table's schema
         string table_name = extractTableName(query);
-        if (!table_name.empty())
+        if (!table_name.empty() || !result.schema.columns.empty())
         {
-            auto schema = db.getTableSchema(table_name);
+            auto schema = result.schema.columns.empty() ? db.getTableSchema(table_name) : result.schema;
             if (!schema.columns.empty())
             {
                 // Calculate column widths
@@ -285,6 +298,52 @@ int main()
             verbose_mode = false;
             cout << "✓ Verbose logging disabled" << endl;
         }
+        else if (upper_input == "VECTORIZED ON")
+        {
+            db.setVectorized(true);
+            cout << "✓ Vectorized execution enabled - SELECT processes 1024-row column batches" << endl;
+        }
+        else if (upper_input == "VECTORIZED OFF")
+        {
+            db.setVectorized(false);
+            cout << "✓ Vectorized execution disabled - SELECT processes one row at a time" << endl;
+        }
+        else if (upper_input.rfind("WORK_MEM", 0) == 0)
+        {
+            // WORK_MEM <KB> - sorts and aggregations larger than this spill to disk
+            try
+            {
+                long kilobytes = stol(input.substr(8));
+                if (kilobytes <= 0)
+                {
+                    throw invalid_argument("not positive");
+                }
+                db.setWorkMemory(static_cast<size_t>(kilobytes) * 1024);
+                cout << "✓ Work memory set to " << kilobytes << " KB" << endl;
+            }
+            catch (const exception &)
+            {
+                cout << "Usage: WORK_MEM <KB> (a positive number of kilobytes)" << endl;
+            }
+        }
+        else if (upper_input.rfind("PARALLEL", 0) == 0)
+        {
+            // PARALLEL <threads> - aggregations over a whole table split across this many threads
+            try
+            {
+                long threads = stol(input.substr(8));
+                if (threads <= 0)
+                {
+                    throw invalid_argument("not positive");
+                }
+                db.setParallelWorkers(static_cast<size_t>(threads));
+                cout << "✓ Parallel aggregation set to " << threads << " thread(s)" << endl;
+            }
+            catch (const exception &)
+            {
+                cout << "Usage: PARALLEL <threads> (a positive number; 1 = single-threaded)" << endl;
+            }
+        }
         else if (upper_input == "BEGIN")
         {
             logOperation(verbose_mode, "Starting transaction", "Acquiring locks and initializing WAL entry");
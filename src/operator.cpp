@@ -0,0 +1,2044 @@
+#include "operator.h"
+#include "storage_engine.h"
+#include "key_encoding.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <functional>
+#include <system_error>
+#include <thread>
+
+using namespace std;
+
+namespace db
+{
+
+    // Row-at-a-time fallback for operators without a vectorized implementation
+    bool Operator::nextBatch(RowBatch &batch)
+    {
+        batch.reset(schema);
+        Tuple tuple;
+        while (!batch.full() && next(tuple))
+        {
+            batch.appendRow(move(tuple));
+        }
+        return batch.size > 0;
+    }
+
+    // ---- SeqScanOperator ----
+
+    SeqScanOperator::SeqScanOperator(Table *table, vector<bool> decode_columns)
+        : table(table), decode_columns(move(decode_columns)), next_page(0), page_position(0)
+    {
+        schema = table->getSchema();
+    }
+
+    void SeqScanOperator::open()
+    {
+        next_page = table->getFirstPageId();
+        page_rows.clear();
+        page_position = 0;
+    }
+
+    // Return buffered rows, reading the next page whenever the buffer runs out
+    bool SeqScanOperator::next(Tuple &tuple)
+    {
+        while (page_position >= page_rows.size())
+        {
+            if (next_page == 0)
+            {
+                return false; // End of the page chain
+            }
+            PageId page_id = next_page;
+            page_rows = table->scanPage(page_id, next_page, decode_columns.empty() ? nullptr : &decode_columns);
+            page_position = 0;
+        }
+
+        tuple = move(page_rows[page_position++]);
+        return true;
+    }
+
+    // Fill the batch from as many pages as it takes (page_position is the row to
+    // resume at when the previous batch filled up in the middle of a page)
+    bool SeqScanOperator::nextBatch(RowBatch &batch)
+    {
+        batch.reset(schema);
+        const vector<bool> *mask = decode_columns.empty() ? nullptr : &decode_columns;
+        while (!batch.full() && next_page != 0)
+        {
+            PageId following = 0;
+            if (table->scanPageInto(next_page, page_position, batch, following, mask))
+            {
+                next_page = following;
+                page_position = 0;
+            }
+        }
+        return batch.size > 0;
+    }
+
+    void SeqScanOperator::close()
+    {
+        page_rows.clear();
+        page_rows.shrink_to_fit();
+        next_page = 0;
+    }
+
+    // ---- IndexScanOperator ----
+
+    IndexScanOperator::IndexScanOperator(Table *table, vector<Condition> conditions, vector<bool> decode_columns,
+                                         vector<string> covered_columns, ExprPtr where)
+        : table(table), conditions(move(conditions)), where(move(where)), decode_columns(move(decode_columns)),
+          covered_columns(move(covered_columns)), position(0)
+    {
+        schema = table->getSchema();
+    }
+
+    void IndexScanOperator::open()
+    {
+        position = 0;
+        tuple_ids.clear();
+        index_rows.clear();
+        fallback.reset();
+
+        if (!covered_columns.empty())
+        {
+            // Index-only scan - selectColumns reads the covering index; put each value
+            // back at its column's position so rows keep the table's layout
+            vector<int> column_ids;
+            for (const auto &column : covered_columns)
+            {
+                column_ids.push_back(schema.findColumn(column));
+            }
+            for (auto &row : table->selectColumns(covered_columns, conditions))
+            {
+                Tuple tuple;
+                tuple.id = row.id;
+                tuple.values.resize(schema.columns.size());
+                for (size_t i = 0; i < column_ids.size(); i++)
+                {
+                    tuple.values[column_ids[i]] = move(row.values[i]);
+                }
+                index_rows.push_back(move(tuple));
+            }
+            return;
+        }
+
+        if (!table->findCandidates(conditions, tuple_ids, where.get()))
+        {
+            // The index the plan was built for is gone - read every page instead
+            fallback = make_unique<SeqScanOperator>(table, decode_columns);
+            fallback->open();
+        }
+    }
+
+    bool IndexScanOperator::next(Tuple &tuple)
+    {
+        if (fallback)
+        {
+            return fallback->next(tuple);
+        }
+        if (!covered_columns.empty())
+        {
+            if (position >= index_rows.size())
+            {
+                return false;
+            }
+            tuple = move(index_rows[position++]);
+            return true;
+        }
+
+        // Fetch candidates one at a time (rows deleted since open() are skipped)
+        while (position < tuple_ids.size())
+        {
+            if (table->readTuple(tuple_ids[position++], tuple, decode_columns.empty() ? nullptr : &decode_columns))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void IndexScanOperator::close()
+    {
+        if (fallback)
+        {
+            fallback->close();
+            fallback.reset();
+        }
+        tuple_ids.clear();
+        tuple_ids.shrink_to_fit();
+        index_rows.clear();
+        index_rows.shrink_to_fit();
+    }
+
+    // ---- IndexOrderScanOperator ----
+
+    IndexOrderScanOperator::IndexOrderScanOperator(Table *table, string index_name, vector<bool> decode_columns)
+        : table(table), index_name(move(index_name)), decode_columns(move(decode_columns)), position(0),
+          started(false), finished(false)
+    {
+        schema = table->getSchema();
+    }
+
+    void IndexOrderScanOperator::open()
+    {
+        tuple_ids.clear();
+        position = 0;
+        last_key.clear();
+        started = false;
+        finished = false;
+    }
+
+    // Fetch rows in index order, reading the next chunk of IDs whenever one runs out
+    // (rows deleted since their IDs were read are skipped)
+    bool IndexOrderScanOperator::next(Tuple &tuple)
+    {
+        const vector<bool> *mask = decode_columns.empty() ? nullptr : &decode_columns;
+        while (true)
+        {
+            while (position >= tuple_ids.size())
+            {
+                if (finished)
+                {
+                    return false;
+                }
+                if (!table->readIndexInOrder(index_name, !started, last_key, CHUNK_SIZE, tuple_ids))
+                {
+                    throw runtime_error("Index was dropped during the query: " + index_name);
+                }
+                started = true;
+                position = 0;
+                finished = tuple_ids.size() < CHUNK_SIZE; // A short chunk ends the index
+            }
+
+            if (table->readTuple(tuple_ids[position++], tuple, mask))
+            {
+                return true;
+            }
+        }
+    }
+
+    void IndexOrderScanOperator::close()
+    {
+        tuple_ids.clear();
+        tuple_ids.shrink_to_fit();
+        finished = true;
+    }
+
+    // ---- FilterOperator ----
+
+    FilterOperator::FilterOperator(OperatorPtr child, CompiledPredicate predicate)
+        : child(move(child)), predicate(move(predicate))
+    {
+        schema = this->child->getSchema();
+    }
+
+    void FilterOperator::open()
+    {
+        child->open();
+    }
+
+    bool FilterOperator::next(Tuple &tuple)
+    {
+        while (child->next(tuple))
+        {
+            if (predicate(tuple.values))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Skip batches the predicate empties, so callers always get selected rows
+    bool FilterOperator::nextBatch(RowBatch &batch)
+    {
+        while (child->nextBatch(batch))
+        {
+            predicate.filter(batch, batch.selection);
+            if (!batch.selection.empty())
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void FilterOperator::close()
+    {
+        child->close();
+    }
+
+    // ---- ProjectOperator ----
+
+    ProjectOperator::ProjectOperator(OperatorPtr child, vector<int> column_ids)
+        : child(move(child)), column_ids(move(column_ids))
+    {
+        const Schema &input = this->child->getSchema();
+        last_use.assign(this->column_ids.size(), true);
+        for (size_t i = 0; i < this->column_ids.size(); i++)
+        {
+            schema.columns.push_back(input.columns[this->column_ids[i]]);
+            for (size_t j = i + 1; j < this->column_ids.size(); j++)
+            {
+                last_use[i] = last_use[i] && this->column_ids[j] != this->column_ids[i];
+            }
+        }
+    }
+
+    void ProjectOperator::open()
+    {
+        child->open();
+    }
+
+    bool ProjectOperator::next(Tuple &tuple)
+    {
+        Tuple row;
+        if (!child->next(row))
+        {
+            return false;
+        }
+
+        tuple.id = row.id;
+        tuple.values.clear();
+        tuple.values.reserve(column_ids.size());
+        for (size_t i = 0; i < column_ids.size(); i++)
+        {
+            Value &value = row.values[column_ids[i]];
+            tuple.values.push_back(last_use[i] ? move(value) : value);
+        }
+        return true;
+    }
+
+    // The output batch takes the child's column vectors by swapping them (the child
+    // gets the old buffers back to refill); repeated columns are copied
+    bool ProjectOperator::nextBatch(RowBatch &batch)
+    {
+        if (!child->nextBatch(input))
+        {
+            return false;
+        }
+
+        batch.size = input.size;
+        batch.ids.swap(input.ids);
+        batch.selection.swap(input.selection);
+        batch.columns.resize(column_ids.size());
+        for (size_t i = 0; i < column_ids.size(); i++)
+        {
+            if (last_use[i])
+            {
+                swap(batch.columns[i], input.columns[column_ids[i]]);
+            }
+            else
+            {
+                batch.columns[i] = input.columns[column_ids[i]];
+            }
+        }
+        return true;
+    }
+
+    void ProjectOperator::close()
+    {
+        child->close();
+        input = RowBatch();
+    }
+
+    // ---- LimitOperator ----
+
+    LimitOperator::LimitOperator(OperatorPtr child, size_t limit, size_t offset)
+        : child(move(child)), limit(limit), offset(offset), skipped(0), returned(0), child_open(false)
+    {
+        schema = this->child->getSchema();
+    }
+
+    void LimitOperator::open()
+    {
+        skipped = 0;
+        returned = 0;
+        child_open = false;
+        if (limit == 0)
+        {
+            return; // LIMIT 0 never reads a row - don't even open the child
+        }
+        child->open();
+        child_open = true;
+    }
+
+    void LimitOperator::finish()
+    {
+        if (child_open)
+        {
+            child->close();
+            child_open = false;
+        }
+    }
+
+    bool LimitOperator::next(Tuple &tuple)
+    {
+        if (!child_open)
+        {
+            return false; // Limit reached - don't pull rows nobody will see
+        }
+
+        // Skip the offset rows on the first call
+        while (skipped < offset)
+        {
+            if (!child->next(tuple))
+            {
+                finish();
+                return false;
+            }
+            skipped++;
+        }
+
+        if (!child->next(tuple))
+        {
+            finish();
+            return false;
+        }
+        if (++returned >= limit)
+        {
+            finish();
+        }
+        return true;
+    }
+
+    bool LimitOperator::nextBatch(RowBatch &batch)
+    {
+        while (child_open && child->nextBatch(batch))
+        {
+            // Drop offset rows from the front, then anything past the limit
+            vector<uint32_t> &selection = batch.selection;
+            size_t skip = min(offset - skipped, selection.size());
+            selection.erase(selection.begin(), selection.begin() + skip);
+            skipped += skip;
+            if (selection.size() > limit - returned)
+            {
+                selection.resize(limit - returned);
+            }
+
+            returned += selection.size();
+            if (returned >= limit)
+            {
+                finish();
+            }
+            if (!selection.empty())
+            {
+                return true;
+            }
+        }
+        finish();
+        return false;
+    }
+
+    void LimitOperator::close()
+    {
+        finish();
+    }
+
+    // ---- SortOperator ----
+
+    // Append a row's normalized sort key - the concatenated key encodings of its sort
+    // columns (value_of(column) gives the row's value). A DESC column's bytes are
+    // inverted, which reverses its order and, the encodings being prefix-free, leaves
+    // later columns unaffected.
+    template <typename ValueOf>
+    static void appendSortKey(string &key, const vector<SortKey> &keys, ValueOf &&value_of)
+    {
+        for (const auto &sort_key : keys)
+        {
+            size_t start = key.size();
+            appendKey(key, value_of(sort_key.column));
+            if (sort_key.descending)
+            {
+                for (size_t i = start; i < key.size(); i++)
+                {
+                    key[i] = static_cast<char>(~static_cast<uint8_t>(key[i]));
+                }
+            }
+        }
+    }
+
+    // Spill file record (sort runs, aggregation and join partitions): a 32-bit length,
+    // then the key (32-bit length + bytes), the tuple ID and every value as a type byte
+    // (its DataType) followed by its key encoding. Files are temporary and read back by
+    // the same process, so integers are written in native byte order.
+    static void writeSpillRow(FILE *file, const SpillRow &row)
+    {
+        string record;
+        uint32_t key_length = static_cast<uint32_t>(row.key.size());
+        record.append(reinterpret_cast<const char *>(&key_length), sizeof(key_length));
+        record += row.key;
+        record.append(reinterpret_cast<const char *>(&row.tuple.id), sizeof(row.tuple.id));
+        for (const auto &value : row.tuple.values)
+        {
+            record.push_back(static_cast<char>(value.index())); // Variant order matches DataType
+            appendKey(record, value);
+        }
+
+        uint32_t length = static_cast<uint32_t>(record.size());
+        if (fwrite(&length, sizeof(length), 1, file) != 1 ||
+            fwrite(record.data(), 1, record.size(), file) != record.size())
+        {
+            throw runtime_error("Could not write to a spill file");
+        }
+    }
+
+    // Read the next record written by writeSpillRow - returns false at the end of the file
+    static bool readSpillRow(FILE *file, SpillRow &row)
+    {
+        uint32_t length = 0;
+        if (fread(&length, sizeof(length), 1, file) != 1)
+        {
+            return false;
+        }
+        string record(length, '\0');
+        uint32_t key_length = 0;
+        if (fread(&record[0], 1, length, file) != length || length < sizeof(key_length) + sizeof(TupleId))
+        {
+            throw runtime_error("Spill file is corrupted");
+        }
+
+        size_t pos = 0;
+        memcpy(&key_length, record.data(), sizeof(key_length));
+        pos += sizeof(key_length);
+        row.key.assign(record, pos, key_length);
+        pos += key_length;
+        memcpy(&row.tuple.id, record.data() + pos, sizeof(TupleId));
+        pos += sizeof(TupleId);
+
+        row.tuple.values.clear();
+        while (pos < record.size())
+        {
+            DataType type = static_cast<DataType>(record[pos++]);
+            Value value;
+            if (!decodeKey(record, pos, type, value))
+            {
+                throw runtime_error("Spill file is corrupted");
+            }
+            row.tuple.values.push_back(move(value));
+        }
+        return true;
+    }
+
+    // Rough memory held by a buffered row (strings longer than the inline buffer count
+    // their heap allocation)
+    static size_t spillRowBytes(const SpillRow &row)
+    {
+        size_t bytes = sizeof(SpillRow) + row.key.capacity() + row.tuple.values.capacity() * sizeof(Value);
+        for (const auto &value : row.tuple.values)
+        {
+            if (holds_alternative<string>(value))
+            {
+                bytes += get<string>(value).capacity();
+            }
+        }
+        return bytes;
+    }
+
+    SortOperator::RunMerger::RunMerger(vector<FILE *> runs)
+        : runs(move(runs))
+    {
+        heads.resize(this->runs.size());
+        for (size_t i = 0; i < this->runs.size(); i++)
+        {
+            rewind(this->runs[i]);
+            if (readSpillRow(this->runs[i], heads[i]))
+            {
+                heap.push_back(i);
+            }
+        }
+        make_heap(heap.begin(), heap.end(), [this](size_t a, size_t b)
+                  { return after(a, b); });
+    }
+
+    SortOperator::RunMerger::~RunMerger()
+    {
+        for (FILE *run : runs)
+        {
+            fclose(run); // Temporary files are deleted when closed
+        }
+    }
+
+    bool SortOperator::RunMerger::after(size_t a, size_t b) const
+    {
+        int cmp = heads[a].key.compare(heads[b].key);
+        return cmp != 0 ? cmp > 0 : a > b;
+    }
+
+    bool SortOperator::RunMerger::next(SpillRow &row)
+    {
+        if (heap.empty())
+        {
+            return false;
+        }
+        auto order = [this](size_t a, size_t b)
+        { return after(a, b); };
+
+        pop_heap(heap.begin(), heap.end(), order);
+        size_t run = heap.back();
+        row = move(heads[run]);
+        if (readSpillRow(runs[run], heads[run]))
+        {
+            push_heap(heap.begin(), heap.end(), order); // Refill from the same run
+        }
+        else
+        {
+            heap.pop_back(); // Run used up
+        }
+        return true;
+    }
+
+    SortOperator::SortOperator(OperatorPtr child, vector<SortKey> keys, size_t memory_budget, bool vectorized)
+        : child(move(child)), keys(move(keys)), memory_budget(memory_budget), vectorized(vectorized),
+          buffered_bytes(0), position(0), spilled_runs(0)
+    {
+        schema = this->child->getSchema();
+    }
+
+    SortOperator::~SortOperator()
+    {
+        close();
+    }
+
+    string SortOperator::sortKey(const Tuple &tuple) const
+    {
+        string key;
+        appendSortKey(key, keys, [&](int column) -> const Value &
+                      { return tuple.values[column]; });
+        return key;
+    }
+
+    void SortOperator::addRow(Tuple &&tuple)
+    {
+        SpillRow row;
+        row.key = sortKey(tuple);
+        row.tuple = move(tuple);
+        buffered_bytes += spillRowBytes(row);
+        rows.push_back(move(row));
+
+        if (buffered_bytes >= memory_budget)
+        {
+            spillRun();
+        }
+    }
+
+    void SortOperator::spillRun()
+    {
+        stable_sort(rows.begin(), rows.end(), [](const SpillRow &a, const SpillRow &b)
+                    { return a.key < b.key; });
+
+        FILE *run = tmpfile();
+        if (!run)
+        {
+            throw runtime_error("Could not create a sort spill file");
+        }
+        runs.push_back(run);
+        for (const auto &row : rows)
+        {
+            writeSpillRow(run, row);
+        }
+
+        rows.clear();
+        rows.shrink_to_fit();
+        buffered_bytes = 0;
+        spilled_runs++;
+    }
+
+    // Each pass merges consecutive groups of runs into one, keeping the runs in input
+    // order so the final merge stays stable
+    void SortOperator::reduceRuns()
+    {
+        while (runs.size() > MAX_MERGE_FAN_IN)
+        {
+            vector<FILE *> merged;
+            for (size_t first = 0; first < runs.size(); first += MAX_MERGE_FAN_IN)
+            {
+                size_t last = min(first + MAX_MERGE_FAN_IN, runs.size());
+                if (last - first == 1)
+                {
+                    merged.push_back(runs[first]);
+                    continue;
+                }
+
+                FILE *output = tmpfile();
+                if (!output)
+                {
+                    throw runtime_error("Could not create a sort spill file");
+                }
+                merged.push_back(output);
+
+                RunMerger group(vector<FILE *>(runs.begin() + first, runs.begin() + last));
+                fill(runs.begin() + first, runs.begin() + last, nullptr); // Owned by the merger now
+                SpillRow row;
+                while (group.next(row))
+                {
+                    writeSpillRow(output, row);
+                }
+            }
+            runs = move(merged);
+        }
+    }
+
+    // Sorting needs every row, so open() drains the child
+    void SortOperator::open()
+    {
+        close();
+        child->open();
+        spilled_runs = 0;
+
+        if (vectorized)
+        {
+            RowBatch batch;
+            while (child->nextBatch(batch))
+            {
+                for (uint32_t row : batch.selection)
+                {
+                    addRow(batch.takeRow(row));
+                }
+            }
+        }
+        else
+        {
+            Tuple tuple;
+            while (child->next(tuple))
+            {
+                addRow(move(tuple));
+            }
+        }
+        child->close();
+
+        if (runs.empty())
+        {
+            // Everything fit in the budget - sort in memory
+            stable_sort(rows.begin(), rows.end(), [](const SpillRow &a, const SpillRow &b)
+                        { return a.key < b.key; });
+            return;
+        }
+
+        // The rest becomes the last run, then the runs are merged as next() is called
+        if (!rows.empty())
+        {
+            spillRun();
+        }
+        reduceRuns();
+        merger = make_unique<RunMerger>(move(runs));
+        runs.clear();
+    }
+
+    bool SortOperator::next(Tuple &tuple)
+    {
+        if (merger)
+        {
+            SpillRow row;
+            if (!merger->next(row))
+            {
+                merger.reset(); // Closes and deletes the spill files
+                return false;
+            }
+            tuple = move(row.tuple);
+            return true;
+        }
+
+        if (position >= rows.size())
+        {
+            return false;
+        }
+        tuple = move(rows[position++].tuple);
+        return true;
+    }
+
+    void SortOperator::close()
+    {
+        rows.clear();
+        rows.shrink_to_fit();
+        buffered_bytes = 0;
+        position = 0;
+        merger.reset();
+        for (FILE *run : runs)
+        {
+            if (run) // Null once handed to a merger
+            {
+                fclose(run);
+            }
+        }
+        runs.clear();
+    }
+
+    // ---- TopNOperator ----
+
+    TopNOperator::TopNOperator(OperatorPtr child, vector<SortKey> keys, size_t limit, bool vectorized)
+        : child(move(child)), keys(move(keys)), limit(limit), vectorized(vectorized), position(0)
+    {
+        schema = this->child->getSchema();
+    }
+
+    bool TopNOperator::before(const HeapRow &a, const HeapRow &b)
+    {
+        int cmp = a.key.compare(b.key);
+        return cmp != 0 ? cmp < 0 : a.sequence < b.sequence;
+    }
+
+    // Read the whole child, keeping only the best limit rows
+    void TopNOperator::open()
+    {
+        child->open();
+        rows.clear();
+        position = 0;
+
+        size_t sequence = 0;
+        string key;
+
+        // Offer one row: build its key and keep the row only if it beats the worst one
+        // kept (a later row with an equal key never does); take_row produces the Tuple
+        auto offer = [&](auto &&value_of, auto &&take_row)
+        {
+            key.clear();
+            appendSortKey(key, keys, value_of);
+            size_t row_sequence = sequence++;
+            if (rows.size() == limit)
+            {
+                if (limit == 0 || key >= rows.front().key)
+                {
+                    return;
+                }
+                pop_heap(rows.begin(), rows.end(), before); // Evict the worst row
+                rows.pop_back();
+            }
+            rows.push_back({key, row_sequence, take_row()});
+            push_heap(rows.begin(), rows.end(), before);
+        };
+
+        if (vectorized)
+        {
+            RowBatch batch;
+            while (child->nextBatch(batch))
+            {
+                for (uint32_t row : batch.selection)
+                {
+                    offer([&](int column)
+                          { return batch.columns[column].get(row); },
+                          [&]()
+                          { return batch.takeRow(row); });
+                }
+            }
+        }
+        else
+        {
+            Tuple tuple;
+            while (child->next(tuple))
+            {
+                offer([&](int column) -> const Value &
+                      { return tuple.values[column]; },
+                      [&]()
+                      { return move(tuple); });
+            }
+        }
+        child->close();
+
+        sort_heap(rows.begin(), rows.end(), before);
+    }
+
+    bool TopNOperator::next(Tuple &tuple)
+    {
+        if (position >= rows.size())
+        {
+            return false;
+        }
+        tuple = move(rows[position++].tuple);
+        return true;
+    }
+
+    void TopNOperator::close()
+    {
+        rows.clear();
+        rows.shrink_to_fit();
+    }
+
+    // ---- AggregateState ----
+
+    void AggregateState::add(const Value &value)
+    {
+        if (holds_alternative<int32_t>(value))
+        {
+            int_sum += get<int32_t>(value);
+        }
+        else if (holds_alternative<double>(value))
+        {
+            double_sum += get<double>(value);
+        }
+
+        if (count == 0 || compareValues(value, min) < 0)
+        {
+            min = value;
+        }
+        if (count == 0 || compareValues(value, max) > 0)
+        {
+            max = value;
+        }
+        count++;
+    }
+
+    // Sum, smallest and largest of the selected values of a typed array
+    template <typename C, typename S>
+    static void foldArray(const vector<C> &data, const vector<uint32_t> &selection, S &sum, C &low, C &high)
+    {
+        low = data[selection[0]];
+        high = low;
+        for (uint32_t row : selection)
+        {
+            const C &value = data[row];
+            sum += value;
+            low = value < low ? value : low;
+            high = value > high ? value : high;
+        }
+    }
+
+    void AggregateState::addBatch(const ColumnVector &column, const vector<uint32_t> &selection)
+    {
+        if (selection.empty())
+        {
+            return;
+        }
+
+        Value low, high;
+        switch (column.type)
+        {
+        case DataType::INTEGER:
+        {
+            int32_t lo, hi;
+            foldArray(column.ints, selection, int_sum, lo, hi);
+            low = lo;
+            high = hi;
+            break;
+        }
+        case DataType::DOUBLE:
+        {
+            double lo, hi;
+            foldArray(column.doubles, selection, double_sum, lo, hi);
+            low = lo;
+            high = hi;
+            break;
+        }
+        case DataType::BOOLEAN:
+        {
+            uint8_t lo, hi;
+            int64_t true_count = 0; // Booleans have no sum
+            foldArray(column.bools, selection, true_count, lo, hi);
+            low = lo != 0;
+            high = hi != 0;
+            break;
+        }
+        case DataType::VARCHAR:
+        {
+            // Track positions so only the two winning strings are copied
+            uint32_t lo = selection[0];
+            uint32_t hi = lo;
+            for (uint32_t row : selection)
+            {
+                lo = column.strings[row] < column.strings[lo] ? row : lo;
+                hi = column.strings[row] > column.strings[hi] ? row : hi;
+            }
+            low = column.strings[lo];
+            high = column.strings[hi];
+            break;
+        }
+        }
+
+        if (count == 0 || compareValues(low, min) < 0)
+        {
+            min = move(low);
+        }
+        if (count == 0 || compareValues(high, max) > 0)
+        {
+            max = move(high);
+        }
+        count += static_cast<int64_t>(selection.size());
+    }
+
+    void AggregateState::merge(const AggregateState &other)
+    {
+        if (other.count == 0)
+        {
+            return;
+        }
+        int_sum += other.int_sum;
+        double_sum += other.double_sum;
+        if (count == 0 || compareValues(other.min, min) < 0)
+        {
+            min = other.min;
+        }
+        if (count == 0 || compareValues(other.max, max) > 0)
+        {
+            max = other.max;
+        }
+        count += other.count;
+    }
+
+    // A value of the given type standing in for "no rows" (the engine has no NULLs)
+    static Value zeroValue(DataType type)
+    {
+        switch (type)
+        {
+        case DataType::INTEGER:
+            return int32_t(0);
+        case DataType::DOUBLE:
+            return 0.0;
+        case DataType::BOOLEAN:
+            return false;
+        case DataType::VARCHAR:
+        default:
+            return string();
+        }
+    }
+
+    Value AggregateState::result(const AggregateSpec &spec, DataType input_type) const
+    {
+        switch (spec.func)
+        {
+        case AggregateFunc::COUNT:
+            if (count > INT32_MAX)
+            {
+                throw runtime_error(spec.name + " overflows INTEGER");
+            }
+            return static_cast<int32_t>(count);
+        case AggregateFunc::SUM:
+            if (input_type == DataType::DOUBLE)
+            {
+                return double_sum;
+            }
+            if (int_sum < INT32_MIN || int_sum > INT32_MAX)
+            {
+                throw runtime_error(spec.name + " overflows INTEGER");
+            }
+            return static_cast<int32_t>(int_sum);
+        case AggregateFunc::AVG:
+            return count == 0 ? 0.0 : (static_cast<double>(int_sum) + double_sum) / static_cast<double>(count);
+        case AggregateFunc::MIN:
+            return count == 0 ? zeroValue(input_type) : min;
+        case AggregateFunc::MAX:
+            return count == 0 ? zeroValue(input_type) : max;
+        }
+        return int32_t(0);
+    }
+
+    // ---- GroupTable ----
+
+    size_t GroupTable::find(const string &key, size_t hash) const
+    {
+        if (slots.empty())
+        {
+            return NOT_FOUND;
+        }
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask;; i = (i + 1) & mask)
+        {
+            uint32_t slot = slots[i];
+            if (slot == 0)
+            {
+                return NOT_FOUND; // An empty slot ends the probe sequence
+            }
+            const Group &group = groups[slot - 1];
+            if (group.hash == hash && group.key == key)
+            {
+                return slot - 1;
+            }
+        }
+    }
+
+    // Keeps the load factor at or below 1/2, so probe sequences stay short
+    size_t GroupTable::insert(const string &key, size_t hash, size_t aggregate_count)
+    {
+        if ((groups.size() + 1) * 2 > slots.size())
+        {
+            slots.assign(max<size_t>(16, slots.size() * 2), 0);
+            for (size_t i = 0; i < groups.size(); i++)
+            {
+                place(i);
+            }
+        }
+
+        groups.push_back({key, hash, vector<AggregateState>(aggregate_count)});
+        group_bytes += sizeof(Group) + key.capacity() + aggregate_count * sizeof(AggregateState);
+        place(groups.size() - 1);
+        return groups.size() - 1;
+    }
+
+    void GroupTable::place(size_t position)
+    {
+        size_t mask = slots.size() - 1;
+        size_t i = groups[position].hash & mask;
+        while (slots[i] != 0)
+        {
+            i = (i + 1) & mask;
+        }
+        slots[i] = static_cast<uint32_t>(position + 1);
+    }
+
+    void GroupTable::clear()
+    {
+        groups.clear();
+        groups.shrink_to_fit();
+        slots.clear();
+        slots.shrink_to_fit();
+        group_bytes = 0;
+    }
+
+    // ---- AggregateOperator ----
+
+    // Output schema of an aggregation (the group columns, then one column per aggregate)
+    // and the type of each aggregate's input column
+    static void aggregateSchema(const Schema &input, const vector<int> &group_columns,
+                                const vector<AggregateSpec> &aggregates, Schema &schema,
+                                vector<DataType> &input_types)
+    {
+        for (int col_idx : group_columns)
+        {
+            schema.columns.push_back(input.columns[col_idx]);
+        }
+
+        for (const auto &spec : aggregates)
+        {
+            DataType input_type = spec.column >= 0 ? input.columns[spec.column].type : DataType::INTEGER;
+            input_types.push_back(input_type);
+
+            DataType output_type = input_type; // SUM, MIN and MAX keep the column's type
+            if (spec.func == AggregateFunc::COUNT)
+            {
+                output_type = DataType::INTEGER;
+            }
+            else if (spec.func == AggregateFunc::AVG)
+            {
+                output_type = DataType::DOUBLE;
+            }
+            schema.addColumn(spec.name, output_type);
+        }
+    }
+
+    // Output row of a group: group values decoded from the key, then each aggregate's result
+    static Tuple groupRow(const GroupTable::Group &group, const Schema &schema, size_t group_count,
+                          const vector<AggregateSpec> &aggregates, const vector<DataType> &input_types)
+    {
+        Tuple tuple;
+        size_t pos = 0;
+        for (size_t i = 0; i < group_count; i++)
+        {
+            Value value;
+            decodeKey(group.key, pos, schema.columns[i].type, value);
+            tuple.values.push_back(move(value));
+        }
+        for (size_t i = 0; i < aggregates.size(); i++)
+        {
+            tuple.values.push_back(group.states[i].result(aggregates[i], input_types[i]));
+        }
+        return tuple;
+    }
+
+    AggregateOperator::AggregateOperator(OperatorPtr child, vector<int> group_columns,
+                                         vector<AggregateSpec> aggregates, size_t memory_budget, bool vectorized)
+        : child(move(child)), group_columns(move(group_columns)), aggregates(move(aggregates)),
+          memory_budget(memory_budget), vectorized(vectorized), position(0), depth(0), spilled_partitions(0)
+    {
+        aggregateSchema(this->child->getSchema(), this->group_columns, this->aggregates, schema, input_types);
+    }
+
+    AggregateOperator::~AggregateOperator()
+    {
+        close();
+    }
+
+    template <typename AggValue>
+    size_t AggregateOperator::findGroup(const string &key, AggValue &&agg_value)
+    {
+        size_t key_hash = hash<string>{}(key);
+        size_t group = table.find(key, key_hash);
+        if (group != GroupTable::NOT_FOUND)
+        {
+            return group;
+        }
+        if (depth >= MAX_SPILL_DEPTH || table.groups.empty() || table.memoryBytes() < memory_budget)
+        {
+            return table.insert(key, key_hash, aggregates.size());
+        }
+
+        // Table full - the row waits in its partition for a later pass. Each pass picks
+        // the partition with the next 4 bits down from the top of the hash (the table's
+        // slots use the low bits), so a partition's rows spread out again when it spills.
+        size_t partition = (key_hash >> (sizeof(size_t) * 8 - 4 * (depth + 1))) % PARTITIONS;
+        if (spill_files.empty())
+        {
+            spill_files.assign(PARTITIONS, nullptr);
+        }
+        FILE *&file = spill_files[partition];
+        if (!file)
+        {
+            file = tmpfile();
+            if (!file)
+            {
+                throw runtime_error("Could not create an aggregation spill file");
+            }
+            spilled_partitions++;
+        }
+
+        SpillRow row;
+        row.key = key;
+        for (size_t i = 0; i < aggregates.size(); i++)
+        {
+            row.tuple.values.push_back(aggregates[i].column < 0 ? Value(int32_t(0)) : Value(agg_value(i)));
+        }
+        writeSpillRow(file, row);
+        return GroupTable::NOT_FOUND;
+    }
+
+    template <typename AggValue>
+    void AggregateOperator::fold(size_t group, AggValue &&agg_value)
+    {
+        vector<AggregateState> &states = table.groups[group].states;
+        for (size_t i = 0; i < aggregates.size(); i++)
+        {
+            if (aggregates[i].column < 0)
+            {
+                states[i].count++; // COUNT(*) needs no value
+            }
+            else
+            {
+                states[i].add(agg_value(i));
+            }
+        }
+    }
+
+    void AggregateOperator::aggregateChild()
+    {
+        string key;
+        if (vectorized)
+        {
+            RowBatch batch;
+            vector<size_t> slots; // Group of each selected row (NOT_FOUND = spilled)
+            while (child->nextBatch(batch))
+            {
+                if (group_columns.empty())
+                {
+                    // One group - each aggregate is a single loop over its column
+                    vector<AggregateState> &states = table.groups[0].states;
+                    for (size_t i = 0; i < aggregates.size(); i++)
+                    {
+                        if (aggregates[i].column < 0)
+                        {
+                            states[i].count += static_cast<int64_t>(batch.count());
+                        }
+                        else
+                        {
+                            states[i].addBatch(batch.columns[aggregates[i].column], batch.selection);
+                        }
+                    }
+                    continue;
+                }
+
+                slots.clear();
+                for (uint32_t row : batch.selection)
+                {
+                    key.clear();
+                    for (int col_idx : group_columns)
+                    {
+                        appendKey(key, batch.columns[col_idx].get(row));
+                    }
+                    slots.push_back(findGroup(key, [&](size_t i)
+                                              { return batch.columns[aggregates[i].column].get(row); }));
+                }
+                for (size_t i = 0; i < aggregates.size(); i++)
+                {
+                    const int col_idx = aggregates[i].column;
+                    for (size_t k = 0; k < slots.size(); k++)
+                    {
+                        if (slots[k] == GroupTable::NOT_FOUND)
+                        {
+                            continue;
+                        }
+                        AggregateState &state = table.groups[slots[k]].states[i];
+                        if (col_idx < 0)
+                        {
+                            state.count++;
+                        }
+                        else
+                        {
+                            state.add(batch.columns[col_idx].get(batch.selection[k]));
+                        }
+                    }
+                }
+            }
+            return;
+        }
+
+        Tuple tuple;
+        auto agg_value = [&](size_t i) -> const Value &
+        { return tuple.values[aggregates[i].column]; };
+        while (child->next(tuple))
+        {
+            key.clear();
+            for (int col_idx : group_columns)
+            {
+                appendKey(key, tuple.values[col_idx]);
+            }
+            size_t group = findGroup(key, agg_value);
+            if (group != GroupTable::NOT_FOUND)
+            {
+                fold(group, agg_value);
+            }
+        }
+    }
+
+    // Spilled rows hold one value per aggregate, in aggregate order
+    void AggregateOperator::aggregatePartition(FILE *file)
+    {
+        rewind(file);
+        SpillRow row;
+        auto agg_value = [&](size_t i) -> const Value &
+        { return row.tuple.values[i]; };
+        while (readSpillRow(file, row))
+        {
+            size_t group = findGroup(row.key, agg_value);
+            if (group != GroupTable::NOT_FOUND)
+            {
+                fold(group, agg_value);
+            }
+        }
+        fclose(file); // Temporary files are deleted when closed
+    }
+
+    void AggregateOperator::finishPass()
+    {
+        for (FILE *file : spill_files)
+        {
+            if (file)
+            {
+                pending.push_back({file, depth + 1});
+            }
+        }
+        spill_files.clear();
+    }
+
+    // Aggregation needs every row, so open() drains the child; groups that spilled are
+    // aggregated later, partition by partition, as next() runs out of in-memory groups
+    void AggregateOperator::open()
+    {
+        close();
+        spilled_partitions = 0;
+        depth = 0;
+        if (group_columns.empty())
+        {
+            table.insert("", hash<string>{}(""), aggregates.size()); // One group, even with no input rows
+        }
+
+        child->open();
+        aggregateChild();
+        child->close();
+        finishPass();
+    }
+
+    bool AggregateOperator::next(Tuple &tuple)
+    {
+        while (position >= table.groups.size())
+        {
+            if (pending.empty())
+            {
+                return false;
+            }
+            auto [file, file_depth] = pending.back();
+            pending.pop_back();
+            table.clear();
+            position = 0;
+            depth = file_depth;
+            aggregatePartition(file);
+            finishPass();
+        }
+
+        tuple = groupRow(table.groups[position++], schema, group_columns.size(), aggregates, input_types);
+        return true;
+    }
+
+    void AggregateOperator::close()
+    {
+        table.clear();
+        position = 0;
+        for (FILE *file : spill_files)
+        {
+            if (file)
+            {
+                fclose(file);
+            }
+        }
+        spill_files.clear();
+        for (auto &partition : pending)
+        {
+            fclose(partition.first);
+        }
+        pending.clear();
+    }
+
+    // ---- ParallelAggregateOperator ----
+
+    // Run work on count threads (this one included) and wait for them all. If a thread
+    // can't be started the others do its share; the first exception a thread throws is
+    // rethrown once every thread has finished.
+    static void runOnThreads(size_t count, const function<void()> &work)
+    {
+        exception_ptr error;
+        mutex error_latch;
+        auto guarded = [&]()
+        {
+            try
+            {
+                work();
+            }
+            catch (...)
+            {
+                lock_guard<mutex> latch(error_latch);
+                if (!error)
+                {
+                    error = current_exception();
+                }
+            }
+        };
+
+        vector<thread> threads;
+        for (size_t i = 1; i < count; i++)
+        {
+            try
+            {
+                threads.emplace_back(guarded);
+            }
+            catch (const system_error &)
+            {
+                break;
+            }
+        }
+        guarded();
+        for (auto &worker : threads)
+        {
+            worker.join();
+        }
+        if (error)
+        {
+            rethrow_exception(error);
+        }
+    }
+
+    // Partition of a group - the top 4 bits of its hash (group tables probe with the low bits)
+    static size_t groupPartition(size_t hash)
+    {
+        return (hash >> (sizeof(size_t) * 8 - 4)) % ParallelAggregateOperator::PARTITIONS;
+    }
+
+    ParallelAggregateOperator::ParallelAggregateOperator(Table *table, vector<bool> decode_columns,
+                                                         optional<CompiledPredicate> predicate,
+                                                         vector<int> group_columns, vector<AggregateSpec> aggregates,
+                                                         size_t memory_budget, size_t workers)
+        : table(table), decode_columns(move(decode_columns)), predicate(move(predicate)),
+          group_columns(move(group_columns)), aggregates(move(aggregates)), memory_budget(memory_budget),
+          workers(max<size_t>(1, workers)), partition(0), position(0), next_page(0)
+    {
+        aggregateSchema(table->getSchema(), this->group_columns, this->aggregates, schema, input_types);
+    }
+
+    size_t ParallelAggregateOperator::takePages(vector<vector<uint8_t>> &pages)
+    {
+        lock_guard<mutex> latch(cursor_latch);
+        size_t count = 0;
+        while (count < MORSEL_PAGES && next_page != 0)
+        {
+            if (pages.size() <= count)
+            {
+                pages.emplace_back();
+            }
+            PageId page_id = next_page;
+            table->copyPage(page_id, pages[count++], next_page);
+        }
+        return count;
+    }
+
+    void ParallelAggregateOperator::scanPages(vector<GroupTable> &tables, atomic<size_t> &memory_used,
+                                              atomic<bool> &stop)
+    {
+        const Schema &input = table->getSchema();
+        const vector<bool> *mask = decode_columns.empty() ? nullptr : &decode_columns;
+        vector<vector<uint8_t>> pages;
+        RowBatch batch;
+        batch.reset(input);
+
+        size_t count;
+        while (!stop.load(memory_order_relaxed) && (count = takePages(pages)) > 0)
+        {
+            for (size_t k = 0; k < count; k++)
+            {
+                size_t row = 0;
+                bool page_done = false;
+                while (!page_done)
+                {
+                    page_done = table->decodePageInto(pages[k].data(), row, batch, mask);
+                    if (batch.full())
+                    {
+                        aggregateBatch(batch, tables, memory_used, stop);
+                        batch.reset(input);
+                    }
+                }
+            }
+        }
+        if (batch.size > 0 && !stop)
+        {
+            aggregateBatch(batch, tables, memory_used, stop);
+        }
+    }
+
+    void ParallelAggregateOperator::aggregateBatch(RowBatch &batch, vector<GroupTable> &tables,
+                                                   atomic<size_t> &memory_used, atomic<bool> &stop)
+    {
+        if (predicate)
+        {
+            predicate->filter(batch, batch.selection);
+        }
+
+        if (group_columns.empty())
+        {
+            // One group - each aggregate is a single loop over its column
+            vector<AggregateState> &states = tables[groupPartition(hash<string>{}(""))].groups[0].states;
+            for (size_t i = 0; i < aggregates.size(); i++)
+            {
+                if (aggregates[i].column < 0)
+                {
+                    states[i].count += static_cast<int64_t>(batch.count());
+                }
+                else
+                {
+                    states[i].addBatch(batch.columns[aggregates[i].column], batch.selection);
+                }
+            }
+            return;
+        }
+
+        string key;
+        for (uint32_t row : batch.selection)
+        {
+            key.clear();
+            for (int col_idx : group_columns)
+            {
+                appendKey(key, batch.columns[col_idx].get(row));
+            }
+            size_t key_hash = hash<string>{}(key);
+            GroupTable &groups = tables[groupPartition(key_hash)];
+            size_t group = groups.find(key, key_hash);
+            if (group == GroupTable::NOT_FOUND)
+            {
+                size_t before = groups.memoryBytes();
+                group = groups.insert(key, key_hash, aggregates.size());
+                if (memory_used.fetch_add(groups.memoryBytes() - before) > memory_budget)
+                {
+                    stop = true; // Too many groups - the serial plan takes over
+                    return;
+                }
+            }
+
+            vector<AggregateState> &states = groups.groups[group].states;
+            for (size_t i = 0; i < aggregates.size(); i++)
+            {
+                if (aggregates[i].column < 0)
+                {
+                    states[i].count++; // COUNT(*) needs no value
+                }
+                else
+                {
+                    states[i].add(batch.columns[aggregates[i].column].get(row));
+                }
+            }
+        }
+    }
+
+    // The first worker's table of a partition becomes the merged table; the others'
+    // groups are folded into it and freed as they go
+    void ParallelAggregateOperator::mergePartitions(vector<vector<GroupTable>> &worker_tables)
+    {
+        partitions.assign(PARTITIONS, GroupTable());
+        atomic<size_t> next_partition{0};
+        runOnThreads(min(workers, PARTITIONS), [&]()
+                     {
+            for (size_t p = next_partition++; p < PARTITIONS; p = next_partition++)
+            {
+                GroupTable merged = move(worker_tables[0][p]);
+                for (size_t w = 1; w < worker_tables.size(); w++)
+                {
+                    for (const auto &group : worker_tables[w][p].groups)
+                    {
+                        size_t target = merged.find(group.key, group.hash);
+                        if (target == GroupTable::NOT_FOUND)
+                        {
+                            target = merged.insert(group.key, group.hash, aggregates.size());
+                        }
+                        for (size_t i = 0; i < aggregates.size(); i++)
+                        {
+                            merged.groups[target].states[i].merge(group.states[i]);
+                        }
+                    }
+                    worker_tables[w][p].clear();
+                }
+                partitions[p] = move(merged);
+            } });
+    }
+
+    void ParallelAggregateOperator::open()
+    {
+        close();
+
+        // Each worker's tables; without group columns every worker holds the one group,
+        // so the merged result has it even for an empty input
+        vector<vector<GroupTable>> worker_tables(workers, vector<GroupTable>(PARTITIONS));
+        if (group_columns.empty())
+        {
+            size_t key_hash = hash<string>{}("");
+            for (auto &tables : worker_tables)
+            {
+                tables[groupPartition(key_hash)].insert("", key_hash, aggregates.size());
+            }
+        }
+
+        next_page = table->getFirstPageId();
+        atomic<size_t> next_worker{0};
+        atomic<size_t> memory_used{0};
+        atomic<bool> stop{false};
+        runOnThreads(workers, [&]()
+                     {
+            vector<GroupTable> &tables = worker_tables[next_worker++];
+            try
+            {
+                scanPages(tables, memory_used, stop);
+            }
+            catch (...)
+            {
+                stop = true; // Stop the other workers too
+                throw;
+            } });
+
+        if (stop)
+        {
+            // Out of memory (errors were rethrown above): aggregate again on one thread,
+            // letting AggregateOperator spill partitions to disk
+            worker_tables.clear();
+            OperatorPtr plan = make_unique<SeqScanOperator>(table, decode_columns);
+            if (predicate)
+            {
+                plan = make_unique<FilterOperator>(move(plan), *predicate);
+            }
+            fallback = make_unique<AggregateOperator>(move(plan), group_columns, aggregates, memory_budget);
+            fallback->open();
+            return;
+        }
+        mergePartitions(worker_tables);
+    }
+
+    bool ParallelAggregateOperator::next(Tuple &tuple)
+    {
+        if (fallback)
+        {
+            return fallback->next(tuple);
+        }
+
+        while (partition < partitions.size() && position >= partitions[partition].groups.size())
+        {
+            partitions[partition++].clear(); // Returned - free it
+            position = 0;
+        }
+        if (partition >= partitions.size())
+        {
+            return false;
+        }
+        tuple = groupRow(partitions[partition].groups[position++], schema, group_columns.size(), aggregates,
+                         input_types);
+        return true;
+    }
+
+    void ParallelAggregateOperator::close()
+    {
+        fallback.reset(); // Its destructor closes it
+        partitions.clear();
+        partition = 0;
+        position = 0;
+        next_page = 0;
+    }
+
+    // ---- MetadataAggregateOperator ----
+
+    MetadataAggregateOperator::MetadataAggregateOperator(Table *table, vector<AggregateSpec> aggregates,
+                                                         vector<string> bound_indexes)
+        : table(table), aggregates(move(aggregates)), bound_indexes(move(bound_indexes)), returned(false)
+    {
+        aggregateSchema(table->getSchema(), {}, this->aggregates, schema, input_types);
+    }
+
+    void MetadataAggregateOperator::open()
+    {
+        returned = false;
+    }
+
+    // Columns are never NULL, so every aggregate has seen all the table's rows - a state
+    // with that count and the index bound as its MIN / MAX gives the same result as
+    // folding the rows (including the zero values of an empty table)
+    bool MetadataAggregateOperator::next(Tuple &tuple)
+    {
+        if (returned)
+        {
+            return false;
+        }
+        returned = true;
+
+        int64_t row_count = static_cast<int64_t>(table->getTupleCount());
+        tuple = Tuple();
+        for (size_t i = 0; i < aggregates.size(); i++)
+        {
+            AggregateState state;
+            state.count = row_count;
+            if (aggregates[i].func == AggregateFunc::MIN || aggregates[i].func == AggregateFunc::MAX)
+            {
+                Value bound;
+                bool largest = aggregates[i].func == AggregateFunc::MAX;
+                if (row_count == 0 || !table->readIndexBound(bound_indexes[i], largest, bound))
+                {
+                    state.count = 0; // Empty
+                }
+                state.min = bound;
+                state.max = bound;
+            }
+            tuple.values.push_back(state.result(aggregates[i], input_types[i]));
+        }
+        return true;
+    }
+
+    void MetadataAggregateOperator::close()
+    {
+        returned = true; // Nothing more until the next open()
+    }
+
+    // ---- HashJoinOperator ----
+
+    // Partition of a row in a pass - each pass takes the next 4 bits down from the top
+    // of the hash (buckets use the low bits), so a partition split again spreads out
+    static size_t joinPartition(size_t hash, size_t depth)
+    {
+        return (hash >> (sizeof(size_t) * 8 - 4 * (depth + 1))) % HashJoinOperator::PARTITIONS;
+    }
+
+    HashJoinOperator::HashJoinOperator(OperatorPtr left, OperatorPtr right, int left_key, int right_key,
+                                       Schema schema, bool build_left, size_t memory_budget, bool vectorized)
+        : left(move(left)), right(move(right)), left_key(left_key), right_key(right_key), build_left(build_left),
+          memory_budget(memory_budget), vectorized(vectorized), build_bytes(0), batch_position(0),
+          probe_input_done(false), probe_file(nullptr), probe_hash(0), match(0), spilled_partitions(0)
+    {
+        this->schema = move(schema);
+    }
+
+    HashJoinOperator::~HashJoinOperator()
+    {
+        close();
+    }
+
+    bool HashJoinOperator::pullRow(Operator &input, RowBatch &batch, size_t &position, Tuple &tuple)
+    {
+        if (!vectorized)
+        {
+            return input.next(tuple);
+        }
+        while (position >= batch.selection.size())
+        {
+            if (!input.nextBatch(batch))
+            {
+                return false;
+            }
+            position = 0;
+        }
+        tuple = batch.takeRow(batch.selection[position++]);
+        return true;
+    }
+
+    // Chained buckets, at most one row per bucket on average - past that the bucket
+    // array doubles and every chain is rebuilt
+    void HashJoinOperator::addBuildRow(SpillRow &&row, size_t hash)
+    {
+        build_bytes += spillRowBytes(row) + sizeof(BuildRow) - sizeof(SpillRow);
+        build_rows.push_back({move(row), hash, 0});
+
+        auto link = [&](size_t i)
+        {
+            uint32_t &head = buckets[build_rows[i].hash & (buckets.size() - 1)];
+            build_rows[i].next = head;
+            head = static_cast<uint32_t>(i + 1);
+        };
+        if (build_rows.size() > buckets.size())
+        {
+            buckets.assign(max<size_t>(16, buckets.size() * 2), 0);
+            for (size_t i = 0; i < build_rows.size(); i++)
+            {
+                link(i);
+            }
+        }
+        else
+        {
+            link(build_rows.size() - 1);
+        }
+    }
+
+    void HashJoinOperator::clearTable()
+    {
+        build_rows.clear();
+        build_rows.shrink_to_fit();
+        buckets.clear();
+        buckets.shrink_to_fit();
+        build_bytes = 0;
+        match = 0;
+    }
+
+    void HashJoinOperator::spillBuildRows(vector<FILE *> &files, size_t depth)
+    {
+        for (const auto &build_row : build_rows)
+        {
+            writePartition(files, depth, build_row.row, build_row.hash);
+        }
+        clearTable();
+    }
+
+    void HashJoinOperator::writePartition(vector<FILE *> &files, size_t depth, const SpillRow &row, size_t hash)
+    {
+        if (files.empty())
+        {
+            files.assign(PARTITIONS, nullptr);
+        }
+        FILE *&file = files[joinPartition(hash, depth)];
+        if (!file)
+        {
+            file = tmpfile();
+            if (!file)
+            {
+                throw runtime_error("Could not create a join spill file");
+            }
+            spilled_partitions++;
+        }
+        writeSpillRow(file, row);
+    }
+
+    // Probe rows whose build partition is empty can't match anything and are dropped
+    void HashJoinOperator::partitionProbe(FILE *source, const vector<FILE *> &build_files, size_t depth)
+    {
+        vector<FILE *> probe_files(PARTITIONS, nullptr);
+        SpillRow row;
+        auto route = [&]()
+        {
+            size_t key_hash = hash<string>{}(row.key);
+            if (build_files[joinPartition(key_hash, depth)])
+            {
+                writePartition(probe_files, depth, row, key_hash);
+            }
+        };
+
+        if (source)
+        {
+            rewind(source);
+            while (readSpillRow(source, row))
+            {
+                route();
+            }
+        }
+        else
+        {
+            while (pullRow(probeInput(), probe_batch, batch_position, row.tuple))
+            {
+                row.key = encodeKey(row.tuple.values[probeKey()]);
+                route();
+            }
+            probeInput().close();
+            probe_input_done = true;
+        }
+
+        for (size_t p = 0; p < PARTITIONS; p++)
+        {
+            if (build_files[p] && probe_files[p])
+            {
+                pending.push_back({build_files[p], probe_files[p], depth});
+            }
+            else if (build_files[p])
+            {
+                fclose(build_files[p]); // No probe rows - the partition joins to nothing
+            }
+        }
+    }
+
+    // A build partition that outgrows the budget is split again (with its probe
+    // partition) on the next hash bits, until MAX_SPILL_DEPTH passes
+    bool HashJoinOperator::loadPartition()
+    {
+        if (probe_file)
+        {
+            fclose(probe_file); // Temporary files are deleted when closed
+            probe_file = nullptr;
+        }
+
+        while (!pending.empty())
+        {
+            PartitionPair pair = pending.back();
+            pending.pop_back();
+            clearTable();
+
+            bool can_split = pair.depth + 1 < MAX_SPILL_DEPTH;
+            vector<FILE *> split_files;
+            SpillRow row;
+            rewind(pair.build);
+            while (readSpillRow(pair.build, row))
+            {
+                size_t key_hash = hash<string>{}(row.key);
+                if (!split_files.empty())
+                {
+                    writePartition(split_files, pair.depth + 1, row, key_hash);
+                    continue;
+                }
+                addBuildRow(move(row), key_hash);
+                if (can_split && tableBytes() > memory_budget)
+                {
+                    spillBuildRows(split_files, pair.depth + 1);
+                }
+            }
+            fclose(pair.build);
+
+            if (!split_files.empty())
+            {
+                partitionProbe(pair.probe, split_files, pair.depth + 1);
+                fclose(pair.probe);
+                continue;
+            }
+            probe_file = pair.probe;
+            rewind(probe_file);
+            return true;
+        }
+
+        clearTable();
+        return false;
+    }
+
+    bool HashJoinOperator::nextProbeRow()
+    {
+        if (probe_file)
+        {
+            if (!readSpillRow(probe_file, probe_row))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            if (probe_input_done)
+            {
+                return false;
+            }
+            if (!pullRow(probeInput(), probe_batch, batch_position, probe_row.tuple))
+            {
+                probeInput().close();
+                probe_input_done = true;
+                return false;
+            }
+            probe_row.key = encodeKey(probe_row.tuple.values[probeKey()]);
+        }
+        probe_hash = hash<string>{}(probe_row.key);
+        return true;
+    }
+
+    // Read the build side into the hash table - or, once it outgrows the budget, into
+    // partition files, and then the probe side too
+    void HashJoinOperator::open()
+    {
+        close();
+        spilled_partitions = 0;
+
+        Operator &build = buildInput();
+        build.open();
+        RowBatch batch;
+        size_t position = 0;
+        SpillRow row;
+        vector<FILE *> build_files;
+        while (pullRow(build, batch, position, row.tuple))
+        {
+            row.key = encodeKey(row.tuple.values[buildKey()]);
+            size_t key_hash = hash<string>{}(row.key);
+            if (!build_files.empty())
+            {
+                writePartition(build_files, 0, row, key_hash);
+                continue;
+            }
+            addBuildRow(move(row), key_hash);
+            if (tableBytes() > memory_budget)
+            {
+                spillBuildRows(build_files, 0);
+            }
+        }
+        build.close();
+
+        probeInput().open();
+        if (!build_files.empty())
+        {
+            partitionProbe(nullptr, build_files, 0);
+        }
+    }
+
+    // Return the current probe row joined with its next matching build row; when it
+    // has none left, move on to the next probe row, then to the next partition
+    bool HashJoinOperator::next(Tuple &tuple)
+    {
+        while (true)
+        {
+            while (match != 0)
+            {
+                const BuildRow &candidate = build_rows[match - 1];
+                match = candidate.next;
+                if (candidate.hash != probe_hash || candidate.row.key != probe_row.key)
+                {
+                    continue;
+                }
+
+                const Tuple &first = build_left ? candidate.row.tuple : probe_row.tuple;
+                const Tuple &second = build_left ? probe_row.tuple : candidate.row.tuple;
+                tuple = Tuple();
+                tuple.id = probe_row.tuple.id;
+                tuple.values.reserve(first.values.size() + second.values.size());
+                tuple.values.insert(tuple.values.end(), first.values.begin(), first.values.end());
+                tuple.values.insert(tuple.values.end(), second.values.begin(), second.values.end());
+                return true;
+            }
+
+            if (!nextProbeRow())
+            {
+                if (!loadPartition())
+                {
+                    return false;
+                }
+                continue;
+            }
+            match = buckets.empty() ? 0 : buckets[probe_hash & (buckets.size() - 1)];
+        }
+    }
+
+    void HashJoinOperator::close()
+    {
+        clearTable();
+        if (probe_file)
+        {
+            fclose(probe_file);
+            probe_file = nullptr;
+        }
+        for (auto &pair : pending)
+        {
+            fclose(pair.build);
+            fclose(pair.probe);
+        }
+        pending.clear();
+        left->close();
+        right->close();
+        probe_batch.selection.clear();
+        batch_position = 0;
+        probe_input_done = false;
+    }
+
+} // namespace db
@@ -0,0 +1,591 @@
+#include "planner.h"
+#include "query_parser.h"
+#include "storage_engine.h"
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+
+using namespace std;
+
+namespace db
+{
+
+    // Rough size of a row kept by a Top-N heap, for deciding whether the heap fits the work memory
+    static constexpr size_t TOP_N_ROW_BYTES = 256;
+
+    // Finds the position of a column named in a query in the rows the query reads
+    // (-1 if there is no such column); throws runtime_error for an ambiguous name
+    using ColumnLookup = function<int(const string &)>;
+
+    // Turn a parsed aggregate call into an AggregateSpec over the input's columns
+    // Throws runtime_error for an unknown column or a SUM / AVG of a non-numeric column
+    static AggregateSpec resolveAggregate(const AggregateItem &item, const Schema &schema,
+                                          const ColumnLookup &find_column)
+    {
+        AggregateSpec spec;
+        spec.name = item.name;
+        spec.column = -1; // COUNT(*)
+        if (item.column != "*")
+        {
+            spec.column = find_column(item.column);
+            if (spec.column < 0)
+            {
+                throw runtime_error("Unknown column: " + item.column);
+            }
+        }
+
+        if (item.function == "COUNT")
+            spec.func = AggregateFunc::COUNT;
+        else if (item.function == "SUM")
+            spec.func = AggregateFunc::SUM;
+        else if (item.function == "AVG")
+            spec.func = AggregateFunc::AVG;
+        else if (item.function == "MIN")
+            spec.func = AggregateFunc::MIN;
+        else
+            spec.func = AggregateFunc::MAX;
+
+        if (spec.func == AggregateFunc::SUM || spec.func == AggregateFunc::AVG)
+        {
+            DataType type = schema.columns[spec.column].type;
+            if (type != DataType::INTEGER && type != DataType::DOUBLE)
+            {
+                throw runtime_error(item.function + " needs a numeric column: " + item.column);
+            }
+        }
+        return spec;
+    }
+
+    // Copy of a WHERE expression with every column named exactly as in the schema, so
+    // it compiles against it (e.g. "amount" becomes "orders.amount" in a join)
+    static ExprPtr resolveExprColumns(const Expr &expr, const Schema &schema, const ColumnLookup &find_column)
+    {
+        auto copy = make_shared<Expr>(expr);
+        if (expr.type == ExprType::AND || expr.type == ExprType::OR || expr.type == ExprType::NOT)
+        {
+            for (auto &child : copy->children)
+            {
+                child = resolveExprColumns(*child, schema, find_column);
+            }
+            return copy;
+        }
+
+        int col_idx = find_column(expr.column);
+        if (col_idx < 0)
+        {
+            throw runtime_error("Unknown column: " + expr.column);
+        }
+        copy->column = schema.columns[col_idx].name;
+        return copy;
+    }
+
+    // The parts of an expression ANDed at its top (the expression itself if it isn't an AND)
+    static void splitConjuncts(const ExprPtr &expr, vector<ExprPtr> &conjuncts)
+    {
+        if (expr->type != ExprType::AND)
+        {
+            conjuncts.push_back(expr);
+            return;
+        }
+        for (const auto &child : expr->children)
+        {
+            splitConjuncts(child, conjuncts);
+        }
+    }
+
+    // Columns a SELECT uses, as positions in the rows it reads
+    struct ResolvedSelect
+    {
+        bool aggregated = false;          // GROUP BY or aggregates?
+        vector<int> group_ids;            // GROUP BY columns
+        vector<AggregateSpec> aggregates; // Aggregates to compute
+        vector<int> output_ids;           // Select list, in the rows being projected (empty = SELECT *)
+        vector<SortKey> sort_keys;        // ORDER BY, in the rows being sorted
+        vector<int> needed_ids;           // Input columns read, sorted (set by decodeMask)
+    };
+
+    // Resolve the select list, GROUP BY, aggregates and ORDER BY. With aggregation the
+    // aggregate's output rows hold the GROUP BY columns, then one value per aggregate,
+    // and the select list and ORDER BY refer to those.
+    static ResolvedSelect resolveSelect(const SelectNode &node, const Schema &schema, const ColumnLookup &find_column)
+    {
+        ResolvedSelect select;
+        select.aggregated = !node.aggregates.empty() || !node.group_by.empty();
+        if (select.aggregated)
+        {
+            if (node.columns.empty())
+            {
+                throw runtime_error("SELECT * cannot be combined with GROUP BY or aggregates");
+            }
+            for (const auto &column : node.group_by)
+            {
+                int col_idx = find_column(column);
+                if (col_idx < 0)
+                {
+                    throw runtime_error("Unknown column: " + column);
+                }
+                select.group_ids.push_back(col_idx);
+            }
+            for (const auto &item : node.aggregates)
+            {
+                select.aggregates.push_back(resolveAggregate(item, schema, find_column));
+            }
+        }
+
+        // Position of a select list or ORDER BY name in the rows being projected or
+        // sorted: the input rows, or the aggregate's output rows
+        auto resolveOutput = [&](const string &name)
+        {
+            if (select.aggregated)
+            {
+                for (size_t i = 0; i < select.aggregates.size(); i++)
+                {
+                    if (select.aggregates[i].name == name)
+                    {
+                        return static_cast<int>(select.group_ids.size() + i);
+                    }
+                }
+            }
+            int col_idx = find_column(name);
+            if (col_idx < 0)
+            {
+                throw runtime_error("Unknown column: " + name);
+            }
+            if (!select.aggregated)
+            {
+                return col_idx;
+            }
+            auto group = find(select.group_ids.begin(), select.group_ids.end(), col_idx);
+            if (group == select.group_ids.end())
+            {
+                throw runtime_error("Column " + name + " must appear in GROUP BY or be used in an aggregate");
+            }
+            return static_cast<int>(group - select.group_ids.begin());
+        };
+
+        // Resolve the select list (empty = SELECT *, no projection needed)
+        for (const auto &column : node.columns)
+        {
+            select.output_ids.push_back(resolveOutput(column));
+        }
+
+        // Resolve ORDER BY (the sort runs before the projection, so it may use columns
+        // that aren't selected)
+        for (const auto &item : node.order_by)
+        {
+            select.sort_keys.push_back({resolveOutput(item.column), item.descending});
+        }
+        return select;
+    }
+
+    // Columns the plan reads - with a select list (or aggregation), scans skip every
+    // other column. Sets select.needed_ids (adding the other_ids, e.g. the WHERE
+    // clause's) and returns the decode mask (empty = read every column).
+    static vector<bool> decodeMask(ResolvedSelect &select, const vector<int> &other_ids, size_t column_count)
+    {
+        if (!select.aggregated && select.output_ids.empty())
+        {
+            return {};
+        }
+
+        vector<int> &needed_ids = select.needed_ids;
+        if (select.aggregated)
+        {
+            needed_ids = select.group_ids;
+            for (const auto &spec : select.aggregates)
+            {
+                if (spec.column >= 0)
+                {
+                    needed_ids.push_back(spec.column);
+                }
+            }
+        }
+        else
+        {
+            needed_ids = select.output_ids;
+            for (const auto &key : select.sort_keys)
+            {
+                needed_ids.push_back(key.column);
+            }
+        }
+        needed_ids.insert(needed_ids.end(), other_ids.begin(), other_ids.end());
+        sort(needed_ids.begin(), needed_ids.end());
+        needed_ids.erase(unique(needed_ids.begin(), needed_ids.end()), needed_ids.end());
+
+        vector<bool> decode_columns(column_count, false);
+        for (int col_idx : needed_ids)
+        {
+            decode_columns[col_idx] = true;
+        }
+        return decode_columns;
+    }
+
+    // Build scan -> filter -> [aggregate] -> sort -> limit -> project for a single-table SELECT
+    OperatorPtr QueryPlanner::planSelect(const SelectNode &node)
+    {
+        if (!node.joins.empty())
+        {
+            return planJoin(node);
+        }
+
+        Table *table = storage_engine ? storage_engine->getTable(node.table_name) : nullptr;
+        if (!table)
+        {
+            throw runtime_error("Table not found: " + node.table_name);
+        }
+        const Schema &schema = table->getSchema();
+
+        // Column names may be qualified with the table's name
+        const string qualifier = node.table_name + ".";
+        ColumnLookup find_column = [&](const string &name)
+        {
+            bool qualified = name.compare(0, qualifier.size(), qualifier) == 0;
+            return schema.findColumn(qualified ? name.substr(qualifier.size()) : name);
+        };
+
+        // Compile the WHERE clause once; the comparisons ANDed at its top pick the index
+        vector<Condition> conditions;
+        CompiledPredicate predicate;
+        ExprPtr where;
+        if (node.has_where)
+        {
+            where = resolveExprColumns(*node.where, schema, find_column);
+            predicate = CompiledPredicate::compile(*where, schema);
+            extractConditions(*where, conditions);
+        }
+
+        ResolvedSelect select = resolveSelect(node, schema, find_column);
+        vector<bool> decode_columns = decodeMask(select, predicate.columnIds(), schema.columns.size());
+        const vector<int> &needed_ids = select.needed_ids;
+        vector<SortKey> &sort_keys = select.sort_keys;
+
+        // COUNT / MIN / MAX of a whole table - answered from the row count and the ends of
+        // ordered indexes when every aggregate can be, without reading a row
+        if (select.aggregated && select.group_ids.empty() && !node.has_where)
+        {
+            vector<string> bound_indexes;
+            for (const auto &spec : select.aggregates)
+            {
+                string index_name;
+                if (spec.func == AggregateFunc::MIN || spec.func == AggregateFunc::MAX)
+                {
+                    index_name = table->findBoundIndex(spec.column);
+                    if (index_name.empty())
+                    {
+                        break;
+                    }
+                }
+                else if (spec.func != AggregateFunc::COUNT)
+                {
+                    break;
+                }
+                bound_indexes.push_back(index_name);
+            }
+            if (bound_indexes.size() == select.aggregates.size())
+            {
+                return planOutput(make_unique<MetadataAggregateOperator>(table, move(select.aggregates),
+                                                                         move(bound_indexes)),
+                                  node, move(sort_keys), select.output_ids);
+            }
+        }
+
+        // ORDER BY ... LIMIT over the leading columns of an ordered index (all ASC) can read
+        // that index in key order and stop early - used when no index narrows the WHERE
+        // clause, since the alternative would then be a full scan and a sort
+        bool has_index = where && table->hasIndexFor(conditions, where.get());
+        string order_index;
+        if (!select.aggregated && !sort_keys.empty() && node.has_limit && !has_index &&
+            all_of(sort_keys.begin(), sort_keys.end(), [](const SortKey &key)
+                   { return !key.descending; }))
+        {
+            vector<int> sort_columns;
+            for (const auto &key : sort_keys)
+            {
+                sort_columns.push_back(key.column);
+            }
+            order_index = table->findOrderedIndex(sort_columns, conditions);
+        }
+
+        // Access path: index order for the sort above, else index-only if one index stores
+        // every needed column, else an index scan when the conditions can use one, else
+        // read every page - an aggregation over every page is split across worker
+        // threads, scan, filter and all
+        OperatorPtr plan;
+        bool parallel_aggregate = false;
+        if (!order_index.empty())
+        {
+            plan = make_unique<IndexOrderScanOperator>(table, order_index, decode_columns);
+        }
+        else if (!needed_ids.empty() && table->hasCoveringIndexFor(conditions, needed_ids))
+        {
+            vector<string> covered_columns;
+            for (int col_idx : needed_ids)
+            {
+                covered_columns.push_back(schema.columns[col_idx].name);
+            }
+            plan = make_unique<IndexScanOperator>(table, conditions, decode_columns, covered_columns);
+        }
+        else if (has_index)
+        {
+            plan = make_unique<IndexScanOperator>(table, conditions, decode_columns, vector<string>{}, where);
+        }
+        else if (select.aggregated && vectorized && parallel_workers > 1)
+        {
+            optional<CompiledPredicate> where;
+            if (node.has_where)
+            {
+                where = move(predicate);
+            }
+            plan = make_unique<ParallelAggregateOperator>(table, decode_columns, move(where), move(select.group_ids),
+                                                          move(select.aggregates), work_memory, parallel_workers);
+            parallel_aggregate = true;
+        }
+        else
+        {
+            plan = make_unique<SeqScanOperator>(table, decode_columns);
+        }
+
+        // Index candidates may include rows the WHERE clause rejects, so always filter
+        if (node.has_where && !parallel_aggregate)
+        {
+            plan = make_unique<FilterOperator>(move(plan), move(predicate));
+        }
+
+        // GROUP BY / aggregates - hash aggregation, spilling partitions past the work memory
+        if (select.aggregated && !parallel_aggregate)
+        {
+            plan = make_unique<AggregateOperator>(move(plan), move(select.group_ids), move(select.aggregates),
+                                                  work_memory, vectorized);
+        }
+
+        // ORDER BY - nothing to do when the index already returns rows in order
+        if (!order_index.empty())
+        {
+            sort_keys.clear();
+        }
+        return planOutput(move(plan), node, move(sort_keys), select.output_ids);
+    }
+
+    // Tables are joined left-deep in the order written: each JOIN's table is hash joined
+    // to the rows of the tables before it. The joined rows hold every table's columns,
+    // named table.column; an unqualified name must belong to exactly one table.
+    OperatorPtr QueryPlanner::planJoin(const SelectNode &node)
+    {
+        vector<string> table_names = {node.table_name};
+        for (const auto &join : node.joins)
+        {
+            table_names.push_back(join.table_name);
+        }
+
+        vector<Table *> tables;
+        vector<size_t> offsets; // Position of each table's first column in the joined rows
+        Schema schema;
+        for (const auto &name : table_names)
+        {
+            Table *table = storage_engine ? storage_engine->getTable(name) : nullptr;
+            if (!table)
+            {
+                throw runtime_error("Table not found: " + name);
+            }
+            if (find(tables.begin(), tables.end(), table) != tables.end())
+            {
+                throw runtime_error("Table " + name + " is joined more than once - self joins are not supported");
+            }
+            tables.push_back(table);
+            offsets.push_back(schema.columns.size());
+            for (const auto &column : table->getSchema().columns)
+            {
+                schema.columns.push_back(Column(name + "." + column.name, column.type, column.size));
+            }
+        }
+
+        ColumnLookup find_column = [&](const string &name)
+        {
+            if (name.find('.') != string::npos)
+            {
+                return schema.findColumn(name);
+            }
+            int found = -1;
+            for (size_t t = 0; t < tables.size(); t++)
+            {
+                int col_idx = tables[t]->getSchema().findColumn(name);
+                if (col_idx < 0)
+                {
+                    continue;
+                }
+                if (found >= 0)
+                {
+                    throw runtime_error("Column " + name + " is ambiguous - write it as table." + name);
+                }
+                found = static_cast<int>(offsets[t]) + col_idx;
+            }
+            return found;
+        };
+        auto tableOf = [&](int col_idx)
+        {
+            size_t t = tables.size() - 1;
+            while (offsets[t] > static_cast<size_t>(col_idx))
+            {
+                t--;
+            }
+            return t;
+        };
+
+        // Join keys - each ON compares a column of the new table with one of an earlier table
+        vector<pair<int, int>> join_keys; // Position in the rows joined so far, position in the new table
+        vector<int> key_ids;
+        for (size_t j = 0; j < node.joins.size(); j++)
+        {
+            const JoinItem &join = node.joins[j];
+            int a = find_column(join.left_column);
+            int b = find_column(join.right_column);
+            if (a < 0 || b < 0)
+            {
+                throw runtime_error("Unknown column: " + (a < 0 ? join.left_column : join.right_column));
+            }
+            if (tableOf(a) == j + 1)
+            {
+                swap(a, b);
+            }
+            if (tableOf(b) != j + 1 || tableOf(a) > j)
+            {
+                throw runtime_error("JOIN " + join.table_name + " ON must compare a column of " + join.table_name +
+                                    " with a column of a table before it");
+            }
+            if (schema.columns[a].type != schema.columns[b].type)
+            {
+                throw runtime_error("JOIN columns must have the same type: " + schema.columns[a].name + " and " +
+                                    schema.columns[b].name);
+            }
+            join_keys.push_back({a, b - static_cast<int>(offsets[j + 1])});
+            key_ids.push_back(a);
+            key_ids.push_back(b);
+        }
+
+        // WHERE - the parts ANDed at its top that read a single table filter that table
+        // before the join; the rest filters the joined rows
+        vector<vector<ExprPtr>> pushed(tables.size());
+        vector<ExprPtr> residual;
+        if (node.has_where)
+        {
+            ExprPtr where = resolveExprColumns(*node.where, schema, find_column);
+            vector<ExprPtr> conjuncts;
+            splitConjuncts(where, conjuncts);
+            for (const auto &conjunct : conjuncts)
+            {
+                vector<int> column_ids = CompiledPredicate::compile(*conjunct, schema).columnIds();
+                key_ids.insert(key_ids.end(), column_ids.begin(), column_ids.end());
+                size_t t = column_ids.empty() ? 0 : tableOf(column_ids[0]);
+                bool single_table = all_of(column_ids.begin(), column_ids.end(), [&](int col_idx)
+                                           { return tableOf(col_idx) == t; });
+                (single_table ? pushed[t] : residual).push_back(conjunct);
+            }
+        }
+
+        ResolvedSelect select = resolveSelect(node, schema, find_column);
+        vector<bool> decode_columns = decodeMask(select, key_ids, schema.columns.size());
+
+        // One scan per table (through an index when its own conditions can use one),
+        // decoding only the columns the rest of the plan reads
+        vector<OperatorPtr> inputs;
+        for (size_t t = 0; t < tables.size(); t++)
+        {
+            Table *table = tables[t];
+            const Schema &table_schema = table->getSchema();
+            vector<bool> table_columns;
+            if (!decode_columns.empty())
+            {
+                table_columns.assign(decode_columns.begin() + offsets[t],
+                                     decode_columns.begin() + offsets[t] + table_schema.columns.size());
+            }
+
+            if (pushed[t].empty())
+            {
+                inputs.push_back(make_unique<SeqScanOperator>(table, table_columns));
+                continue;
+            }
+
+            // The table's own conditions, with its column names unqualified
+            ExprPtr filter = pushed[t].size() == 1 ? pushed[t][0] : Expr::combine(ExprType::AND, pushed[t]);
+            filter = resolveExprColumns(*filter, table_schema, [&](const string &name)
+                                        { return table_schema.findColumn(name.substr(name.find('.') + 1)); });
+            vector<Condition> conditions;
+            extractConditions(*filter, conditions);
+            OperatorPtr input;
+            if (table->hasIndexFor(conditions, filter.get()))
+            {
+                input = make_unique<IndexScanOperator>(table, conditions, table_columns, vector<string>{}, filter);
+            }
+            else
+            {
+                input = make_unique<SeqScanOperator>(table, table_columns);
+            }
+            inputs.push_back(make_unique<FilterOperator>(move(input), CompiledPredicate::compile(*filter, table_schema)));
+        }
+
+        // Hash join each table to the rows before it. The first join builds its hash table
+        // from the smaller table (row counts are kept up to date, so this is free); later
+        // ones build from the new table, as the rows joined so far have no known size.
+        OperatorPtr plan = move(inputs[0]);
+        for (size_t j = 0; j < join_keys.size(); j++)
+        {
+            size_t column_count = offsets[j + 1] + tables[j + 1]->getSchema().columns.size();
+            Schema joined;
+            joined.columns.assign(schema.columns.begin(), schema.columns.begin() + column_count);
+            bool build_left = j == 0 && tables[0]->getTupleCount() < tables[1]->getTupleCount();
+            plan = make_unique<HashJoinOperator>(move(plan), move(inputs[j + 1]), join_keys[j].first,
+                                                 join_keys[j].second, move(joined), build_left, work_memory,
+                                                 vectorized);
+        }
+
+        if (!residual.empty())
+        {
+            ExprPtr filter = residual.size() == 1 ? residual[0] : Expr::combine(ExprType::AND, residual);
+            plan = make_unique<FilterOperator>(move(plan), CompiledPredicate::compile(*filter, schema));
+        }
+
+        if (select.aggregated)
+        {
+            plan = make_unique<AggregateOperator>(move(plan), move(select.group_ids), move(select.aggregates),
+                                                  work_memory, vectorized);
+        }
+        return planOutput(move(plan), node, move(select.sort_keys), select.output_ids);
+    }
+
+    // Sort -> limit -> project on top of the rows a SELECT produces
+    OperatorPtr QueryPlanner::planOutput(OperatorPtr plan, const SelectNode &node, vector<SortKey> sort_keys,
+                                         const vector<int> &output_ids)
+    {
+        // ORDER BY - with a LIMIT only the first limit + offset rows are needed, so a
+        // Top-N heap replaces the sort while they fit the work memory (assuming
+        // TOP_N_ROW_BYTES a row); otherwise sort in memory up to the budget, then spill
+        // runs to disk. LIMIT 0 needs no order at all - the limit never opens its input
+        if (!sort_keys.empty() && !(node.has_limit && node.limit == 0))
+        {
+            size_t top_rows = node.limit + node.offset;
+            if (node.has_limit && top_rows >= node.limit && top_rows <= work_memory / TOP_N_ROW_BYTES)
+            {
+                plan = make_unique<TopNOperator>(move(plan), move(sort_keys), top_rows, vectorized);
+            }
+            else
+            {
+                plan = make_unique<SortOperator>(move(plan), move(sort_keys), work_memory, vectorized);
+            }
+        }
+
+        // LIMIT / OFFSET - rows are pulled on demand, so the scan below stops early
+        if (node.has_limit || node.offset > 0)
+        {
+            size_t limit = node.has_limit ? node.limit : SIZE_MAX;
+            plan = make_unique<LimitOperator>(move(plan), limit, node.offset);
+        }
+
+        if (!output_ids.empty())
+        {
+            plan = make_unique<ProjectOperator>(move(plan), output_ids);
+        }
+        return plan;
+    }
+
+} // namespace db
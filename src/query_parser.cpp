@@ -1,8 +1,10 @@
 #include "query_parser.h"
 #include "storage_engine.h"
+#include "planner.h"
 #include <iostream>
 #include <algorithm>
 #include <cctype>
+#include <thread>
 
 using namespace std;
 
@@ -35,6 +37,19 @@ namespace db
         return identifier;
     }
 
+    // Read a column name, keeping a table qualifier (orders.id) when there is one
+    string QueryParser::readColumnName()
+    {
+        string name = readIdentifier();
+        if (!name.empty() && position + 1 < query.length() && query[position] == '.' &&
+            (isalnum(query[position + 1]) || query[position + 1] == '_'))
+        {
+            position++; // Skip the dot
+            name += "." + readIdentifier();
+        }
+        return name;
+    }
+
     // Read a string literal enclosed in single quotes
     // Used for VARCHAR values in SQL statements
     string QueryParser::readString()
@@ -116,6 +131,63 @@ namespace db
         throw runtime_error("Invalid value format");
     }
 
+    // Read a column name, or FUNC(column) / COUNT(*) for an aggregate
+    string QueryParser::parseSelectItem(SelectNode &node)
+    {
+        string identifier = readColumnName();
+        if (identifier.empty())
+        {
+            throw runtime_error("Expected a column name");
+        }
+        if (!match("("))
+        {
+            return identifier; // Plain column
+        }
+
+        AggregateItem item;
+        item.function = identifier;
+        transform(item.function.begin(), item.function.end(), item.function.begin(), ::toupper);
+        if (item.function != "COUNT" && item.function != "SUM" && item.function != "AVG" &&
+            item.function != "MIN" && item.function != "MAX")
+        {
+            throw runtime_error("Unknown function: " + identifier);
+        }
+
+        if (match("*"))
+        {
+            if (item.function != "COUNT")
+            {
+                throw runtime_error(item.function + "(*) is not supported - only COUNT(*)");
+            }
+            item.column = "*";
+        }
+        else
+        {
+            item.column = readColumnName();
+        }
+        expect(")");
+
+        item.name = item.function + "(" + item.column + ")";
+        bool seen = any_of(node.aggregates.begin(), node.aggregates.end(), [&](const AggregateItem &other)
+                           { return other.name == item.name; });
+        if (!seen)
+        {
+            node.aggregates.push_back(item);
+        }
+        return item.name;
+    }
+
+    // Read a LIMIT / OFFSET row count
+    size_t QueryParser::parseRowCount(const string &clause)
+    {
+        Value value = parseValue();
+        if (!holds_alternative<int32_t>(value) || get<int32_t>(value) < 0)
+        {
+            throw runtime_error(clause + " expects a non-negative integer");
+        }
+        return static_cast<size_t>(get<int32_t>(value));
+    }
+
     // Parse data type specification in CREATE TABLE statements
     // Converts SQL type names to internal DataType enum values
     DataType QueryParser::parseDataType()
@@ -193,6 +265,186 @@ namespace db
         return false; // No match found
     }
 
+    // Match a keyword only when no identifier character follows it
+    bool QueryParser::matchKeyword(const string &keyword)
+    {
+        size_t saved = position;
+        if (!match(keyword))
+        {
+            return false;
+        }
+        if (position < query.length() && (isalnum(query[position]) || query[position] == '_'))
+        {
+            position = saved; // Only the start of a longer word (e.g. ORDER, INDEX)
+            return false;
+        }
+        return true;
+    }
+
+    // Accept an optional trailing ';' and reject anything left after the statement
+    void QueryParser::expectEnd(const string &statement)
+    {
+        match(";");
+        skipWhitespace();
+        if (position < query.length())
+        {
+            throw runtime_error("Unexpected text after " + statement + ": " + query.substr(position));
+        }
+    }
+
+    // Parse a WHERE clause made of comparisons joined by AND
+    // Supported operators: =, <, <=, >, >=
+    vector<Condition> QueryParser::parseConditions()
+    {
+        vector<Condition> conditions;
+        while (true)
+        {
+            Condition condition;
+            condition.column = readIdentifier();
+
+            // Two-character operators must be tried before their one-character prefixes
+            if (match("<="))
+                condition.op = CompareOp::LE;
+            else if (match(">="))
+                condition.op = CompareOp::GE;
+            else if (match("<"))
+                condition.op = CompareOp::LT;
+            else if (match(">"))
+                condition.op = CompareOp::GT;
+            else
+            {
+                expect("=");
+                condition.op = CompareOp::EQ;
+            }
+
+            condition.value = parseValue();
+            conditions.push_back(move(condition));
+
+            if (!match("AND"))
+                break; // No more conditions
+        }
+        return conditions;
+    }
+
+    // Parse OR-separated terms - a single term is returned as it is
+    ExprPtr QueryParser::parseExpression()
+    {
+        vector<ExprPtr> terms;
+        terms.push_back(parseAndExpression());
+        while (matchKeyword("OR"))
+        {
+            terms.push_back(parseAndExpression());
+        }
+        return terms.size() == 1 ? terms[0] : Expr::combine(ExprType::OR, move(terms));
+    }
+
+    // Parse AND-separated factors
+    ExprPtr QueryParser::parseAndExpression()
+    {
+        vector<ExprPtr> factors;
+        factors.push_back(parseNotExpression());
+        while (matchKeyword("AND"))
+        {
+            factors.push_back(parseNotExpression());
+        }
+        return factors.size() == 1 ? factors[0] : Expr::combine(ExprType::AND, move(factors));
+    }
+
+    // Parse NOT prefixes and parenthesized sub-expressions
+    ExprPtr QueryParser::parseNotExpression()
+    {
+        if (matchKeyword("NOT"))
+        {
+            return Expr::combine(ExprType::NOT, {parseNotExpression()});
+        }
+        if (match("("))
+        {
+            ExprPtr expr = parseExpression();
+            expect(")");
+            return expr;
+        }
+        return parsePredicate();
+    }
+
+    // Parse one test on a column
+    ExprPtr QueryParser::parsePredicate()
+    {
+        string column = readColumnName();
+        if (column.empty())
+        {
+            throw runtime_error("Expected column name in WHERE clause");
+        }
+
+        // IS [NOT] NULL
+        if (matchKeyword("IS"))
+        {
+            bool negated = matchKeyword("NOT");
+            expect("NULL");
+            auto expr = make_shared<Expr>();
+            expr->type = ExprType::IS_NULL;
+            expr->column = column;
+            return negated ? Expr::combine(ExprType::NOT, {expr}) : expr;
+        }
+
+        // [NOT] BETWEEN low AND high, [NOT] IN (values)
+        bool negated = matchKeyword("NOT");
+        if (matchKeyword("BETWEEN"))
+        {
+            auto expr = make_shared<Expr>();
+            expr->type = ExprType::BETWEEN;
+            expr->column = column;
+            expr->values.push_back(parseValue());
+            if (!matchKeyword("AND"))
+            {
+                throw runtime_error("Expected 'AND' in BETWEEN");
+            }
+            expr->values.push_back(parseValue());
+            return negated ? Expr::combine(ExprType::NOT, {expr}) : expr;
+        }
+        if (matchKeyword("IN"))
+        {
+            auto expr = make_shared<Expr>();
+            expr->type = ExprType::IN;
+            expr->column = column;
+            expect("(");
+            while (true)
+            {
+                expr->values.push_back(parseValue());
+                if (!match(","))
+                    break; // No more values
+            }
+            expect(")");
+            return negated ? Expr::combine(ExprType::NOT, {expr}) : expr;
+        }
+        if (negated)
+        {
+            throw runtime_error("Expected BETWEEN or IN after NOT");
+        }
+
+        // Comparison - two-character operators must be tried before their prefixes;
+        // <> and != are stored as NOT(=) so indexes only ever see the five CompareOps
+        if (match("<>") || match("!="))
+        {
+            return Expr::combine(ExprType::NOT, {Expr::compare(column, CompareOp::EQ, parseValue())});
+        }
+
+        CompareOp op;
+        if (match("<="))
+            op = CompareOp::LE;
+        else if (match(">="))
+            op = CompareOp::GE;
+        else if (match("<"))
+            op = CompareOp::LT;
+        else if (match(">"))
+            op = CompareOp::GT;
+        else
+        {
+            expect("=");
+            op = CompareOp::EQ;
+        }
+        return Expr::compare(column, op, parseValue());
+    }
+
     // Parse SELECT statement and build AST node
     // Handles column selection, table specification, and WHERE clauses
     unique_ptr<SelectNode> QueryParser::parseSelect()
@@ -210,7 +462,7 @@ namespace db
         {
             while (true)
             {
-                node->columns.push_back(readIdentifier());
+                node->columns.push_back(parseSelectItem(*node));
                 if (!match(","))
                     break;
             }
@@ -219,15 +471,96 @@ namespace db
         expect("FROM");
         node->table_name = readIdentifier();
 
+        // Parse [INNER] JOIN table ON column = column, ...
+        while (true)
+        {
+            bool inner = matchKeyword("INNER");
+            if (!matchKeyword("JOIN"))
+            {
+                if (inner)
+                {
+                    throw runtime_error("Expected JOIN after INNER");
+                }
+                break;
+            }
+            JoinItem join;
+            join.table_name = readIdentifier();
+            if (join.table_name.empty())
+            {
+                throw runtime_error("JOIN expects a table name");
+            }
+            if (!matchKeyword("ON"))
+            {
+                throw runtime_error("Expected ON after JOIN " + join.table_name);
+            }
+            join.left_column = readColumnName();
+            expect("=");
+            join.right_column = readColumnName();
+            if (join.left_column.empty() || join.right_column.empty())
+            {
+                throw runtime_error("JOIN ... ON expects column = column");
+            }
+            node->joins.push_back(join);
+        }
+
         // Parse WHERE clause
-        if (match("WHERE"))
+        if (matchKeyword("WHERE"))
         {
             node->has_where = true;
-            node->where_column = readIdentifier();
-            expect("=");
-            node->where_value = parseValue();
+            node->where = parseExpression();
+        }
+
+        // Parse GROUP BY column, ...
+        if (matchKeyword("GROUP"))
+        {
+            expect("BY");
+            while (true)
+            {
+                string column = readColumnName();
+                if (column.empty())
+                {
+                    throw runtime_error("GROUP BY expects a column name");
+                }
+                node->group_by.push_back(column);
+                if (!match(","))
+                    break;
+            }
+        }
+
+        // Parse ORDER BY column | aggregate [ASC|DESC], ...
+        if (matchKeyword("ORDER"))
+        {
+            expect("BY");
+            while (true)
+            {
+                OrderByItem item;
+                item.column = parseSelectItem(*node);
+                item.descending = matchKeyword("DESC");
+                if (!item.descending)
+                {
+                    matchKeyword("ASC"); // The default direction
+                }
+                node->order_by.push_back(item);
+                if (!match(","))
+                    break;
+            }
         }
 
+        // Parse LIMIT / OFFSET - the scan stops once enough rows are produced
+        if (matchKeyword("LIMIT"))
+        {
+            node->has_limit = true;
+            node->limit = parseRowCount("LIMIT");
+        }
+        if (matchKeyword("OFFSET"))
+        {
+            node->offset = parseRowCount("OFFSET");
+        }
+
+        // Every clause is optional, so a misspelled one (e.g. "LIMT 1") would otherwise
+        // be ignored and the query would silently return the wrong rows
+        expectEnd("SELECT");
+
         return node;
     }
 
@@ -278,14 +611,15 @@ namespace db
         }
 
         // Parse optional WHERE clause
-        if (match("WHERE"))
+        if (matchKeyword("WHERE"))
         {
             node->has_where = true;
-            node->where_column = readIdentifier();
-            expect("=");
-            node->where_value = parseValue();
+            node->where = parseExpression();
         }
 
+        // A misspelled WHERE (e.g. "WHER a = 1") must not turn into "every row"
+        expectEnd("UPDATE");
+
         return node;
     }
 
@@ -299,14 +633,14 @@ namespace db
         node->table_name = readIdentifier(); // Get target table name
 
         // Parse optional WHERE clause
-        if (match("WHERE"))
+        if (matchKeyword("WHERE"))
         {
             node->has_where = true;
-            node->where_column = readIdentifier();
-            expect("=");
-            node->where_value = parseValue();
+            node->where = parseExpression();
         }
 
+        expectEnd("DELETE");
+
         return node;
     }
 
@@ -364,6 +698,88 @@ namespace db
         return node;
     }
 
+    // Parse CREATE INDEX statement and build AST node
+    // Handles CREATE INDEX table.column [USING BTREE|HASH|ART|BITMAP|LEARNED] syntax, the
+    // composite form CREATE INDEX table (col1, col2, ...) [USING ...], an optional
+    // INCLUDE (col, ...) list of extra columns stored in the index and an optional
+    // trailing WHERE clause that makes the index partial
+    unique_ptr<CreateIndexNode> QueryParser::parseCreateIndex()
+    {
+        auto node = make_unique<CreateIndexNode>();
+
+        node->table_name = readIdentifier(); // Get table to index
+        if (match("("))
+        {
+            // Parse column list - key order follows the list order
+            while (true)
+            {
+                node->column_names.push_back(readIdentifier());
+                if (!match(","))
+                    break; // No more columns
+            }
+            expect(")");
+        }
+        else
+        {
+            expect(".");
+            node->column_names.push_back(readIdentifier()); // Get column to index
+        }
+
+        // Parse optional covering columns
+        if (match("INCLUDE"))
+        {
+            expect("(");
+            while (true)
+            {
+                node->include_columns.push_back(readIdentifier());
+                if (!match(","))
+                    break; // No more columns
+            }
+            expect(")");
+        }
+
+        // Parse optional index type
+        if (match("USING"))
+        {
+            string type = readIdentifier();
+            transform(type.begin(), type.end(), type.begin(), ::toupper);
+
+            if (type == "HASH")
+            {
+                node->index_type = IndexType::HASH;
+            }
+            else if (type == "ART")
+            {
+                node->index_type = IndexType::ART;
+            }
+            else if (type == "BITMAP")
+            {
+                node->index_type = IndexType::BITMAP;
+            }
+            else if (type == "LEARNED")
+            {
+                node->index_type = IndexType::LEARNED;
+            }
+            else if (type == "BTREE" || type == "B_TREE")
+            {
+                node->index_type = IndexType::B_TREE;
+            }
+            else
+            {
+                throw runtime_error("Unknown index type: " + type);
+            }
+        }
+
+        // Parse optional partial index predicate
+        if (match("WHERE"))
+        {
+            node->has_where = true;
+            node->conditions = parseConditions();
+        }
+
+        return node;
+    }
+
     // Main parsing entry point - determines query type and calls appropriate parser
     // Returns AST node representing the parsed SQL statement
     unique_ptr<QueryNode> QueryParser::parse()
@@ -391,6 +807,10 @@ namespace db
         }
         else if (command == "CREATE")
         {
+            if (match("INDEX"))
+            {
+                return parseCreateIndex();
+            }
             return parseCreateTable();
         }
         else if (command == "DROP")
@@ -420,12 +840,20 @@ namespace db
             return QueryType::CREATE_TABLE;
         if (upper_query.find("DROP TABLE") == 0)
             return QueryType::DROP_TABLE;
+        if (upper_query.find("CREATE INDEX") == 0)
+            return QueryType::CREATE_INDEX;
 
         throw runtime_error("Unknown query type");
     }
 
     // QueryExecutor implementation - executes parsed SQL statements
 
+    QueryExecutor::QueryExecutor(StorageEngine *storage_engine)
+        : storage_engine(storage_engine), vectorized(true), work_memory(DEFAULT_WORK_MEMORY),
+          parallel_workers(max(1u, thread::hardware_concurrency()))
+    {
+    }
+
     // Main execution entry point - parses SQL and executes appropriate operation
     // Returns QueryResult with success status and data/error message
     QueryResult QueryExecutor::execute(const string &query)
@@ -460,6 +888,10 @@ namespace db
             {
                 return executeDropTable(*drop_node);
             }
+            else if (auto index_node = dynamic_cast<CreateIndexNode *>(node.get()))
+            {
+                return executeCreateIndex(*index_node);
+            }
 
             return QueryResult(false, "Unknown query type");
         }
@@ -469,8 +901,21 @@ namespace db
         }
     }
 
+    // Prepare a WHERE expression for a table: the comparisons ANDed at its top go to
+    // conditions (they pick the index), and the expression is compiled into filter.
+    // Returns the filter, or nullptr when the conditions already say everything.
+    // Throws runtime_error if the expression names a column the table doesn't have.
+    static const CompiledPredicate *prepareWhere(const Expr &where, const Schema &schema,
+                                                 vector<Condition> &conditions, CompiledPredicate &filter)
+    {
+        filter = CompiledPredicate::compile(where, schema);
+        bool exact = extractConditions(where, conditions);
+        return exact ? nullptr : &filter;
+    }
+
     // Execute SELECT statement - retrieve data from table
-    // Handles both full table scans and WHERE clause filtering
+    // The planner builds an operator tree (scan, filter, sort, limit, projection); rows are pulled
+    // from its root a batch at a time, or one at a time with vectorized execution off
     QueryResult QueryExecutor::executeSelect(const SelectNode &node)
     {
         if (!storage_engine)
@@ -478,20 +923,38 @@ namespace db
             return QueryResult(false, "Storage engine not available");
         }
 
-        vector<Tuple> tuples;
-        if (node.has_where)
+        QueryResult result(true, "Query executed successfully");
+        try
         {
-            // Filter rows based on WHERE condition
-            tuples = storage_engine->selectWhere(node.table_name, node.where_column, node.where_value);
+            OperatorPtr plan = QueryPlanner(storage_engine, work_memory, vectorized, parallel_workers).planSelect(node);
+            result.schema = plan->getSchema();
+
+            plan->open();
+            if (vectorized)
+            {
+                RowBatch batch;
+                while (plan->nextBatch(batch))
+                {
+                    for (uint32_t row : batch.selection)
+                    {
+                        result.tuples.push_back(batch.takeRow(row));
+                    }
+                }
+            }
+            else
+            {
+                Tuple tuple;
+                while (plan->next(tuple))
+                {
+                    result.tuples.push_back(move(tuple));
+                }
+            }
+            plan->close();
         }
-        else
+        catch (const exception &e)
         {
-            // Return all rows in table
-            tuples = storage_engine->selectAll(node.table_name);
+            return QueryResult(false, e.what()); // Unknown table or column, a failed spill or an overflow
         }
-
-        QueryResult result(true, "Query executed successfully");
-        result.tuples = tuples;
         return result;
     }
 
@@ -516,7 +979,7 @@ namespace db
     }
 
     // Execute UPDATE statement - modify existing rows in table
-    // Updates all rows matching WHERE condition
+    // Updates all rows matching WHERE conditions (indexes are kept in step by the table)
     QueryResult QueryExecutor::executeUpdate(const UpdateNode &node)
     {
         if (!storage_engine)
@@ -524,14 +987,65 @@ namespace db
             return QueryResult(false, "Storage engine not available");
         }
 
-        // For simplicity, basic update implementation
-        // In a real implementation, this would be more sophisticated with
-        // proper WHERE clause evaluation and multi-column updates
-        return QueryResult(true, "Update not yet implemented");
+        auto table = storage_engine->getTable(node.table_name);
+        if (!table)
+        {
+            return QueryResult(false, "Table not found: " + node.table_name);
+        }
+
+        // Resolve SET columns before touching any row
+        vector<pair<int, Value>> assignments;
+        for (const auto &[column, value] : node.set_values)
+        {
+            int col_idx = table->getSchema().findColumn(column);
+            if (col_idx < 0)
+            {
+                return QueryResult(false, "Unknown column: " + column);
+            }
+            assignments.emplace_back(col_idx, value);
+        }
+
+        vector<Condition> conditions;
+        CompiledPredicate filter;
+        const CompiledPredicate *row_filter = nullptr;
+        if (node.has_where)
+        {
+            try
+            {
+                row_filter = prepareWhere(*node.where, table->getSchema(), conditions, filter);
+            }
+            catch (const exception &e)
+            {
+                return QueryResult(false, e.what());
+            }
+        }
+
+        // Find matching rows first, so updated rows aren't visited again
+        auto tuples = node.has_where ? table->selectWhere(conditions, row_filter) : table->selectAll();
+
+        size_t updated = 0;
+        for (auto &tuple : tuples)
+        {
+            for (const auto &[col_idx, value] : assignments)
+            {
+                tuple.values[col_idx] = value;
+            }
+            if (table->updateTuple(tuple.id, tuple.values))
+            {
+                updated++;
+            }
+        }
+
+        if (updated < tuples.size())
+        {
+            return QueryResult(false, "Updated " + to_string(updated) + " of " + to_string(tuples.size()) +
+                                          " rows (new values couldn't be stored)");
+        }
+        return QueryResult(true, "Updated " + to_string(updated) + " rows");
     }
 
     // Execute DELETE statement - remove rows from table
-    // Deletes all rows matching WHERE condition
+    // Deletes all rows matching WHERE conditions (and their index entries)
     QueryResult QueryExecutor::executeDelete(const DeleteNode &node)
     {
         if (!storage_engine)
@@ -539,10 +1053,39 @@ namespace db
             return QueryResult(false, "Storage engine not available");
         }
 
-        // For simplicity, basic delete implementation
-        // In a real implementation, this would evaluate WHERE conditions
-        // and remove matching tuples from storage
-        return QueryResult(true, "Delete not yet implemented");
+        auto table = storage_engine->getTable(node.table_name);
+        if (!table)
+        {
+            return QueryResult(false, "Table not found: " + node.table_name);
+        }
+
+        vector<Condition> conditions;
+        CompiledPredicate filter;
+        const CompiledPredicate *row_filter = nullptr;
+        if (node.has_where)
+        {
+            try
+            {
+                row_filter = prepareWhere(*node.where, table->getSchema(), conditions, filter);
+            }
+            catch (const exception &e)
+            {
+                return QueryResult(false, e.what());
+            }
+        }
+
+        auto tuples = node.has_where ? table->selectWhere(conditions, row_filter) : table->selectAll();
+
+        size_t deleted = 0;
+        for (const auto &tuple : tuples)
+        {
+            if (table->deleteTuple(tuple.id))
+            {
+                deleted++;
+            }
+        }
+
+        return QueryResult(true, "Deleted " + to_string(deleted) + " rows");
     }
 
     // Execute CREATE TABLE statement - define new table structure
@@ -585,4 +1128,24 @@ namespace db
         }
     }
 
-} // namespace db
\ No newline at end of file
+    // Execute CREATE INDEX statement - build an index on existing columns
+    // Existing rows are indexed immediately, later inserts keep it up to date
+    QueryResult QueryExecutor::executeCreateIndex(const CreateIndexNode &node)
+    {
+        if (!storage_engine)
+        {
+            return QueryResult(false, "Storage engine not available");
+        }
+
+        if (storage_engine->createIndex(node.table_name, node.column_names, node.index_type,
+                                        node.include_columns, node.conditions))
+        {
+            return QueryResult(true, "Index created successfully");
+        }
+        else
+        {
+            return QueryResult(false, "Failed to create index");
+        }
+    }
+
+} // namespace db
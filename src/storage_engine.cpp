@@ -2,6 +2,9 @@
 #include <cstring>
 #include <iostream>
 #include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <fstream>
 
 using namespace std;
 
@@ -10,7 +13,8 @@ namespace db
     // Table implementation - manages data storage for a single database table
     // Constructor - create new table with name, schema, and file path
     Table::Table(const string &name, const Schema &schema, const string &db_file_path)
-        : name(name), schema(schema), first_page_id(0), next_page_id(1), next_tuple_id(1)
+        : name(name), schema(schema), file_path(db_file_path), first_page_id(0), last_page_id(0),
+          next_page_id(1), next_tuple_id(1), index_snapshots_on_disk(false), index_snapshot_generation(0)
     {
         // Create buffer pool for this table's data pages
         buffer_pool = make_unique<BufferPool>(db_file_path);
@@ -22,6 +26,7 @@ namespace db
         if (first_page_id == 0)
         {
             first_page_id = allocateNewPage(); // Allocate initial storage page
+            last_page_id = first_page_id;
         }
     }
 
@@ -69,7 +74,8 @@ namespace db
 
     // Deserialize tuple from binary format back to in-memory representation
     // Reads byte array from disk and converts back to Tuple object
-    Tuple Table::deserializeTuple(const vector<uint8_t> &buffer, size_t offset)
+    Tuple Table::deserializeTuple(const vector<uint8_t> &buffer, size_t offset,
+                                  const vector<bool> *decode_columns)
     {
         size_t current_offset = offset;
 
@@ -82,8 +88,29 @@ namespace db
         tuple.id = header.tuple_id;
 
         // Read each value based on the schema definition
-        for (const auto &column : schema.columns)
+        tuple.values.reserve(schema.columns.size());
+        for (size_t i = 0; i < schema.columns.size(); i++)
         {
+            const Column &column = schema.columns[i];
+            if (decode_columns && !(*decode_columns)[i])
+            {
+                // Not needed by the query - step over the bytes without building a value
+                if (column.type == DataType::VARCHAR)
+                {
+                    uint32_t length;
+                    memcpy(&length, buffer.data() + current_offset, sizeof(uint32_t));
+                    current_offset += sizeof(uint32_t) + length;
+                }
+                else
+                {
+                    current_offset += column.type == DataType::INTEGER  ? sizeof(int32_t)
+                                      : column.type == DataType::DOUBLE ? sizeof(double)
+                                                                        : sizeof(bool);
+                }
+                tuple.values.emplace_back();
+                continue;
+            }
+
             Value value;
             switch (column.type)
             {
@@ -116,13 +143,12 @@ namespace db
                 uint32_t length;
                 memcpy(&length, buffer.data() + current_offset, sizeof(uint32_t));
                 current_offset += sizeof(uint32_t);
-                string str_val(reinterpret_cast<const char *>(buffer.data() + current_offset), length);
-                value = str_val;
+                value = string(reinterpret_cast<const char *>(buffer.data() + current_offset), length);
                 current_offset += length;
                 break;
             }
             }
-            tuple.values.push_back(value);
+            tuple.values.push_back(move(value));
         }
 
         return tuple;
@@ -227,7 +253,7 @@ namespace db
 
     // Read all tuples from a specific page
     // Returns vector of all tuples stored on the page
-    vector<Tuple> Table::readTuplesFromPage(PageId page_id)
+    vector<Tuple> Table::readTuplesFromPage(PageId page_id, const vector<bool> *decode_columns)
     {
         auto frame = buffer_pool->getPage(page_id);
         vector<Tuple> tuples;
@@ -241,8 +267,7 @@ namespace db
         // Read all tuples sequentially from the page
         for (uint32_t i = 0; i < header.tuple_count; i++)
         {
-            Tuple tuple = deserializeTuple(frame->data, offset);
-            tuples.push_back(tuple);
+            tuples.push_back(deserializeTuple(frame->data, offset, decode_columns));
 
             // Move to next tuple position
             TupleHeader tuple_header;
@@ -261,411 +286,2040 @@ namespace db
         auto frame = buffer_pool->getPage(1);
         PageHeader header;
         memcpy(&header, frame->data.data(), sizeof(PageHeader));
+        buffer_pool->releasePage(1);
 
-        // If page 1 has a valid page ID and tuple count, this table exists
-        if (header.page_id == 1 && header.tuple_count > 0)
+        // If page 1 has a valid page ID, this table exists (it may be empty after deletes)
+        if (header.page_id == 1)
         {
             first_page_id = 1;
 
             // Find the highest page ID and tuple ID
+            vector<bool> no_columns(schema.columns.size(), false);
             PageId current_page = first_page_id;
             TupleId max_tuple_id = 0;
             PageId max_page_id = 1;
 
             while (current_page != 0)
             {
-                auto page_frame = buffer_pool->getPage(current_page);
-                PageHeader page_header;
-                memcpy(&page_header, page_frame->data.data(), sizeof(PageHeader));
-
                 max_page_id = max(max_page_id, current_page);
+                last_page_id = current_page;
 
-                // Check tuples on this page to find max tuple ID
-                auto tuples = readTuplesFromPage(current_page);
+                // Check tuples on this page to find max tuple ID and record their location
+                // (only headers are needed, so no column is decoded)
+                auto tuples = readTuplesFromPage(current_page, &no_columns);
                 for (const auto &tuple : tuples)
                 {
                     max_tuple_id = max(max_tuple_id, tuple.id);
+                    tuple_directory[tuple.id] = current_page;
                 }
 
-                current_page = page_header.next_page;
+                auto page_frame = buffer_pool->getPage(current_page);
+                PageHeader page_header;
+                memcpy(&page_header, page_frame->data.data(), sizeof(PageHeader));
                 buffer_pool->releasePage(current_page);
+                current_page = page_header.next_page;
             }
 
             // Set next IDs to avoid conflicts
             next_page_id = max_page_id + 1;
             next_tuple_id = max_tuple_id + 1;
         }
-
-        buffer_pool->releasePage(1);
     }
 
-    // Insert a new tuple into the table
-    // Finds appropriate page with space or creates new page if needed
-    bool Table::insertTuple(const Tuple &tuple)
+    // Read a single tuple by ID - the tuple directory says which page to look at
+    // so only one page is read instead of scanning the whole table
+    bool Table::fetchTuple(TupleId tuple_id, Tuple &tuple, const vector<bool> *decode_columns)
     {
-        // Assign tuple ID if not set
-        Tuple new_tuple = tuple;
-        if (new_tuple.id == 0)
+        auto it = tuple_directory.find(tuple_id);
+        if (it == tuple_directory.end())
         {
-            new_tuple.id = next_tuple_id++; // Generate unique tuple ID
+            return false; // Unknown tuple ID
         }
 
-        // Try to insert into existing pages
-        PageId current_page = first_page_id;
-        while (current_page != 0)
-        {
-            if (insertTupleIntoPage(current_page, new_tuple))
-            {
-                // Update indexes - add new tuple to all column indexes
-                for (auto &[column_name, index] : indexes)
-                {
-                    size_t col_idx = 0;
-                    // Find column index by name in schema
-                    for (size_t i = 0; i < schema.columns.size(); i++)
-                    {
-                        if (schema.columns[i].name == column_name)
-                        {
-                            col_idx = i;
-                            break;
-                        }
-                    }
-                    if (col_idx < new_tuple.values.size())
-                    {
-                        // Convert tuple value to string key for indexing
-                        string key = visit([](const auto &v)
-                                           {
-                        if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-                            return v;
-                        } else {
-                            return to_string(v);
-                        } }, new_tuple.values[col_idx]);
-                        index->insert(key, new_tuple.id);
-                    }
-                }
-                return true;
-            }
-
-            // Try next page - read page header to get next page ID
-            auto frame = buffer_pool->getPage(current_page);
-            PageHeader header;
-            memcpy(&header, frame->data.data(), sizeof(PageHeader));
-            current_page = header.next_page;
-            buffer_pool->releasePage(current_page);
-        }
+        PageId page_id = it->second;
+        auto frame = buffer_pool->getPage(page_id);
+        PageHeader header;
+        memcpy(&header, frame->data.data(), sizeof(PageHeader));
 
-        // All pages are full, allocate new page for more storage
-        PageId new_page = allocateNewPage();
-        if (insertTupleIntoPage(new_page, new_tuple))
+        bool found = false;
+        size_t offset = sizeof(PageHeader);
+        for (uint32_t i = 0; i < header.tuple_count; i++)
         {
-            // Link new page to the chain - update first page header
-            auto frame = buffer_pool->getPage(first_page_id);
-            PageHeader header;
-            memcpy(&header, frame->data.data(), sizeof(PageHeader));
-            header.next_page = new_page; // Link to new page
-            memcpy(frame->data.data(), &header, sizeof(PageHeader));
-            buffer_pool->markDirty(first_page_id); // Mark as modified
-            buffer_pool->releasePage(first_page_id);
-
-            // Update indexes - add new tuple to all indexed columns
-            for (auto &[column_name, index] : indexes)
+            TupleHeader tuple_header;
+            memcpy(&tuple_header, frame->data.data() + offset, sizeof(TupleHeader));
+            if (tuple_header.tuple_id == tuple_id)
             {
-                size_t col_idx = 0;
-                // Find column index by name
-                for (size_t i = 0; i < schema.columns.size(); i++)
-                {
-                    if (schema.columns[i].name == column_name)
-                    {
-                        col_idx = i;
-                        break;
-                    }
-                }
-                if (col_idx < new_tuple.values.size())
-                {
-                    // Convert tuple value to string key for indexing
-                    string key = visit([](const auto &v)
-                                       {
-                    if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-                        return v;
-                    } else {
-                        return to_string(v);
-                    } }, new_tuple.values[col_idx]);
-                    index->insert(key, new_tuple.id);
-                }
+                tuple = deserializeTuple(frame->data, offset, decode_columns);
+                found = true;
+                break;
             }
-            return true;
+            offset += tuple_header.tuple_size;
         }
 
-        return false; // Failed to insert
+        buffer_pool->releasePage(page_id);
+        return found;
     }
 
-    // Select all tuples from table - performs full table scan
-    // Returns vector of all tuples stored in this table
-    vector<Tuple> Table::selectAll()
+    // Add a newly stored tuple to every index on this table
+    // Only some index types (hash buckets are single pages) limit their key length
+    bool Table::fitsIndexes(const Tuple &tuple) const
     {
-        vector<Tuple> all_tuples;            // Result collection
-        PageId current_page = first_page_id; // Start from first page
-
-        // Traverse all pages in the table
-        while (current_page != 0)
+        if (tuple.values.size() < schema.columns.size())
         {
-            // Read all tuples from current page
-            auto page_tuples = readTuplesFromPage(current_page);
-            all_tuples.insert(all_tuples.end(), page_tuples.begin(), page_tuples.end());
-
-            // Get next page from page header
-            auto frame = buffer_pool->getPage(current_page);
-            PageHeader header;
-            memcpy(&header, frame->data.data(), sizeof(PageHeader));
-            PageId next_page = header.next_page;    // Store next page ID
-            buffer_pool->releasePage(current_page); // Release current page
-            current_page = next_page;               // Move to next page
+            return true; // Short rows aren't indexed
         }
 
-        return all_tuples;
-    }
-
-    // Select tuples matching WHERE condition - optimized with indexes when available
-    // Performs indexed lookup if column has index, otherwise full table scan
-    vector<Tuple> Table::selectWhere(const string &column, const Value &value)
-    {
-        // Check if we have an index for this column - enables fast lookup
-        auto index_it = indexes.find(column);
-        if (index_it != indexes.end())
+        auto fits = [&](const TableIndex &table_index)
         {
-            return selectUsingIndex(column, value); // Use B-tree index for O(log n) lookup
-        }
-
-        // Fallback to full table scan - O(n) linear search through all tuples
-        vector<Tuple> result;
-        auto all_tuples = selectAll(); // Get all tuples from table
-
-        // Find column index in schema for comparison
-        size_t col_idx = 0;
-        for (size_t i = 0; i < schema.columns.size(); i++)
+            size_t max_key = table_index.index->maxKeySize();
+            return max_key == SIZE_MAX || !table_index.holds(tuple) || table_index.makeKey(tuple).size() <= max_key;
+        };
+        for (const auto &[index_name, table_index] : indexes)
         {
-            if (schema.columns[i].name == column)
+            if (!fits(table_index))
             {
-                col_idx = i;
-                break;
+                return false;
             }
         }
-
-        // Filter tuples by comparing column value
-        for (const auto &tuple : all_tuples)
+        for (const auto &[index_name, build] : index_builds)
         {
-            if (col_idx < tuple.values.size() && tuple.values[col_idx] == value)
+            if (!fits(build.table_index))
             {
-                result.push_back(tuple); // Include matching tuple
+                return false;
             }
         }
-
-        return result;
+        return true;
     }
 
-    // Create B-tree index on specified column for fast lookups
-    // Builds index from existing data and enables O(log n) searches
-    void Table::createIndex(const string &column_name)
+    void Table::addToIndexes(const Tuple &tuple)
     {
-        if (indexes.find(column_name) != indexes.end())
+        if (tuple.values.size() < schema.columns.size())
         {
-            return; // Index already exists
+            return; // Short row - no value for some indexed columns
         }
 
-        // Create new B-tree index for this column
-        auto index = make_unique<BTree<string, TupleId>>();
-
-        // Build index from existing data - scan all tuples
-        auto all_tuples = selectAll();
-        size_t col_idx = 0;
-        // Find column index in schema
-        for (size_t i = 0; i < schema.columns.size(); i++)
+        for (auto &[index_name, table_index] : indexes)
         {
-            if (schema.columns[i].name == column_name)
+            if (table_index.holds(tuple)) // Partial indexes skip rows outside their predicate
             {
-                col_idx = i;
-                break;
+                table_index.index->insert(table_index.makeKey(tuple), tuple.id);
             }
         }
 
-        // Insert each tuple's column value into index
-        for (const auto &tuple : all_tuples)
+        // Indexes being built online pick the change up from their side log
+        for (auto &[index_name, build] : index_builds)
         {
-            if (col_idx < tuple.values.size())
+            if (build.table_index.holds(tuple))
             {
-                // Convert tuple value to string key for B-tree storage
-                string key = visit([](const auto &v)
-                                   {
-                if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-                    return v;
-                } else {
-                    return to_string(v);
-                } }, tuple.values[col_idx]);
-                index->insert(key, tuple.id); // Add to B-tree index
+                build.side_log.push_back({true, build.table_index.makeKey(tuple), tuple.id});
             }
         }
-
-        // Store index in table's index map
-        indexes[column_name] = move(index);
     }
 
-    // Fast indexed lookup - O(log n) search using B-tree index
-    // Returns tuples matching exact value on indexed column
-    vector<Tuple> Table::selectUsingIndex(const string &column, const Value &value)
+    // Remove a deleted or replaced tuple from every index on this table
+    void Table::removeFromIndexes(const Tuple &tuple)
     {
-        auto index_it = indexes.find(column);
-        if (index_it == indexes.end())
+        if (tuple.values.size() < schema.columns.size())
         {
-            return {}; // No index available
+            return; // Short rows were never indexed
         }
 
-        // Convert search value to string key for index lookup
-        string key = visit([](const auto &v)
-                           {
-        if constexpr (is_same_v<decay_t<decltype(v)>, string>) {
-            return v;
-        } else {
-            return to_string(v);
-        } }, value);
-
-        // Search B-tree index for matching key
-        auto tuple_id_ptr = index_it->second->search(key);
-        if (!tuple_id_ptr)
+        for (auto &[index_name, table_index] : indexes)
         {
-            return {}; // Not found in index
+            if (table_index.holds(tuple)) // Rows outside a partial index have no entry
+            {
+                table_index.index->remove(table_index.makeKey(tuple), tuple.id);
+            }
         }
 
-        // Find the tuple with this ID - could be optimized with direct page access
-        auto all_tuples = selectAll();
-        for (const auto &tuple : all_tuples)
+        for (auto &[index_name, build] : index_builds)
         {
-            if (tuple.id == *tuple_id_ptr)
+            if (build.table_index.holds(tuple))
             {
-                return {tuple}; // Return single matching tuple
+                build.side_log.push_back({false, build.table_index.makeKey(tuple), tuple.id});
             }
         }
-
-        return {}; // Tuple ID not found (data inconsistency)
     }
 
-    // Count total number of tuples in table by scanning all pages
-    // Returns total row count across all data pages
-    size_t Table::getTupleCount() const
+    // Replay logged changes into an index under construction
+    // The build scan may already have seen a logged row, so an insert first removes
+    // any existing entry - replaying the whole log in order always ends in the
+    // table's current state no matter when the scan read each page.
+    void Table::applyIndexLog(TableIndex &table_index, const vector<IndexLogEntry> &side_log)
     {
-        size_t count = 0;
-        PageId current_page = first_page_id;
-
-        // Traverse all pages and sum tuple counts from headers
-        while (current_page != 0)
+        for (const auto &entry : side_log)
         {
-            auto frame = buffer_pool->getPage(current_page);
-            PageHeader header;
-            memcpy(&header, frame->data.data(), sizeof(PageHeader));
-            count += header.tuple_count;     // Add tuples from this page
-            current_page = header.next_page; // Move to next page
-            buffer_pool->releasePage(current_page);
+            table_index.index->remove(entry.key, entry.tuple_id);
+            if (entry.is_insert)
+            {
+                table_index.index->insert(entry.key, entry.tuple_id);
+            }
         }
-
-        return count;
     }
 
-    // Print table statistics for debugging and monitoring
-    // Shows table name, tuple count, columns, and available indexes
-    void Table::printStats() const
+    // Remove a tuple's bytes from a page - later tuples slide down so the
+    // page stays densely packed and the freed space goes back to free_space
+    bool Table::removeTupleFromPage(PageId page_id, TupleId tuple_id)
     {
-        cout << "Table: " << name << endl;
-        cout << "  Tuple count: " << getTupleCount() << endl;
-        cout << "  Columns: ";
-        for (const auto &column : schema.columns)
+        auto frame = buffer_pool->getPage(page_id);
+        PageHeader header;
+        memcpy(&header, frame->data.data(), sizeof(PageHeader));
+
+        // Find the tuple and the end of the used area
+        size_t offset = sizeof(PageHeader);
+        size_t found_offset = 0;
+        uint32_t found_size = 0;
+        for (uint32_t i = 0; i < header.tuple_count; i++)
         {
-            cout << column.name << " ";
+            TupleHeader tuple_header;
+            memcpy(&tuple_header, frame->data.data() + offset, sizeof(TupleHeader));
+            if (tuple_header.tuple_id == tuple_id)
+            {
+                found_offset = offset;
+                found_size = tuple_header.tuple_size;
+            }
+            offset += tuple_header.tuple_size;
         }
-        cout << endl;
-        cout << "  Indexes: ";
-        for (const auto &[column_name, _] : indexes)
+
+        if (found_size == 0)
         {
-            cout << column_name << " ";
+            buffer_pool->releasePage(page_id);
+            return false; // Tuple isn't on this page
         }
-        cout << endl;
-    }
 
-    // StorageEngine implementation - manages multiple database tables
+        size_t used_end = offset;
+        memmove(frame->data.data() + found_offset, frame->data.data() + found_offset + found_size,
+                used_end - found_offset - found_size);
 
-    // Constructor - initialize storage engine with database file path
-    // Creates storage system that can manage multiple tables
-    StorageEngine::StorageEngine(const string &db_file_path)
-        : db_file_path(db_file_path)
-    {
+        header.tuple_count--;
+        header.free_space += found_size;
+        memcpy(frame->data.data(), &header, sizeof(PageHeader));
+
+        buffer_pool->markDirty(page_id);
+        buffer_pool->releasePage(page_id);
+        return true;
     }
 
-    // Create new table with specified name and schema
-    // Returns false if table already exists, true on success
-    bool StorageEngine::createTable(const string &name, const Schema &schema)
+    // Make a row's values match the schema so it serializes (and indexes) correctly
+    bool Table::conformToSchema(vector<Value> &values) const
     {
-        if (tables.find(name) != tables.end())
+        if (values.size() != schema.columns.size())
         {
-            return false; // Table already exists
+            return false; // Wrong number of values
         }
 
-        // Create table-specific file path to avoid storage conflicts
-        string table_file_path = db_file_path + "." + name;
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            DataType type = schema.columns[i].type;
+            if (type == DataType::DOUBLE && holds_alternative<int32_t>(values[i]))
+            {
+                values[i] = static_cast<double>(get<int32_t>(values[i])); // 5 -> 5.0
+            }
 
-        // Create new table instance and add to storage engine
-        tables[name] = make_unique<Table>(name, schema, table_file_path);
+            bool type_matches = (type == DataType::INTEGER && holds_alternative<int32_t>(values[i])) ||
+                                (type == DataType::DOUBLE && holds_alternative<double>(values[i])) ||
+                                (type == DataType::BOOLEAN && holds_alternative<bool>(values[i])) ||
+                                (type == DataType::VARCHAR && holds_alternative<string>(values[i]));
+            if (!type_matches)
+            {
+                return false;
+            }
+        }
         return true;
     }
 
-    // Drop (delete) table by name - removes table and all its data
-    // Returns false if table doesn't exist, true on successful deletion
-    bool StorageEngine::dropTable(const string &name)
+    // Convert a condition constant to the column's type so it encodes like stored keys
+    // Returns false when that would change the value (e.g. 2.5 against an INTEGER column)
+    static bool toKeyValue(const Value &value, DataType type, Value &key_value)
     {
-        auto it = tables.find(name);
-        if (it == tables.end())
+        if (type == DataType::DOUBLE && holds_alternative<int32_t>(value))
         {
-            return false; // Table doesn't exist
+            key_value = static_cast<double>(get<int32_t>(value));
+            return true;
+        }
+        if (type == DataType::INTEGER && holds_alternative<double>(value))
+        {
+            double d = get<double>(value);
+            if (d < INT32_MIN || d > INT32_MAX || d != static_cast<double>(static_cast<int32_t>(d)))
+            {
+                return false;
+            }
+            key_value = static_cast<int32_t>(d);
+            return true;
         }
 
-        tables.erase(it); // Remove from table map
-        return true;
+        bool type_matches = (type == DataType::INTEGER && holds_alternative<int32_t>(value)) ||
+                            (type == DataType::DOUBLE && holds_alternative<double>(value)) ||
+                            (type == DataType::BOOLEAN && holds_alternative<bool>(value)) ||
+                            (type == DataType::VARCHAR && holds_alternative<string>(value));
+        if (type_matches)
+        {
+            key_value = value;
+        }
+        return type_matches;
     }
 
-    // Get table pointer by name for internal operations
-    // Returns nullptr if table doesn't exist
-    Table *StorageEngine::getTable(const string &name)
+    // Pick the index that answers the most conditions
+    // An index is usable when its leading columns have equality conditions; an ordered
+    // index can also take range conditions on the first column after that prefix.
+    // Hash indexes only support full-key equality. Partial indexes are skipped unless
+    // the conditions imply their predicate (otherwise matching rows could be missing).
+    TableIndex *Table::chooseIndex(const vector<Condition> &conditions, size_t &eq_columns,
+                                   const vector<int> &needed_columns)
     {
-        auto it = tables.find(name);
-        return it != tables.end() ? it->second.get() : nullptr;
-    }
+        TableIndex *best = nullptr;
+        size_t best_score = 0;
+        eq_columns = 0;
 
-    // Insert tuple into specified table - delegates to table's insert method
-    // Returns false if table doesn't exist or insert fails
-    bool StorageEngine::insertTuple(const string &table_name, const Tuple &tuple)
-    {
-        auto table = getTable(table_name);
-        if (!table)
+        for (auto &[index_name, table_index] : indexes)
         {
-            return false; // Table not found
+            if (!table_index.answers(conditions))
+            {
+                continue;
+            }
+
+            // Count leading columns pinned by an equality condition
+            size_t eq = 0;
+            bool has_range = false;
+            while (eq < table_index.columns.size())
+            {
+                const Column &column = schema.columns[table_index.column_ids[eq]];
+                bool found = false;
+                for (const auto &condition : conditions)
+                {
+                    Value key_value;
+                    if (condition.column == column.name && condition.op == CompareOp::EQ &&
+                        toKeyValue(condition.value, column.type, key_value))
+                    {
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found)
+                {
+                    break;
+                }
+                eq++;
+            }
+
+            if (eq < table_index.columns.size())
+            {
+                if (!table_index.index->isOrdered())
+                {
+                    continue; // Unordered indexes need every column pinned
+                }
+
+                const Column &column = schema.columns[table_index.column_ids[eq]];
+                for (const auto &condition : conditions)
+                {
+                    Value key_value;
+                    if (condition.column == column.name && condition.op != CompareOp::EQ &&
+                        toKeyValue(condition.value, column.type, key_value))
+                    {
+                        has_range = true;
+                    }
+                }
+            }
+
+            // Each pinned column narrows the scan the most, a range a bit less;
+            // between equally selective indexes, one that avoids the heap wins
+            bool covering = !needed_columns.empty() && table_index.covers(needed_columns);
+            size_t score = (eq * 2 + (has_range ? 1 : 0)) * 2 + (covering ? 1 : 0);
+            if (score > best_score)
+            {
+                best = &table_index;
+                best_score = score;
+                eq_columns = eq;
+            }
         }
 
-        return table->insertTuple(tuple); // Delegate to table
+        return best;
     }
 
-    // Select all tuples from specified table
-    // Returns empty vector if table doesn't exist
-    vector<Tuple> StorageEngine::selectAll(const string &table_name)
+    // Bitmap indexes are found by column, whatever their names
+    TableIndex *Table::findBitmapIndex(const string &column, const vector<Condition> &conditions)
     {
-        auto table = getTable(table_name);
-        if (!table)
+        for (auto &[index_name, table_index] : indexes)
         {
-            return {}; // Table not found
+            if (table_index.index->getType() == IndexType::BITMAP && table_index.columns.size() == 1 &&
+                table_index.columns[0] == column && table_index.include_ids.empty() && table_index.answers(conditions))
+            {
+                return &table_index;
+            }
         }
-
-        return table->selectAll(); // Delegate to table
+        return nullptr;
     }
 
-    // Select tuples matching WHERE condition from specified table
-    // Uses indexed lookup if available, otherwise full table scan
-    vector<Tuple> StorageEngine::selectWhere(const string &table_name,
-                                             const string &column, const Value &value)
+    // Turn one condition into the set of rows a bitmap index says can match it
+    // Keys are single encoded values, so every operator maps to one key range
+    bool Table::conditionBitmap(const Condition &condition, const vector<Condition> &conditions,
+                                RoaringBitmap &rows)
+    {
+        TableIndex *table_index = findBitmapIndex(condition.column, conditions);
+        if (!table_index)
+        {
+            return false;
+        }
+        auto *bitmap_index = dynamic_cast<BitmapIndex *>(table_index->index.get());
+        Value key_value;
+        if (!bitmap_index || !toKeyValue(condition.value, schema.columns[table_index->column_ids[0]].type, key_value))
+        {
+            return false;
+        }
+
+        string key = encodeKey(key_value);
+        KeyRange range;
+        switch (condition.op)
+        {
+        case CompareOp::EQ:
+            range = KeyRange::exact(key);
+            break;
+        case CompareOp::LT:
+        case CompareOp::LE:
+            range.has_high = true;
+            range.high = key;
+            range.high_inclusive = condition.op == CompareOp::LE;
+            break;
+        case CompareOp::GT:
+        case CompareOp::GE:
+            range.has_low = true;
+            range.low = key;
+            range.low_inclusive = condition.op == CompareOp::GE;
+            break;
+        }
+        rows = bitmap_index->rangeBitmap(range);
+        return true;
+    }
+
+    // Combine bitmaps the way the expression combines its parts. Every result is a
+    // superset of the matching rows; the FilterOperator above drops the rest.
+    bool Table::exprBitmap(const Expr &expr, const vector<Condition> &conditions, RoaringBitmap *rows, bool &exact)
+    {
+        exact = true;
+        switch (expr.type)
+        {
+        case ExprType::AND:
+        {
+            // Intersect the children the bitmaps can answer, then subtract each NOT child
+            // answered exactly - with no positive child the NOT would need every other row
+            RoaringBitmap result;
+            bool has_positive = false;
+            vector<const Expr *> negated;
+            for (const auto &child : expr.children)
+            {
+                if (child->type == ExprType::NOT)
+                {
+                    negated.push_back(child->children[0].get());
+                    continue;
+                }
+                RoaringBitmap child_rows;
+                bool child_exact;
+                if (!exprBitmap(*child, conditions, rows ? &child_rows : nullptr, child_exact))
+                {
+                    exact = false; // Rows the filter still has to reject
+                    continue;
+                }
+                exact = exact && child_exact;
+                if (rows)
+                {
+                    result = has_positive ? result & child_rows : move(child_rows);
+                }
+                has_positive = true;
+            }
+            if (!has_positive)
+            {
+                return false;
+            }
+
+            for (const Expr *child : negated)
+            {
+                exact = false; // A NOT child may hold rows missing from a partial bitmap index
+                RoaringBitmap child_rows;
+                bool child_exact;
+                if (rows && exprBitmap(*child, conditions, &child_rows, child_exact) && child_exact)
+                {
+                    result = result.andNot(child_rows);
+                }
+            }
+            if (rows)
+            {
+                *rows = move(result);
+            }
+            return true;
+        }
+
+        case ExprType::OR:
+        {
+            // Every child has to be answered - a row matching only an unanswered one would be lost
+            vector<RoaringBitmap> parts(expr.children.size());
+            for (size_t i = 0; i < expr.children.size(); i++)
+            {
+                bool child_exact;
+                if (!exprBitmap(*expr.children[i], conditions, rows ? &parts[i] : nullptr, child_exact))
+                {
+                    return false;
+                }
+                exact = exact && child_exact;
+            }
+            if (rows)
+            {
+                vector<const RoaringBitmap *> bitmaps;
+                for (const auto &part : parts)
+                {
+                    bitmaps.push_back(&part);
+                }
+                *rows = RoaringBitmap::unionAll(bitmaps);
+            }
+            return true;
+        }
+
+        case ExprType::COMPARE:
+        case ExprType::BETWEEN:
+        case ExprType::IN:
+        {
+            // One key range per comparison - BETWEEN intersects two, IN unites one per value
+            vector<Condition> leaves;
+            if (expr.type == ExprType::COMPARE)
+            {
+                leaves.emplace_back(expr.column, expr.op, expr.values[0]);
+            }
+            else if (expr.type == ExprType::BETWEEN)
+            {
+                leaves.emplace_back(expr.column, CompareOp::GE, expr.values[0]);
+                leaves.emplace_back(expr.column, CompareOp::LE, expr.values[1]);
+            }
+            else
+            {
+                for (const auto &value : expr.values)
+                {
+                    leaves.emplace_back(expr.column, CompareOp::EQ, value);
+                }
+            }
+
+            vector<RoaringBitmap> parts(leaves.size());
+            for (size_t i = 0; i < leaves.size(); i++)
+            {
+                if (rows ? !conditionBitmap(leaves[i], conditions, parts[i])
+                         : !findBitmapIndex(leaves[i].column, conditions))
+                {
+                    return false;
+                }
+            }
+            if (rows)
+            {
+                vector<const RoaringBitmap *> bitmaps;
+                for (const auto &part : parts)
+                {
+                    bitmaps.push_back(&part);
+                }
+                *rows = expr.type == ExprType::BETWEEN ? parts[0] & parts[1] : RoaringBitmap::unionAll(bitmaps);
+            }
+            return true;
+        }
+
+        case ExprType::NOT:
+        case ExprType::IS_NULL:
+        default:
+            return false; // Would need the rows outside a bitmap (or NULLs, which have no key)
+        }
+    }
+
+    // Descend the index once for the conditions chooseIndex matched
+    // Equality columns form a key prefix; a range on the next column narrows it further
+    void Table::scanIndex(const TableIndex &table_index, const vector<Condition> &conditions,
+                          size_t eq_columns, const IndexVisitor &visitor)
+    {
+        // Encode the equality prefix in index column order
+        string prefix;
+        for (size_t i = 0; i < eq_columns; i++)
+        {
+            const Column &column = schema.columns[table_index.column_ids[i]];
+            for (const auto &condition : conditions)
+            {
+                Value key_value;
+                if (condition.column == column.name && condition.op == CompareOp::EQ &&
+                    toKeyValue(condition.value, column.type, key_value))
+                {
+                    appendKey(prefix, key_value);
+                    break;
+                }
+            }
+        }
+
+        // Every column pinned - a plain lookup works for all index types
+        // (entries with INCLUDE columns carry extra bytes, so they need the range below)
+        if (eq_columns == table_index.columns.size() && table_index.include_ids.empty())
+        {
+            for (TupleId tuple_id : table_index.index->lookup(prefix))
+            {
+                if (!visitor(prefix, tuple_id))
+                {
+                    break;
+                }
+            }
+            return;
+        }
+
+        // Start with every key that begins with the prefix: [prefix, next prefix)
+        KeyRange range;
+        range.has_low = !prefix.empty();
+        range.low = prefix;
+        range.high = prefix;
+        range.has_high = nextKeyPrefix(range.high);
+        range.high_inclusive = false;
+
+        // Tighten the range with conditions on the next column
+        // Keys equal to v in that column all start with prefix + encode(v), so every
+        // bound can be expressed as an inclusive low / exclusive high key
+        const Column &column = schema.columns[table_index.column_ids[eq_columns]];
+        for (const auto &condition : conditions)
+        {
+            Value key_value;
+            if (condition.column != column.name || condition.op == CompareOp::EQ ||
+                !toKeyValue(condition.value, column.type, key_value))
+            {
+                continue;
+            }
+
+            string bound = prefix;
+            appendKey(bound, key_value);
+            bool after_value = condition.op == CompareOp::GT || condition.op == CompareOp::LE;
+            if (after_value && !nextKeyPrefix(bound))
+            {
+                if (condition.op == CompareOp::GT)
+                {
+                    return; // Nothing sorts after this key
+                }
+                continue; // LE covers everything above - no upper bound
+            }
+
+            if (condition.op == CompareOp::GT || condition.op == CompareOp::GE)
+            {
+                if (!range.has_low || bound > range.low)
+                {
+                    range.low = bound;
+                    range.has_low = true;
+                }
+            }
+            else if (!range.has_high || bound < range.high)
+            {
+                range.high = bound;
+                range.has_high = true;
+            }
+        }
+
+        if (range.has_low && range.has_high && range.low >= range.high)
+        {
+            return; // Empty range
+        }
+
+        table_index.index->scanRange(range, visitor);
+    }
+
+    // Insert a new tuple into the table
+    // Finds appropriate page with space or creates new page if needed
+    bool Table::insertTuple(const Tuple &tuple)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        // Reject rows that don't fit the schema (they would be stored unreadably)
+        Tuple new_tuple = tuple;
+        if (!conformToSchema(new_tuple.values) || !fitsIndexes(new_tuple))
+        {
+            return false;
+        }
+
+        // Assign tuple ID if not set
+        if (new_tuple.id == 0)
+        {
+            new_tuple.id = next_tuple_id++; // Generate unique tuple ID
+        }
+
+        // Try to insert into existing pages
+        PageId current_page = first_page_id;
+        while (current_page != 0)
+        {
+            if (insertTupleIntoPage(current_page, new_tuple))
+            {
+                tuple_directory[new_tuple.id] = current_page; // Remember where the row lives
+                addToIndexes(new_tuple);                      // Add new tuple to all column indexes
+                return true;
+            }
+
+            // Try next page - read page header to get next page ID
+            auto frame = buffer_pool->getPage(current_page);
+            PageHeader header;
+            memcpy(&header, frame->data.data(), sizeof(PageHeader));
+            buffer_pool->releasePage(current_page);
+            current_page = header.next_page;
+        }
+
+        // All pages are full, allocate new page for more storage
+        PageId new_page = allocateNewPage();
+        if (insertTupleIntoPage(new_page, new_tuple))
+        {
+            // Link new page to the end of the chain - update last page header
+            auto frame = buffer_pool->getPage(last_page_id);
+            PageHeader header;
+            memcpy(&header, frame->data.data(), sizeof(PageHeader));
+            header.next_page = new_page; // Link to new page
+            memcpy(frame->data.data(), &header, sizeof(PageHeader));
+            buffer_pool->markDirty(last_page_id); // Mark as modified
+            buffer_pool->releasePage(last_page_id);
+            last_page_id = new_page;
+
+            tuple_directory[new_tuple.id] = new_page; // Remember where the row lives
+            addToIndexes(new_tuple);                  // Add new tuple to all indexed columns
+            return true;
+        }
+
+        return false; // Failed to insert
+    }
+
+    // Delete a tuple by ID - removes its bytes from the page, its directory entry
+    // and its entries in every index
+    bool Table::deleteTuple(TupleId tuple_id)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        Tuple old_tuple;
+        if (!fetchTuple(tuple_id, old_tuple))
+        {
+            return false; // No such row
+        }
+
+        removeIndexSnapshots(); // Snapshot files still hold this row
+
+        if (!removeTupleFromPage(tuple_directory[tuple_id], tuple_id))
+        {
+            return false;
+        }
+
+        tuple_directory.erase(tuple_id);
+        removeFromIndexes(old_tuple);
+        return true;
+    }
+
+    // Replace a tuple's values, keeping its ID
+    // The row is rewritten on its own page when it still fits, otherwise it moves;
+    // index entries for the old values are swapped for the new ones
+    bool Table::updateTuple(TupleId tuple_id, const vector<Value> &new_values)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        Tuple old_tuple;
+        if (!fetchTuple(tuple_id, old_tuple))
+        {
+            return false; // No such row
+        }
+
+        Tuple new_tuple(tuple_id, new_values);
+        if (!conformToSchema(new_tuple.values) || getTupleSize(new_tuple) > PAGE_SIZE - sizeof(PageHeader) ||
+            !fitsIndexes(new_tuple))
+        {
+            return false; // New values can't be stored - leave the row as it is
+        }
+
+        removeIndexSnapshots(); // Snapshot files still hold the old values
+
+        PageId page_id = tuple_directory[tuple_id];
+        if (!removeTupleFromPage(page_id, tuple_id))
+        {
+            return false;
+        }
+        removeFromIndexes(old_tuple);
+
+        if (insertTupleIntoPage(page_id, new_tuple))
+        {
+            addToIndexes(new_tuple); // Same page - directory entry is still right
+            return true;
+        }
+
+        tuple_directory.erase(tuple_id);
+        if (insertTuple(new_tuple))
+        {
+            return true; // Grew past the page - stored elsewhere
+        }
+
+        // No page took the new version - put the old row back (removing it freed exactly
+        // its size on this page) so a failed update leaves the row and its index entries
+        insertTupleIntoPage(page_id, old_tuple);
+        tuple_directory[tuple_id] = page_id;
+        addToIndexes(old_tuple);
+        return false;
+    }
+
+    // Select all tuples from table - performs full table scan
+    // Returns vector of all tuples stored in this table
+    vector<Tuple> Table::selectAll()
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<Tuple> all_tuples;            // Result collection
+        PageId current_page = first_page_id; // Start from first page
+
+        // Traverse all pages in the table
+        while (current_page != 0)
+        {
+            // Read all tuples from current page
+            auto page_tuples = readTuplesFromPage(current_page);
+            all_tuples.insert(all_tuples.end(), page_tuples.begin(), page_tuples.end());
+
+            // Get next page from page header
+            auto frame = buffer_pool->getPage(current_page);
+            PageHeader header;
+            memcpy(&header, frame->data.data(), sizeof(PageHeader));
+            PageId next_page = header.next_page;    // Store next page ID
+            buffer_pool->releasePage(current_page); // Release current page
+            current_page = next_page;               // Move to next page
+        }
+
+        return all_tuples;
+    }
+
+    // Select tuples matching WHERE condition - optimized with indexes when available
+    // Performs indexed lookup if column has index, otherwise full table scan
+    vector<Tuple> Table::selectWhere(const string &column, const Value &value)
+    {
+        return selectWhere(vector<Condition>{Condition(column, CompareOp::EQ, value)});
+    }
+
+    // Select tuples matching every condition
+    vector<Tuple> Table::selectWhere(const vector<Condition> &conditions, const CompiledPredicate *filter)
+    {
+        return selectRows(conditions, filter, nullptr);
+    }
+
+    // Find matching rows, decoding only the columns the caller needs
+    // Uses the index covering the most conditions; the remaining conditions (and the
+    // filter) are checked on each fetched row. Without a usable index, scans every page.
+    // The mask must include every column the conditions and the filter read.
+    vector<Tuple> Table::selectRows(const vector<Condition> &conditions, const CompiledPredicate *filter,
+                                    const vector<bool> *decode_columns)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<Tuple> result;
+
+        // Resolve column positions once instead of per row
+        vector<int> col_ids;
+        for (const auto &condition : conditions)
+        {
+            int col_idx = schema.findColumn(condition.column);
+            if (col_idx < 0)
+            {
+                return result; // Unknown column matches nothing
+            }
+            col_ids.push_back(col_idx);
+        }
+
+        auto matches = [&](const Tuple &tuple)
+        {
+            for (size_t i = 0; i < conditions.size(); i++)
+            {
+                if (static_cast<size_t>(col_ids[i]) >= tuple.values.size() ||
+                    !conditions[i].matches(tuple.values[col_ids[i]]))
+                {
+                    return false;
+                }
+            }
+            return !filter || (*filter)(tuple.values);
+        };
+
+        // Indexed path - fetch only the rows an index says can match
+        vector<TupleId> tuple_ids;
+        if (findCandidates(conditions, tuple_ids))
+        {
+            for (TupleId tuple_id : tuple_ids)
+            {
+                Tuple tuple;
+                if (fetchTuple(tuple_id, tuple, decode_columns) && matches(tuple))
+                {
+                    result.push_back(move(tuple));
+                }
+            }
+            return result;
+        }
+
+        // Fallback to full table scan - O(n) linear search through all tuples
+        PageId current_page = first_page_id;
+        while (current_page != 0)
+        {
+            for (auto &tuple : readTuplesFromPage(current_page, decode_columns))
+            {
+                if (matches(tuple))
+                {
+                    result.push_back(move(tuple)); // Include matching tuple
+                }
+            }
+
+            auto frame = buffer_pool->getPage(current_page);
+            PageHeader header;
+            memcpy(&header, frame->data.data(), sizeof(PageHeader));
+            buffer_pool->releasePage(current_page);
+            current_page = header.next_page;
+        }
+
+        return result;
+    }
+
+    // Collect the rows an index says may match every condition
+    // Bitmap paths - the WHERE expression as bitmap operations (exprBitmap), or the AND of
+    // the bitmaps of every condition on a bitmap-indexed column, giving tuple ID order.
+    // Used when they combine several conditions, or when no other index narrows the
+    // search. Otherwise one descent of the index chooseIndex picks.
+    bool Table::findCandidates(const vector<Condition> &conditions, vector<TupleId> &tuple_ids,
+                               const Expr *where)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        tuple_ids.clear();
+
+        size_t eq_columns = 0;
+        TableIndex *table_index = chooseIndex(conditions, eq_columns);
+
+        // Whole-expression path - only when no other index narrows the conditions
+        RoaringBitmap rows;
+        bool exact;
+        if (where && (!table_index || table_index->index->getType() == IndexType::BITMAP) &&
+            exprBitmap(*where, conditions, &rows, exact))
+        {
+            rows.forEach([&](TupleId tuple_id)
+                         {
+                tuple_ids.push_back(tuple_id);
+                return true; });
+            return true;
+        }
+
+        size_t bitmap_conditions = 0;
+        for (const auto &condition : conditions)
+        {
+            if (findBitmapIndex(condition.column, conditions))
+            {
+                bitmap_conditions++;
+            }
+        }
+
+        if (bitmap_conditions >= 2 ||
+            (bitmap_conditions == 1 && (!table_index || table_index->index->getType() == IndexType::BITMAP)))
+        {
+            RoaringBitmap candidates;
+            bool first = true;
+            for (const auto &condition : conditions)
+            {
+                RoaringBitmap rows;
+                if (conditionBitmap(condition, conditions, rows))
+                {
+                    candidates = first ? move(rows) : candidates & rows;
+                    first = false;
+                }
+            }
+
+            if (!first)
+            {
+                candidates.forEach([&](TupleId tuple_id)
+                                   {
+                    tuple_ids.push_back(tuple_id);
+                    return true; });
+                return true;
+            }
+        }
+
+        if (!table_index)
+        {
+            return false; // No index helps - the caller scans the pages
+        }
+
+        scanIndex(*table_index, conditions, eq_columns, [&](const string &, TupleId tuple_id)
+                  {
+            tuple_ids.push_back(tuple_id);
+            return true; });
+        return true;
+    }
+
+    // An index helps if chooseIndex finds one, or a condition's column has a bitmap index
+    bool Table::hasIndexFor(const vector<Condition> &conditions, const Expr *where)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        size_t eq_columns = 0;
+        bool exact;
+        if (chooseIndex(conditions, eq_columns) || (where && exprBitmap(*where, conditions, nullptr, exact)))
+        {
+            return true;
+        }
+        for (const auto &condition : conditions)
+        {
+            if (findBitmapIndex(condition.column, conditions))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Same choice selectColumns makes before its index-only scan
+    bool Table::hasCoveringIndexFor(const vector<Condition> &conditions, const vector<int> &needed_columns)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        size_t eq_columns = 0;
+        TableIndex *table_index = chooseIndex(conditions, eq_columns, needed_columns);
+        return table_index && table_index->covers(needed_columns);
+    }
+
+    // An index sorts rows by its key columns in order, so its leading columns have to be
+    // exactly the sort columns; a partial index must hold every row the query can return
+    string Table::findOrderedIndex(const vector<int> &sort_columns, const vector<Condition> &conditions)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            if (table_index.index->isOrdered() && table_index.column_ids.size() >= sort_columns.size() &&
+                equal(sort_columns.begin(), sort_columns.end(), table_index.column_ids.begin()) &&
+                table_index.answers(conditions))
+            {
+                return index_name;
+            }
+        }
+        return "";
+    }
+
+    // Scan from just after last_key, stopping at the first key change after max_entries
+    // (entries sharing a key are never split across chunks)
+    bool Table::readIndexInOrder(const string &index_name, bool from_start, string &last_key, size_t max_entries,
+                                 vector<TupleId> &tuple_ids)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        tuple_ids.clear();
+        auto it = indexes.find(index_name);
+        if (it == indexes.end())
+        {
+            return false;
+        }
+
+        KeyRange range;
+        range.has_low = !from_start;
+        range.low = last_key;
+        range.low_inclusive = false;
+        it->second.index->scanRange(range, [&](const string &key, TupleId tuple_id)
+                                    {
+            if (tuple_ids.size() >= max_entries && key != last_key)
+            {
+                return false; // Chunk full and the key changed
+            }
+            last_key = key;
+            tuple_ids.push_back(tuple_id);
+            return true; });
+        return true;
+    }
+
+    string Table::findBoundIndex(int column)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        string found;
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            if (table_index.index->isOrdered() && table_index.column_ids[0] == column &&
+                table_index.predicate.empty())
+            {
+                if (table_index.index->getType() == IndexType::B_TREE)
+                {
+                    return index_name; // Last key in one descent
+                }
+                found = index_name;
+            }
+        }
+        return found;
+    }
+
+    // The first key is the first entry a range scan visits; the scan stops right there
+    bool Table::readIndexBound(const string &index_name, bool largest, Value &value)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        auto it = indexes.find(index_name);
+        if (it == indexes.end())
+        {
+            return false;
+        }
+
+        string key;
+        bool found = false;
+        if (largest)
+        {
+            found = it->second.index->lastKey(key);
+        }
+        else
+        {
+            it->second.index->scanRange(KeyRange(), [&](const string &first_key, TupleId)
+                                        {
+                key = first_key;
+                found = true;
+                return false; });
+        }
+
+        size_t pos = 0;
+        return found && decodeKey(key, pos, schema.columns[it->second.column_ids[0]].type, value);
+    }
+
+    // Read one page for a streaming scan - the page is pinned only inside this call
+    vector<Tuple> Table::scanPage(PageId page_id, PageId &next_page, const vector<bool> *decode_columns)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<Tuple> tuples = readTuplesFromPage(page_id, decode_columns);
+
+        auto frame = buffer_pool->getPage(page_id);
+        PageHeader header;
+        memcpy(&header, frame->data.data(), sizeof(PageHeader));
+        buffer_pool->releasePage(page_id);
+        next_page = header.next_page;
+        return tuples;
+    }
+
+    // Decode part of a page into a batch - the page is pinned only inside this call
+    // A batch that fills up mid-page resumes at the same row number on the next call
+    bool Table::scanPageInto(PageId page_id, size_t &row, RowBatch &batch, PageId &next_page,
+                             const vector<bool> *decode_columns)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        auto frame = buffer_pool->getPage(page_id);
+        const uint8_t *data = frame->data.data();
+
+        PageHeader header;
+        memcpy(&header, data, sizeof(PageHeader));
+        next_page = header.next_page;
+
+        bool page_done = decodePageInto(data, row, batch, decode_columns);
+        buffer_pool->releasePage(page_id);
+        return page_done;
+    }
+
+    // Copy a page's bytes out of the buffer pool, so it can be decoded with no latch held
+    void Table::copyPage(PageId page_id, vector<uint8_t> &bytes, PageId &next_page)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        auto frame = buffer_pool->getPage(page_id);
+        bytes.assign(frame->data.begin(), frame->data.end());
+        buffer_pool->releasePage(page_id);
+
+        PageHeader header;
+        memcpy(&header, bytes.data(), sizeof(PageHeader));
+        next_page = header.next_page;
+    }
+
+    // Decode rows from page bytes into a batch - shared by scanPageInto and parallel scans
+    bool Table::decodePageInto(const uint8_t *data, size_t &row, RowBatch &batch,
+                               const vector<bool> *decode_columns) const
+    {
+        PageHeader header;
+        memcpy(&header, data, sizeof(PageHeader));
+
+        // Step over the rows earlier batches already took
+        size_t offset = sizeof(PageHeader);
+        for (size_t i = 0; i < row && i < header.tuple_count; i++)
+        {
+            TupleHeader tuple_header;
+            memcpy(&tuple_header, data + offset, sizeof(TupleHeader));
+            offset += tuple_header.tuple_size;
+        }
+
+        while (row < header.tuple_count && !batch.full())
+        {
+            TupleHeader tuple_header;
+            memcpy(&tuple_header, data + offset, sizeof(TupleHeader));
+            size_t pos = offset + sizeof(TupleHeader);
+            batch.ids.push_back(tuple_header.tuple_id);
+
+            for (size_t i = 0; i < schema.columns.size(); i++)
+            {
+                ColumnVector &column = batch.columns[i];
+                bool decode = !decode_columns || (*decode_columns)[i];
+                switch (schema.columns[i].type)
+                {
+                case DataType::INTEGER:
+                {
+                    int32_t int_val = 0;
+                    if (decode)
+                        memcpy(&int_val, data + pos, sizeof(int32_t));
+                    column.ints.push_back(int_val);
+                    pos += sizeof(int32_t);
+                    break;
+                }
+                case DataType::DOUBLE:
+                {
+                    double double_val = 0.0;
+                    if (decode)
+                        memcpy(&double_val, data + pos, sizeof(double));
+                    column.doubles.push_back(double_val);
+                    pos += sizeof(double);
+                    break;
+                }
+                case DataType::BOOLEAN:
+                {
+                    bool bool_val = false;
+                    if (decode)
+                        memcpy(&bool_val, data + pos, sizeof(bool));
+                    column.bools.push_back(bool_val ? 1 : 0);
+                    pos += sizeof(bool);
+                    break;
+                }
+                case DataType::VARCHAR:
+                {
+                    uint32_t length;
+                    memcpy(&length, data + pos, sizeof(uint32_t));
+                    pos += sizeof(uint32_t);
+                    if (decode)
+                        column.strings.emplace_back(reinterpret_cast<const char *>(data + pos), length);
+                    else
+                        column.strings.emplace_back();
+                    pos += length;
+                    break;
+                }
+                }
+            }
+
+            batch.selection.push_back(static_cast<uint32_t>(batch.size++));
+            offset += tuple_header.tuple_size;
+            row++;
+        }
+
+        return row >= header.tuple_count;
+    }
+
+    // Public, latched form of fetchTuple
+    bool Table::readTuple(TupleId tuple_id, Tuple &tuple, const vector<bool> *decode_columns)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        return fetchTuple(tuple_id, tuple, decode_columns);
+    }
+
+    // Select only some columns of the rows matching every condition
+    // If one index stores every referenced column, entries are decoded straight from
+    // the index keys (index-only scan); otherwise rows are fetched and then projected.
+    vector<Tuple> Table::selectColumns(const vector<string> &columns, const vector<Condition> &conditions,
+                                       const CompiledPredicate *filter)
+    {
+        unique_lock<recursive_mutex> latch(table_latch);
+        vector<Tuple> result;
+
+        // Resolve output and condition columns once
+        vector<int> output_ids;
+        for (const auto &column : columns)
+        {
+            int col_idx = schema.findColumn(column);
+            if (col_idx < 0)
+            {
+                return result; // Unknown column
+            }
+            output_ids.push_back(col_idx);
+        }
+
+        vector<int> condition_ids;
+        for (const auto &condition : conditions)
+        {
+            int col_idx = schema.findColumn(condition.column);
+            if (col_idx < 0)
+            {
+                return result; // Unknown column matches nothing
+            }
+            condition_ids.push_back(col_idx);
+        }
+
+        vector<int> needed_ids = output_ids;
+        needed_ids.insert(needed_ids.end(), condition_ids.begin(), condition_ids.end());
+        if (filter)
+        {
+            needed_ids.insert(needed_ids.end(), filter->columnIds().begin(), filter->columnIds().end());
+        }
+
+        size_t eq_columns = 0;
+        TableIndex *table_index = chooseIndex(conditions, eq_columns, needed_ids);
+        if (!table_index || !table_index->covers(needed_ids))
+        {
+            // No covering index - read rows decoding only the referenced columns, then
+            // move the requested ones out (unused VARCHARs are never copied)
+            vector<bool> decode_columns(schema.columns.size(), false);
+            for (int col_idx : needed_ids)
+            {
+                decode_columns[col_idx] = true;
+            }
+            // A column listed twice is copied for every use but its last
+            vector<bool> last_use(output_ids.size(), true);
+            for (size_t i = 0; i < output_ids.size(); i++)
+            {
+                for (size_t j = i + 1; j < output_ids.size(); j++)
+                {
+                    last_use[i] = last_use[i] && output_ids[j] != output_ids[i];
+                }
+            }
+
+            for (auto &tuple : selectRows(conditions, filter, &decode_columns))
+            {
+                Tuple projected;
+                projected.id = tuple.id;
+                projected.values.reserve(output_ids.size());
+                for (size_t i = 0; i < output_ids.size(); i++)
+                {
+                    Value &value = tuple.values[output_ids[i]];
+                    projected.values.push_back(last_use[i] ? move(value) : value);
+                }
+                result.push_back(move(projected));
+            }
+            return result;
+        }
+
+        // Index-only scans can run long, so read a snapshot of the index when it offers
+        // one and let writers continue (the catalog entry is copied for the same reason)
+        TableIndex snapshot_index;
+        snapshot_index.index = table_index->index->snapshot();
+        if (snapshot_index.index)
+        {
+            snapshot_index.name = table_index->name;
+            snapshot_index.columns = table_index->columns;
+            snapshot_index.column_ids = table_index->column_ids;
+            snapshot_index.include_columns = table_index->include_columns;
+            snapshot_index.include_ids = table_index->include_ids;
+            table_index = &snapshot_index;
+            latch.unlock();
+        }
+
+        // Index-only scan - rebuild the covered columns from each entry's key
+        vector<int> stored_ids = table_index->column_ids;
+        stored_ids.insert(stored_ids.end(), table_index->include_ids.begin(), table_index->include_ids.end());
+
+        vector<Value> row(schema.columns.size());
+        auto visit_entry = [&](const string &key, TupleId tuple_id)
+        {
+            size_t pos = 0;
+            for (int col_idx : stored_ids)
+            {
+                if (!decodeKey(key, pos, schema.columns[col_idx].type, row[col_idx]))
+                {
+                    return true; // Malformed entry - skip it
+                }
+            }
+
+            for (size_t i = 0; i < conditions.size(); i++)
+            {
+                if (!conditions[i].matches(row[condition_ids[i]]))
+                {
+                    return true; // Filtered out, keep scanning
+                }
+            }
+            if (filter && !(*filter)(row))
+            {
+                return true;
+            }
+
+            Tuple projected;
+            projected.id = tuple_id;
+            for (int col_idx : output_ids)
+            {
+                projected.values.push_back(row[col_idx]);
+            }
+            result.push_back(move(projected));
+            return true;
+        };
+
+        scanIndex(*table_index, conditions, eq_columns, visit_entry);
+        return result;
+    }
+
+    // Catalog name of an index: its columns joined with '+', then "@TYPE" unless it is a
+    // B-tree, "#" and the INCLUDE columns joined with '+', and "~" and a hash of the
+    // predicate for a partial index (e.g. "tenant_id+created_at", "status@HASH",
+    // "amount#status~5e3a91c0"). Indexes that differ in any of these can coexist on
+    // the same columns; the name is also part of the index's file names.
+    static string deriveIndexName(const vector<string> &column_names, IndexType type,
+                                  const vector<string> &include_columns, const vector<Condition> &predicate)
+    {
+        auto join = [](const vector<string> &names)
+        {
+            string joined;
+            for (const auto &name : names)
+            {
+                joined += (joined.empty() ? "" : "+") + name;
+            }
+            return joined;
+        };
+
+        string name = join(column_names);
+        if (type != IndexType::B_TREE)
+        {
+            name += "@" + indexTypeName(type);
+        }
+        if (!include_columns.empty())
+        {
+            name += "#" + join(include_columns);
+        }
+        if (!predicate.empty())
+        {
+            // FNV-1a over each condition's column, operator and encoded value
+            uint32_t hash = 2166136261u;
+            auto mix = [&](const string &bytes)
+            {
+                for (unsigned char c : bytes)
+                {
+                    hash = (hash ^ c) * 16777619u;
+                }
+                hash = (hash ^ 0xFF) * 16777619u; // Separator, so "ab" + "c" differs from "a" + "bc"
+            };
+            for (const auto &condition : predicate)
+            {
+                mix(condition.column);
+                mix(string(1, static_cast<char>(condition.op)));
+                mix(encodeKey(condition.value));
+            }
+            char hex[9];
+            snprintf(hex, sizeof(hex), "%08x", hash);
+            name += "~" + string(hex);
+        }
+        return name;
+    }
+
+    // Create an index on specified column for fast lookups
+    bool Table::createIndex(const string &column_name, IndexType type)
+    {
+        return createIndex(vector<string>{column_name}, type);
+    }
+
+    // Create an index over one or more columns, optionally carrying INCLUDE columns
+    // Online build: the table latch is held only while one page is read, so writers
+    // keep running. Their changes go to the build's side log, which is replayed
+    // after the scan; the final replay and the switch happen under the latch.
+    bool Table::createIndex(const vector<string> &column_names, IndexType type,
+                            const vector<string> &include_columns, const vector<Condition> &predicate)
+    {
+        if (column_names.empty())
+        {
+            return false; // Nothing to index
+        }
+
+        TableIndex table_index;
+        for (const auto &column_name : column_names)
+        {
+            int col_idx = schema.findColumn(column_name);
+            if (col_idx < 0)
+            {
+                return false; // Column doesn't exist
+            }
+            if (find(table_index.column_ids.begin(), table_index.column_ids.end(), col_idx) !=
+                table_index.column_ids.end())
+            {
+                return false; // A column can't be a key column twice
+            }
+            table_index.columns.push_back(column_name);
+            table_index.column_ids.push_back(col_idx);
+        }
+
+        for (const auto &column_name : include_columns)
+        {
+            int col_idx = schema.findColumn(column_name);
+            if (col_idx < 0)
+            {
+                return false; // Column doesn't exist
+            }
+            table_index.include_columns.push_back(column_name);
+            table_index.include_ids.push_back(col_idx);
+        }
+
+        for (const auto &condition : predicate)
+        {
+            int col_idx = schema.findColumn(condition.column);
+            if (col_idx < 0)
+            {
+                return false; // Predicate on a column that doesn't exist
+            }
+            table_index.predicate.push_back(condition);
+            table_index.predicate_ids.push_back(col_idx);
+        }
+
+        if (type == IndexType::LEARNED &&
+            (table_index.column_ids.size() != 1 || !table_index.include_ids.empty() ||
+             schema.columns[table_index.column_ids[0]].type != DataType::INTEGER))
+        {
+            return false; // Learned models are fit to plain single INTEGER keys
+        }
+
+        if (!table_index.include_ids.empty() && !indexTypeIsOrdered(type))
+        {
+            return false; // INCLUDE entries are found by key prefix, which needs an ordered index
+        }
+
+        // Register the build - from here on every write is logged for the new index
+        table_index.name = deriveIndexName(column_names, type, include_columns, predicate);
+        string index_name = table_index.name;
+        IndexBuild *build;
+        {
+            lock_guard<recursive_mutex> latch(table_latch);
+            if (indexes.find(index_name) != indexes.end() ||
+                index_builds.find(index_name) != index_builds.end())
+            {
+                return false; // Index already exists (or is being built)
+            }
+
+            // Create the index structure - disk-backed types get a file next to the table
+            table_index.index = makeIndex(type, indexFilePath(index_name));
+
+            // Disk-backed indexes get a change buffer - writes are merged in sorted batches
+            if (table_index.index->isDiskBacked())
+            {
+                table_index.index = make_unique<BufferedIndex>(move(table_index.index));
+            }
+
+            // B-trees get an adaptive hash index - hot keys skip the tree descent
+            if (type == IndexType::B_TREE)
+            {
+                table_index.index = make_unique<AdaptiveHashIndex>(move(table_index.index));
+            }
+
+            build = &index_builds[index_name];
+            build->table_index = move(table_index);
+        }
+        TableIndex &new_index = build->table_index;
+
+        // Build from existing data - from the snapshot file written at the last checkpoint
+        // if there is one, otherwise one page at a time, releasing the latch in between
+        PageId current_page = loadIndexSnapshot(new_index, type) ? 0 : first_page_id;
+        while (current_page != 0)
+        {
+            vector<Tuple> page_tuples;
+            {
+                lock_guard<recursive_mutex> latch(table_latch);
+                page_tuples = readTuplesFromPage(current_page);
+
+                auto frame = buffer_pool->getPage(current_page);
+                PageHeader header;
+                memcpy(&header, frame->data.data(), sizeof(PageHeader));
+                buffer_pool->releasePage(current_page);
+                current_page = header.next_page;
+            }
+
+            for (const auto &tuple : page_tuples)
+            {
+                if (tuple.values.size() >= schema.columns.size() && new_index.holds(tuple))
+                {
+                    string key = new_index.makeKey(tuple);
+                    if (key.size() > new_index.index->maxKeySize())
+                    {
+                        // A stored row's key doesn't fit this index type - give up the build
+                        lock_guard<recursive_mutex> latch(table_latch);
+                        index_builds.erase(index_name);
+                        std::remove(indexFilePath(index_name).c_str());
+                        return false;
+                    }
+                    new_index.index->insert(key, tuple.id); // Add to index
+                }
+            }
+        }
+
+        // Catch up on changes made during the scan until the remaining delta is small
+        while (true)
+        {
+            vector<IndexLogEntry> side_log;
+            {
+                lock_guard<recursive_mutex> latch(table_latch);
+                side_log.swap(build->side_log);
+            }
+            applyIndexLog(new_index, side_log);
+            if (side_log.size() <= INDEX_LOG_SWITCH_THRESHOLD)
+            {
+                break;
+            }
+        }
+
+        // Apply the last changes and switch the index on - queries see it all at once
+        lock_guard<recursive_mutex> latch(table_latch);
+        applyIndexLog(new_index, build->side_log);
+        indexes[index_name] = move(new_index);
+        index_builds.erase(index_name);
+        return true;
+    }
+
+    // Fast indexed lookup - the index finds matching tuple IDs (through lookupIndex, like
+    // IndexManager::lookupIndex) and the tuple directory fetches each row from its page
+    vector<Tuple> Table::selectUsingIndex(const string &column, const Value &value)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<TupleId> tuple_ids;
+        if (!lookupIndex(column, value, tuple_ids))
+        {
+            return {}; // No index available
+        }
+
+        vector<Tuple> result;
+        for (TupleId tuple_id : tuple_ids)
+        {
+            Tuple tuple;
+            if (fetchTuple(tuple_id, tuple))
+            {
+                result.push_back(move(tuple));
+            }
+        }
+
+        return result;
+    }
+
+    // Drop an index - later queries fall back to other indexes or scans
+    bool Table::dropIndex(const string &index_name)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        if (indexes.erase(index_name) == 0)
+        {
+            return false;
+        }
+        // The index is destroyed (and its file closed) by now, so its files can go
+        std::remove(indexSnapshotPath(index_name).c_str());
+        std::remove(indexFilePath(index_name).c_str());
+        return true;
+    }
+
+    // Index snapshot file layout (integers in native byte order, like the metadata file):
+    //   magic, IndexType, key column names, INCLUDE column names, last tuple ID stored,
+    //   entry count, then every entry in index order: key length, key bytes, tuple ID
+    static const char INDEX_SNAPSHOT_MAGIC[8] = {'I', 'D', 'X', 'S', 'N', 'A', 'P', '1'};
+
+    // Write one index's entries to a snapshot file (false if the file can't be written)
+    static bool writeIndexSnapshotFile(const string &path, IndexType type, const TableIndex &table_index,
+                                       TupleId last_tuple_id, Index &source)
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        if (!file.is_open())
+        {
+            return false;
+        }
+
+        auto write_string = [&](const string &str)
+        {
+            uint32_t length = static_cast<uint32_t>(str.length());
+            file.write(reinterpret_cast<const char *>(&length), sizeof(uint32_t));
+            file.write(str.data(), length);
+        };
+        auto write_names = [&](const vector<string> &names)
+        {
+            uint32_t count = static_cast<uint32_t>(names.size());
+            file.write(reinterpret_cast<const char *>(&count), sizeof(uint32_t));
+            for (const string &name : names)
+            {
+                write_string(name);
+            }
+        };
+
+        file.write(INDEX_SNAPSHOT_MAGIC, sizeof(INDEX_SNAPSHOT_MAGIC));
+        file.write(reinterpret_cast<const char *>(&type), sizeof(IndexType));
+        write_names(table_index.columns);
+        write_names(table_index.include_columns);
+        file.write(reinterpret_cast<const char *>(&last_tuple_id), sizeof(TupleId));
+
+        // Entry count is patched in once the scan has counted them
+        streampos count_pos = file.tellp();
+        uint64_t entry_count = 0;
+        file.write(reinterpret_cast<const char *>(&entry_count), sizeof(uint64_t));
+
+        // Entries come out of the ordered index already sorted - one sequential write
+        source.scanRange(KeyRange(), [&](const string &key, TupleId tuple_id)
+                         {
+            write_string(key);
+            file.write(reinterpret_cast<const char *>(&tuple_id), sizeof(TupleId));
+            entry_count++;
+            return true; });
+
+        file.seekp(count_pos);
+        file.write(reinterpret_cast<const char *>(&entry_count), sizeof(uint64_t));
+        return file.good();
+    }
+
+    // Snapshots are first written to temporary files; they replace the old files only
+    // if no row was updated or deleted meanwhile (B-tree indexes are written from an
+    // index snapshot with the latch released, so writers can run during the write)
+    void Table::writeIndexSnapshots()
+    {
+        unique_lock<recursive_mutex> latch(table_latch);
+        TupleId last_tuple_id = next_tuple_id - 1;
+        size_t generation = index_snapshot_generation;
+
+        struct PendingFile
+        {
+            string path;                // Final snapshot file
+            IndexType type;             // Type of the index written
+            TableIndex columns;         // Copy of the catalog columns (no index attached)
+            unique_ptr<Index> snapshot; // Read-only copy to write without the latch
+            bool written;               // Temporary file complete?
+        };
+        vector<PendingFile> pending;
+
+        for (auto &[index_name, table_index] : indexes)
+        {
+            Index &index = *table_index.index;
+            if (!index.isOrdered() || index.isDiskBacked())
+            {
+                continue; // Only memory-resident ordered indexes are snapshotted
+            }
+
+            PendingFile file;
+            file.path = indexSnapshotPath(index_name);
+            file.type = index.getType();
+            file.columns.columns = table_index.columns;
+            file.columns.include_columns = table_index.include_columns;
+            file.snapshot = index.snapshot();
+            file.written = false;
+            if (!file.snapshot)
+            {
+                // No index snapshot for this type - write it now, under the latch
+                file.written = writeIndexSnapshotFile(file.path + ".tmp", file.type, file.columns, last_tuple_id, index);
+            }
+            pending.push_back(move(file));
+        }
+
+        // Write the rest from their snapshots without holding up writers
+        latch.unlock();
+        for (auto &file : pending)
+        {
+            if (file.snapshot)
+            {
+                file.written = writeIndexSnapshotFile(file.path + ".tmp", file.type, file.columns,
+                                                      last_tuple_id, *file.snapshot);
+                file.snapshot.reset();
+            }
+        }
+        latch.lock();
+
+        // Publish the files, or drop them if rows they contain changed while writing
+        bool current = generation == index_snapshot_generation;
+        for (const auto &file : pending)
+        {
+            string temp_path = file.path + ".tmp";
+            if (current && file.written)
+            {
+                std::rename(temp_path.c_str(), file.path.c_str());
+                index_snapshots_on_disk = true;
+            }
+            else
+            {
+                std::remove(temp_path.c_str());
+            }
+        }
+    }
+
+    bool Table::loadIndexSnapshot(TableIndex &table_index, IndexType type)
+    {
+        string path = indexSnapshotPath(table_index.name);
+        ifstream file(path, ios::binary | ios::ate);
+        if (!file.is_open())
+        {
+            return false; // No snapshot written for this index
+        }
+
+        // Read the whole file in one go, then decode it from memory
+        string data(static_cast<size_t>(file.tellg()), '\0');
+        file.seekg(0);
+        file.read(&data[0], data.size());
+        file.close();
+
+        size_t pos = 0;
+        auto read_bytes = [&](void *target, size_t size)
+        {
+            if (data.size() - pos < size)
+            {
+                return false;
+            }
+            memcpy(target, data.data() + pos, size);
+            pos += size;
+            return true;
+        };
+        auto read_string = [&](string &str)
+        {
+            uint32_t length;
+            if (!read_bytes(&length, sizeof(uint32_t)) || data.size() - pos < length)
+            {
+                return false;
+            }
+            str.assign(data, pos, length);
+            pos += length;
+            return true;
+        };
+        auto read_names = [&](vector<string> &names)
+        {
+            uint32_t count;
+            if (!read_bytes(&count, sizeof(uint32_t)) || count > data.size())
+            {
+                return false;
+            }
+            names.resize(count);
+            for (string &name : names)
+            {
+                if (!read_string(name))
+                    return false;
+            }
+            return true;
+        };
+
+        char magic[sizeof(INDEX_SNAPSHOT_MAGIC)];
+        IndexType file_type;
+        vector<string> columns;
+        vector<string> include_columns;
+        TupleId last_tuple_id;
+        uint64_t entry_count;
+        bool valid = read_bytes(magic, sizeof(magic)) &&
+                     memcmp(magic, INDEX_SNAPSHOT_MAGIC, sizeof(magic)) == 0 &&
+                     read_bytes(&file_type, sizeof(IndexType)) && file_type == type &&
+                     read_names(columns) && columns == table_index.columns &&
+                     read_names(include_columns) && include_columns == table_index.include_columns &&
+                     read_bytes(&last_tuple_id, sizeof(TupleId)) && last_tuple_id < next_tuple_id &&
+                     read_bytes(&entry_count, sizeof(uint64_t));
+
+        vector<pair<string, TupleId>> entries;
+        if (valid)
+        {
+            entries.reserve(min<uint64_t>(entry_count, data.size()));
+            for (uint64_t i = 0; i < entry_count && valid; i++)
+            {
+                pair<string, TupleId> entry;
+                valid = read_string(entry.first) && read_bytes(&entry.second, sizeof(TupleId));
+                entries.push_back(move(entry));
+            }
+            valid = valid && pos == data.size();
+        }
+        if (!valid)
+        {
+            std::remove(path.c_str()); // Stale or damaged - the caller scans the table instead
+            return false;
+        }
+
+        table_index.index->bulkLoad(entries);
+
+        // Rows stored after the snapshot was taken (any written during this build are
+        // also in the side log, and replaying both leaves one entry)
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<TupleId> newer_rows;
+        for (const auto &[tuple_id, page_id] : tuple_directory)
+        {
+            if (tuple_id > last_tuple_id)
+            {
+                newer_rows.push_back(tuple_id);
+            }
+        }
+        sort(newer_rows.begin(), newer_rows.end());
+        for (TupleId tuple_id : newer_rows)
+        {
+            Tuple tuple;
+            if (fetchTuple(tuple_id, tuple) && tuple.values.size() >= schema.columns.size() &&
+                table_index.holds(tuple))
+            {
+                table_index.index->insert(table_index.makeKey(tuple), tuple_id);
+            }
+        }
+        index_snapshots_on_disk = true;
+        return true;
+    }
+
+    void Table::removeIndexSnapshots()
+    {
+        index_snapshot_generation++; // Files being written right now are stale too
+        if (!index_snapshots_on_disk)
+        {
+            return;
+        }
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            std::remove(indexSnapshotPath(index_name).c_str());
+        }
+        for (const auto &[index_name, build] : index_builds)
+        {
+            std::remove(indexSnapshotPath(index_name).c_str());
+        }
+        index_snapshots_on_disk = false;
+    }
+
+    // Indexes on a single column
+    bool Table::hasIndexOn(const string &column) const
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            if (table_index.columns.size() == 1 && table_index.columns[0] == column)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // The index is used while the latch is held: DROP INDEX can't free it mid-lookup,
+    // and lookups that reorganize an index (adaptive hash, change buffer) don't race
+    // with writers. findCandidates picks among the column's indexes and converts the
+    // value like stored keys are (e.g. 5 for a DOUBLE column); an equality on the only
+    // key column finds exactly the matching rows.
+    bool Table::lookupIndex(const string &column, const Value &value, vector<TupleId> &tuple_ids)
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        tuple_ids.clear();
+        if (!hasIndexOn(column))
+        {
+            return false;
+        }
+
+        // No index can answer it when only partial indexes that may miss the rows exist
+        // (or the value can't be a key of the column) - then scan
+        vector<Condition> conditions = {Condition(column, CompareOp::EQ, value)};
+        if (!findCandidates(conditions, tuple_ids))
+        {
+            for (const auto &tuple : selectWhere(conditions))
+            {
+                tuple_ids.push_back(tuple.id);
+            }
+        }
+        return true;
+    }
+
+    vector<IndexInfo> Table::listIndexes() const
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        vector<IndexInfo> result;
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            result.push_back({index_name, table_index.index->getType(), table_index.columns,
+                              table_index.include_columns, table_index.predicate, table_index.index->size()});
+        }
+        return result;
+    }
+
+    // Count the tuples in the table - the tuple directory has exactly one entry per
+    // stored row (added with every insert and load, erased with every delete), so it
+    // doubles as the table's row counter and no page has to be read
+    size_t Table::getTupleCount() const
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        return tuple_directory.size();
+    }
+
+    // Render conditions the way they are written in SQL (e.g. "status = 'open' AND amount > 100")
+    static string conditionsToString(const vector<Condition> &conditions)
+    {
+        static const char *const OP_SYMBOLS[] = {"=", "<", "<=", ">", ">="};
+        string text;
+        for (const auto &condition : conditions)
+        {
+            text += (text.empty() ? "" : " AND ") + condition.column + " " +
+                    OP_SYMBOLS[static_cast<int>(condition.op)] + " ";
+            visit([&](const auto &v)
+                  {
+                using T = decay_t<decltype(v)>;
+                if constexpr (is_same_v<T, string>) {
+                    text += "'" + v + "'";
+                } else if constexpr (is_same_v<T, bool>) {
+                    text += v ? "true" : "false";
+                } else {
+                    text += to_string(v);
+                } }, condition.value);
+        }
+        return text;
+    }
+
+    // Print table statistics for debugging and monitoring
+    // Shows table name, tuple count, columns, and available indexes
+    void Table::printStats() const
+    {
+        lock_guard<recursive_mutex> latch(table_latch);
+        cout << "Table: " << name << endl;
+        cout << "  Tuple count: " << getTupleCount() << endl;
+        cout << "  Columns: ";
+        for (const auto &column : schema.columns)
+        {
+            cout << column.name << " ";
+        }
+        cout << endl;
+        cout << "  Indexes: ";
+        for (const auto &[index_name, table_index] : indexes)
+        {
+            cout << index_name << "(" << indexTypeName(table_index.index->getType());
+            if (!table_index.include_columns.empty())
+            {
+                cout << " INCLUDE";
+                for (const auto &column : table_index.include_columns)
+                {
+                    cout << " " << column;
+                }
+            }
+            if (!table_index.predicate.empty())
+            {
+                cout << " WHERE " << conditionsToString(table_index.predicate);
+            }
+            cout << ") ";
+        }
+        cout << endl;
+    }
+
+    // StorageEngine implementation - manages multiple database tables
+
+    // Constructor - initialize storage engine with database file path
+    // Creates storage system that can manage multiple tables
+    StorageEngine::StorageEngine(const string &db_file_path)
+        : db_file_path(db_file_path)
+    {
+    }
+
+    // Create new table with specified name and schema
+    // Returns false if table already exists, true on success
+    bool StorageEngine::createTable(const string &name, const Schema &schema)
+    {
+        if (tables.find(name) != tables.end())
+        {
+            return false; // Table already exists
+        }
+
+        // Create table-specific file path to avoid storage conflicts
+        string table_file_path = db_file_path + "." + name;
+
+        // Create new table instance and add to storage engine
+        tables[name] = make_unique<Table>(name, schema, table_file_path);
+        return true;
+    }
+
+    // Drop (delete) table by name - removes table and all its data
+    // Returns false if table doesn't exist, true on successful deletion
+    bool StorageEngine::dropTable(const string &name)
+    {
+        auto it = tables.find(name);
+        if (it == tables.end())
+        {
+            return false; // Table doesn't exist
+        }
+
+        tables.erase(it); // Remove from table map
+        return true;
+    }
+
+    // Get table pointer by name for internal operations
+    // Returns nullptr if table doesn't exist
+    Table *StorageEngine::getTable(const string &name)
+    {
+        auto it = tables.find(name);
+        return it != tables.end() ? it->second.get() : nullptr;
+    }
+
+    // Insert tuple into specified table - delegates to table's insert method
+    // Returns false if table doesn't exist or insert fails
+    bool StorageEngine::insertTuple(const string &table_name, const Tuple &tuple)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return false; // Table not found
+        }
+
+        return table->insertTuple(tuple); // Delegate to table
+    }
+
+    // Select all tuples from specified table
+    // Returns empty vector if table doesn't exist
+    vector<Tuple> StorageEngine::selectAll(const string &table_name)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return {}; // Table not found
+        }
+
+        return table->selectAll(); // Delegate to table
+    }
+
+    // Select tuples matching WHERE condition from specified table
+    // Uses indexed lookup if available, otherwise full table scan
+    vector<Tuple> StorageEngine::selectWhere(const string &table_name,
+                                             const string &column, const Value &value)
     {
         auto table = getTable(table_name);
         if (!table)
@@ -676,9 +2330,37 @@ namespace db
         return table->selectWhere(column, value); // Delegate to table
     }
 
-    // Create B-tree index on specified column of specified table
-    // Enables fast O(log n) lookups on indexed column
-    bool StorageEngine::createIndex(const string &table_name, const string &column_name)
+    // Select tuples matching every condition from specified table
+    vector<Tuple> StorageEngine::selectWhere(const string &table_name, const vector<Condition> &conditions,
+                                             const CompiledPredicate *filter)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return {}; // Table not found
+        }
+
+        return table->selectWhere(conditions, filter); // Delegate to table
+    }
+
+    // Select some columns of matching rows from specified table
+    vector<Tuple> StorageEngine::selectColumns(const string &table_name, const vector<string> &columns,
+                                               const vector<Condition> &conditions,
+                                               const CompiledPredicate *filter)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return {}; // Table not found
+        }
+
+        return table->selectColumns(columns, conditions, filter); // Delegate to table
+    }
+
+    // Create an index (B-tree or hash) on specified column of specified table
+    // Enables fast lookups on indexed column
+    bool StorageEngine::createIndex(const string &table_name, const string &column_name,
+                                    IndexType type)
     {
         auto table = getTable(table_name);
         if (!table)
@@ -686,8 +2368,58 @@ namespace db
             return false; // Table not found
         }
 
-        table->createIndex(column_name); // Delegate to table
-        return true;
+        return table->createIndex(column_name, type); // Delegate to table
+    }
+
+    // Create a composite index over several columns of specified table
+    bool StorageEngine::createIndex(const string &table_name, const vector<string> &column_names,
+                                    IndexType type, const vector<string> &include_columns,
+                                    const vector<Condition> &predicate)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return false; // Table not found
+        }
+
+        return table->createIndex(column_names, type, include_columns, predicate); // Delegate to table
+    }
+
+    // Drop an index from specified table
+    bool StorageEngine::dropIndex(const string &table_name, const string &index_name)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return false; // Table not found
+        }
+
+        return table->dropIndex(index_name); // Delegate to table
+    }
+
+    // Delete tuple from specified table - index entries are removed with it
+    bool StorageEngine::deleteTuple(const string &table_name, TupleId tuple_id)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return false; // Table not found
+        }
+
+        return table->deleteTuple(tuple_id); // Delegate to table
+    }
+
+    // Update tuple in specified table - indexes are updated with it
+    bool StorageEngine::updateTuple(const string &table_name, TupleId tuple_id,
+                                    const vector<Value> &new_values)
+    {
+        auto table = getTable(table_name);
+        if (!table)
+        {
+            return false; // Table not found
+        }
+
+        return table->updateTuple(tuple_id, new_values); // Delegate to table
     }
 
     // Get list of all table names in the database
@@ -726,4 +2458,13 @@ namespace db
         }
     }
 
+    // Write index snapshot files for every table so a restart can skip the index rebuild
+    void StorageEngine::writeIndexSnapshots()
+    {
+        for (const auto &[name, table] : tables)
+        {
+            table->writeIndexSnapshots();
+        }
+    }
+
 } // namespace db
\ No newline at end of file